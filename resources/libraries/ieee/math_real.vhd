@@ -0,0 +1,53 @@
+-- Lambila | math_real.vhd
+-- Copyright (c) 2025 L. Sartory
+-- SPDX-License-Identifier: MIT
+--
+-- Declarations of IEEE.MATH_REAL summarized into ieee.lib, the bodies are not needed
+
+package math_real is
+    constant math_e : real := 2.71828182845904523536;
+    constant math_1_over_e : real := 0.36787944117144232160;
+    constant math_pi : real := 3.14159265358979323846;
+    constant math_2_pi : real := 6.28318530717958647693;
+    constant math_1_over_pi : real := 0.31830988618379067154;
+    constant math_pi_over_2 : real := 1.57079632679489661923;
+    constant math_pi_over_3 : real := 1.04719755119659774615;
+    constant math_pi_over_4 : real := 0.78539816339744830962;
+    constant math_3_pi_over_2 : real := 4.71238898038468985769;
+    constant math_log_of_2 : real := 0.69314718055994530942;
+    constant math_log_of_10 : real := 2.30258509299404568402;
+    constant math_log2_of_e : real := 1.44269504088896340736;
+    constant math_log10_of_e : real := 0.43429448190325182765;
+    constant math_sqrt_2 : real := 1.41421356237309504880;
+    constant math_1_over_sqrt_2 : real := 0.70710678118654752440;
+    constant math_sqrt_pi : real := 1.77245385090551602730;
+    constant math_deg_to_rad : real := 0.01745329251994329577;
+    constant math_rad_to_deg : real := 57.29577951308232087680;
+
+    function sign (x : real) return real;
+    function ceil (x : real) return real;
+    function floor (x : real) return real;
+    function round (x : real) return real;
+    function trunc (x : real) return real;
+    function realmax (x, y : real) return real;
+    function realmin (x, y : real) return real;
+    procedure uniform (variable seed1, seed2 : inout positive; variable x : out real);
+
+    function sqrt (x : real) return real;
+    function cbrt (x : real) return real;
+    function exp (x : real) return real;
+    function log (x : real) return real;
+    function log2 (x : real) return real;
+    function log10 (x : real) return real;
+    function log (x : real; base : real) return real;
+    function sin (x : real) return real;
+    function cos (x : real) return real;
+    function tan (x : real) return real;
+    function arcsin (x : real) return real;
+    function arccos (x : real) return real;
+    function arctan (y : real) return real;
+    function arctan (y : real; x : real) return real;
+    function sinh (x : real) return real;
+    function cosh (x : real) return real;
+    function tanh (x : real) return real;
+end package math_real;
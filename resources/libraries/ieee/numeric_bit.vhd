@@ -0,0 +1,27 @@
+-- Lambila | numeric_bit.vhd
+-- Copyright (c) 2025 L. Sartory
+-- SPDX-License-Identifier: MIT
+--
+-- Declarations of IEEE.NUMERIC_BIT summarized into ieee.lib, the bodies are not needed
+
+package numeric_bit is
+    type unsigned is array (natural range <>) of bit;
+    type signed is array (natural range <>) of bit;
+
+    function to_integer (arg : unsigned) return natural;
+    function to_integer (arg : signed) return integer;
+    function to_unsigned (arg, size : natural) return unsigned;
+    function to_signed (arg : integer; size : natural) return signed;
+
+    function resize (arg : signed; new_size : natural) return signed;
+    function resize (arg : unsigned; new_size : natural) return unsigned;
+    function shift_left (arg : unsigned; count : natural) return unsigned;
+    function shift_right (arg : unsigned; count : natural) return unsigned;
+    function shift_left (arg : signed; count : natural) return signed;
+    function shift_right (arg : signed; count : natural) return signed;
+    function rotate_left (arg : unsigned; count : natural) return unsigned;
+    function rotate_right (arg : unsigned; count : natural) return unsigned;
+
+    function rising_edge (signal s : bit) return boolean;
+    function falling_edge (signal s : bit) return boolean;
+end package numeric_bit;
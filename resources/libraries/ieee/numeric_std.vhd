@@ -0,0 +1,35 @@
+-- Lambila | numeric_std.vhd
+-- Copyright (c) 2025 L. Sartory
+-- SPDX-License-Identifier: MIT
+--
+-- Declarations of IEEE.NUMERIC_STD summarized into ieee.lib, the bodies are not needed
+
+library ieee;
+use ieee.std_logic_1164.all;
+
+package numeric_std is
+    type unsigned is array (natural range <>) of std_logic;
+    type signed is array (natural range <>) of std_logic;
+
+    function to_integer (arg : unsigned) return natural;
+    function to_integer (arg : signed) return integer;
+    function to_unsigned (arg, size : natural) return unsigned;
+    function to_signed (arg : integer; size : natural) return signed;
+
+    function resize (arg : signed; new_size : natural) return signed;
+    function resize (arg : unsigned; new_size : natural) return unsigned;
+    function shift_left (arg : unsigned; count : natural) return unsigned;
+    function shift_right (arg : unsigned; count : natural) return unsigned;
+    function shift_left (arg : signed; count : natural) return signed;
+    function shift_right (arg : signed; count : natural) return signed;
+    function rotate_left (arg : unsigned; count : natural) return unsigned;
+    function rotate_right (arg : unsigned; count : natural) return unsigned;
+    function rotate_left (arg : signed; count : natural) return signed;
+    function rotate_right (arg : signed; count : natural) return signed;
+
+    function std_match (l, r : std_ulogic) return boolean;
+    function std_match (l, r : unsigned) return boolean;
+    function std_match (l, r : signed) return boolean;
+    function to_01 (s : unsigned; xmap : std_logic := '0') return unsigned;
+    function to_01 (s : signed; xmap : std_logic := '0') return signed;
+end package numeric_std;
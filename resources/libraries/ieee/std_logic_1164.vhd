@@ -0,0 +1,28 @@
+-- Lambila | std_logic_1164.vhd
+-- Copyright (c) 2025 L. Sartory
+-- SPDX-License-Identifier: MIT
+--
+-- Declarations of IEEE.STD_LOGIC_1164 summarized into ieee.lib, the bodies are not needed
+
+package std_logic_1164 is
+    type std_ulogic is ('U', 'X', '0', '1', 'Z', 'W', 'L', 'H', '-');
+    type std_ulogic_vector is array (natural range <>) of std_ulogic;
+
+    function resolved (s : std_ulogic_vector) return std_ulogic;
+    subtype std_logic is resolved std_ulogic;
+    type std_logic_vector is array (natural range <>) of std_logic;
+
+    function to_bit (s : std_ulogic; xmap : bit := '0') return bit;
+    function to_bitvector (s : std_logic_vector; xmap : bit := '0') return bit_vector;
+    function to_stdulogic (b : bit) return std_ulogic;
+    function to_stdlogicvector (b : bit_vector) return std_logic_vector;
+    function to_stdulogicvector (b : bit_vector) return std_ulogic_vector;
+    function to_x01 (s : std_ulogic) return std_ulogic;
+    function to_x01z (s : std_ulogic) return std_ulogic;
+    function to_ux01 (s : std_ulogic) return std_ulogic;
+
+    function rising_edge (signal s : std_ulogic) return boolean;
+    function falling_edge (signal s : std_ulogic) return boolean;
+    function is_x (s : std_ulogic) return boolean;
+    function is_x (s : std_logic_vector) return boolean;
+end package std_logic_1164;
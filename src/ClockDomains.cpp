@@ -0,0 +1,127 @@
+/* Lambila | ClockDomains.cpp
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#include "ClockDomains.h"
+
+/******************************************************************************/
+
+// Follow a clock upstream while it has a single driver that is a port or a signal
+int ClockDomains::root(const Connectivity &connectivity, int node)
+{
+    QSet<int> visited { node };
+    for (;;)
+    {
+        const Connectivity::Edges drivers = connectivity.fanin(node);
+        if (drivers.count() != 1)
+            return node;
+        const int driver = *drivers.begin();
+        if (connectivity.getNodes().at(driver).kind == Connectivity::Kind::Statement || visited.contains(driver))
+            return node;
+        visited.insert(driver);
+        node = driver;
+    }
+}
+
+void ClockDomains::build(Design *design, const Connectivity &connectivity)
+{
+    clear();
+    _nodeDomains = QList<QList<int>>(connectivity.getNodes().count());
+
+    // Registers, grouped by the root of their clock
+    for (auto entity : design->getEntities())
+        for (auto architecture : entity->getArchitectures())
+        {
+            const QString scope = QString("%1(%2)").arg(entity->name()).arg(architecture->name());
+            for (const Process &process : architecture->getProcesses())
+            {
+                if (process.clocks.isEmpty() || process.assignment == -1)
+                    continue;
+                const int statement = connectivity.node(QString("%1#%2").arg(scope).arg(process.assignment));
+                // Ports and signals are the only names that are connected
+                const QString &signal = process.clocks.first().signal;
+                int clock = connectivity.node(QString("%1.%2").arg(scope).arg(signal));
+                if (clock == -1)
+                    clock = connectivity.node(QString("%1.%2").arg(entity->name()).arg(signal));
+                if (statement == -1 || clock == -1)
+                    continue;
+
+                clock = root(connectivity, clock);
+                if (!_clockDomains.contains(clock))
+                {
+                    _clockDomains.insert(clock, _domains.count());
+                    _domains.append(Domain { clock, { }, { } });
+                }
+                const int domain = _clockDomains.value(clock);
+                _domains[domain].registers.append(statement);
+                _registerDomains.insert(statement, domain);
+            }
+        }
+
+    // Outputs of the registers, down to the next registers
+    for (int domain = 0; domain < _domains.count(); ++domain)
+    {
+        QList<int> &driven = _domains[domain].driven;
+        for (int statement : _domains.at(domain).registers)
+            for (int target : connectivity.fanout(statement))
+                if (!_nodeDomains.at(target).contains(domain))
+                {
+                    _nodeDomains[target].append(domain);
+                    driven.append(target);
+                }
+        for (int i = 0; i < driven.count(); ++i)
+            for (int next : connectivity.fanout(driven.at(i)))
+            {
+                if (_registerDomains.contains(next) || _nodeDomains.at(next).contains(domain))
+                    continue;
+                _nodeDomains[next].append(domain);
+                driven.append(next);
+            }
+    }
+
+    for (auto it = _registerDomains.cbegin(); it != _registerDomains.cend(); ++it)
+        for (int source : connectivity.fanin(it.key()))
+            for (int domain : _nodeDomains.at(source))
+                if (domain != it.value())
+                    _crossings.append(Crossing { source, domain, it.value() });
+    Logger::debug(QString("clock domains: %1 domains, %2 crossings").arg(_domains.count()).arg(_crossings.count()));
+}
+
+void ClockDomains::clear()
+{
+    _domains.clear();
+    _clockDomains.clear();
+    _nodeDomains.clear();
+    _registerDomains.clear();
+    _crossings.clear();
+}
+
+/******************************************************************************/
+
+const QList<ClockDomains::Domain> &ClockDomains::domains() const
+{
+    return _domains;
+}
+
+int ClockDomains::clockDomain(int clock) const
+{
+    return _clockDomains.value(clock, -1);
+}
+
+int ClockDomains::registerDomain(int statement) const
+{
+    return _registerDomains.value(statement, -1);
+}
+
+QList<int> ClockDomains::domainsOf(int node) const
+{
+    return _nodeDomains.value(node);
+}
+
+const QList<ClockDomains::Crossing> &ClockDomains::crossings() const
+{
+    return _crossings;
+}
@@ -0,0 +1,69 @@
+/* Lambila | ClockDomains.h
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#ifndef CLOCKDOMAINS_H
+#define CLOCKDOMAINS_H
+
+/******************************************************************************/
+
+#include "Connectivity.h"
+#include "Design.h"
+
+/******************************************************************************/
+
+// Clock domains of the design, indexed on the nodes of the connectivity graph.
+// A domain is named after the node its clock comes from: the clock of a process is followed upstream through plain
+// wires, port maps and signals, until it is driven by a statement or by several nodes. The registers of a domain are
+// the clocked processes, the signals they drive are followed downstream through the combinational statements, so
+// that a signal read by a clocked process of another domain is a crossing.
+// Like the connectivity, domains are computed per entity, not per instance.
+class ClockDomains
+{
+public:
+    struct Domain {
+        // Node of the clock in the connectivity graph
+        int clock;
+        // Statement nodes of the clocked processes
+        QList<int> registers;
+        // Nodes driven by these registers, directly or through combinational statements
+        QList<int> driven;
+    };
+
+    struct Crossing {
+        // Node read by a register of the destination domain
+        int node;
+        int source;
+        int destination;
+    };
+
+protected:
+    QList<Domain> _domains;
+    QHash<int, int> _clockDomains;
+    // Domains driving each node, indexed like the nodes of the connectivity graph
+    QList<QList<int>> _nodeDomains;
+    QHash<int, int> _registerDomains;
+    QList<Crossing> _crossings;
+
+    static int root(const Connectivity &connectivity, int node);
+
+public:
+    void build(Design *design, const Connectivity &connectivity);
+    void clear();
+
+    const QList<Domain> &domains() const;
+    // Domain of a clock or of a register, -1 if there is none
+    int clockDomain(int clock) const;
+    int registerDomain(int statement) const;
+    // Domains whose registers drive a node
+    QList<int> domainsOf(int node) const;
+
+    const QList<Crossing> &crossings() const;
+};
+
+/******************************************************************************/
+
+#endif // CLOCKDOMAINS_H
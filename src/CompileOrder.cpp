@@ -0,0 +1,252 @@
+/* Lambila | CompileOrder.cpp
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#include "CompileOrder.h"
+
+#include <QFileInfo>
+#include <algorithm>
+
+/******************************************************************************/
+
+CompileOrder::CompileOrder(Design *design, const UnitGraph &unitGraph, const QList<FileId> &files)
+{
+    _design = design;
+    _files = files;
+
+    // Dependencies between units become dependencies between their files
+    const QList<UnitGraph::Unit> &units = unitGraph.getUnits();
+    for (int unit = 0; unit < units.count(); ++unit)
+        for (int dependency : unitGraph.dependencies(unit))
+            addDependency(units.at(unit).file, units.at(dependency).file);
+
+    sortLevels();
+}
+
+/******************************************************************************/
+
+void CompileOrder::addDependency(FileId file, FileId dependency)
+{
+    if (file == INVALID_FILE_ID || dependency == INVALID_FILE_ID || file == dependency)
+        return;
+    QList<FileId> &dependencies = _dependencies[file];
+    if (!dependencies.contains(dependency))
+        dependencies.append(dependency);
+}
+
+// Tarjan's algorithm, without recursion so that long dependency chains cannot overflow the stack.
+// Strongly connected components come out dependencies first, which gives the levels directly.
+void CompileOrder::sortLevels()
+{
+    QHash<FileId, int> nodes;
+    for (int i = 0; i < _files.count(); ++i)
+        nodes.insert(_files.at(i), i);
+
+    QList<int> index(_files.count(), -1);
+    QList<int> lowLink(_files.count(), 0);
+    QList<int> level(_files.count(), 0);
+    QList<bool> onStack(_files.count(), false);
+    QList<int> stack;
+    int counter = 0;
+
+    struct Frame {
+        int node;
+        int edge;
+    };
+    QList<Frame> frames;
+    const auto visit = [&](int node) {
+        index[node] = lowLink[node] = counter++;
+        stack.append(node);
+        onStack[node] = true;
+        frames.append(Frame { node, 0 });
+    };
+
+    for (int root = 0; root < _files.count(); ++root)
+    {
+        if (index.at(root) != -1)
+            continue;
+        visit(root);
+        while (!frames.isEmpty())
+        {
+            const int node = frames.last().node;
+            const QList<FileId> &dependencies = this->dependencies(_files.at(node));
+            if (frames.last().edge < dependencies.count())
+            {
+                // Files that are not part of the list are ignored
+                const int next = nodes.value(dependencies.at(frames.last().edge++), -1);
+                if (next == -1)
+                    continue;
+                if (index.at(next) == -1)
+                    visit(next);
+                else if (onStack.at(next))
+                    lowLink[node] = qMin(lowLink.at(node), index.at(next));
+                continue;
+            }
+            frames.removeLast();
+            if (!frames.isEmpty())
+                lowLink[frames.last().node] = qMin(lowLink.at(frames.last().node), lowLink.at(node));
+            if (lowLink.at(node) != index.at(node))
+                continue;
+
+            // All the dependencies outside of the component already have their level
+            QList<int> component;
+            do
+            {
+                component.append(stack.takeLast());
+                onStack[component.last()] = false;
+            } while (component.last() != node);
+            int componentLevel = 0;
+            for (int member : component)
+                for (FileId dependency : this->dependencies(_files.at(member)))
+                {
+                    const int other = nodes.value(dependency, -1);
+                    if (other != -1 && !component.contains(other))
+                        componentLevel = qMax(componentLevel, level.at(other) + 1);
+                }
+            for (int member : component)
+                level[member] = componentLevel;
+
+            if (component.count() > 1)
+            {
+                std::sort(component.begin(), component.end());
+                QList<FileId> cycle;
+                for (int member : component)
+                    cycle.append(_files.at(member));
+                _cycles.append(cycle);
+            }
+        }
+    }
+
+    // Keep the original order within each level
+    for (int i = 0; i < _files.count(); ++i)
+    {
+        while (_levels.count() <= level.at(i))
+            _levels.append(QList<FileId>());
+        _levels[level.at(i)].append(_files.at(i));
+    }
+}
+
+/******************************************************************************/
+
+const QList<FileId> &CompileOrder::dependencies(FileId file) const
+{
+    static const QList<FileId> none;
+    const auto it = _dependencies.constFind(file);
+    return (it != _dependencies.cend()) ? *it : none;
+}
+
+const QList<QList<FileId>> &CompileOrder::levels() const
+{
+    return _levels;
+}
+
+const QList<QList<FileId>> &CompileOrder::cycles() const
+{
+    return _cycles;
+}
+
+/******************************************************************************/
+
+QString CompileOrder::stampName(FileId file) const
+{
+    return QString("%1_%2.stamp").arg(file).arg(QFileInfo(_design->getFiles().at(file).path).completeBaseName());
+}
+
+static QString makeEscape(QString path)
+{
+    return path.replace('$', "$$").replace(' ', "\\ ");
+}
+
+static QString ninjaEscape(QString path)
+{
+    return path.replace('$', "$$").replace(' ', "$ ").replace(':', "$:");
+}
+
+// One file per line, dependencies first
+QString CompileOrder::fileList() const
+{
+    QString text;
+    for (const auto &files : _levels)
+        for (FileId file : files)
+            text += _design->getFiles().at(file).path + '\n';
+    return text;
+}
+
+// Each file is analyzed once the files it depends on are, so that "make -j" can run them in parallel
+QString CompileOrder::makefile() const
+{
+    QString text;
+    text += "# Compile order generated by Lambila\n";
+    for (const auto &cycle : _cycles)
+    {
+        text += "# Circular dependency between:";
+        for (FileId file : cycle)
+            text += ' ' + makeEscape(_design->getFiles().at(file).path);
+        text += '\n';
+    }
+    text += "LAMBILA_COMPILE ?= ghdl -a\n";
+    text += "LAMBILA_STAMP_DIR ?= .lambila\n\n";
+
+    QStringList stamps;
+    for (int level = 0; level < _levels.count(); ++level)
+    {
+        text += QString("# Level %1\n").arg(level);
+        for (FileId file : _levels.at(level))
+        {
+            const QString stamp = QString("$(LAMBILA_STAMP_DIR)/%1").arg(makeEscape(stampName(file)));
+            stamps.append(stamp);
+            text += QString("%1: %2").arg(stamp).arg(makeEscape(_design->getFiles().at(file).path));
+            // Files of a cycle cannot wait for each other
+            for (FileId dependency : dependencies(file))
+                if (_files.contains(dependency) && !_levels.at(level).contains(dependency))
+                    text += QString(" $(LAMBILA_STAMP_DIR)/%1").arg(makeEscape(stampName(dependency)));
+            text += "\n\t@mkdir -p $(LAMBILA_STAMP_DIR)\n\t$(LAMBILA_COMPILE) $<\n\t@touch $@\n";
+        }
+        text += '\n';
+    }
+    text += QString(".PHONY: lambila_compile\nlambila_compile: %1\n").arg(stamps.join(' '));
+    return text;
+}
+
+QString CompileOrder::ninja() const
+{
+    QString text;
+    text += "# Compile order generated by Lambila\n";
+    for (const auto &cycle : _cycles)
+    {
+        text += "# Circular dependency between:";
+        for (FileId file : cycle)
+            text += ' ' + ninjaEscape(_design->getFiles().at(file).path);
+        text += '\n';
+    }
+    text += "lambila_compile = ghdl -a\n";
+    text += "lambila_stamp_dir = .lambila\n\n";
+    text += "rule lambila_analyze\n";
+    text += "  command = mkdir -p $lambila_stamp_dir && $lambila_compile $in && touch $out\n";
+    text += "  description = Analyzing $in\n\n";
+
+    QStringList stamps;
+    for (int level = 0; level < _levels.count(); ++level)
+    {
+        text += QString("# Level %1\n").arg(level);
+        for (FileId file : _levels.at(level))
+        {
+            const QString stamp = QString("$lambila_stamp_dir/%1").arg(ninjaEscape(stampName(file)));
+            stamps.append(stamp);
+            text += QString("build %1: lambila_analyze %2").arg(stamp).arg(ninjaEscape(_design->getFiles().at(file).path));
+            QStringList implicit;
+            for (FileId dependency : dependencies(file))
+                if (_files.contains(dependency) && !_levels.at(level).contains(dependency))
+                    implicit.append(QString("$lambila_stamp_dir/%1").arg(ninjaEscape(stampName(dependency))));
+            if (!implicit.isEmpty())
+                text += " | " + implicit.join(' ');
+            text += '\n';
+        }
+        text += '\n';
+    }
+    text += QString("build lambila_compile: phony %1\n").arg(stamps.join(' '));
+    return text;
+}
@@ -0,0 +1,50 @@
+/* Lambila | CompileOrder.h
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#ifndef COMPILEORDER_H
+#define COMPILEORDER_H
+
+/******************************************************************************/
+
+#include "Design.h"
+#include "UnitGraph.h"
+
+/******************************************************************************/
+
+// Order in which the files of a design have to be analyzed by external tools.
+// A file depends on the files of the units its own units depend on. Files of the same level do not depend on each other.
+class CompileOrder
+{
+protected:
+    Design *_design;
+    QList<FileId> _files;
+    QHash<FileId, QList<FileId>> _dependencies;
+    QList<QList<FileId>> _levels;
+    QList<QList<FileId>> _cycles;
+
+    void addDependency(FileId file, FileId dependency);
+    void sortLevels();
+
+    QString stampName(FileId file) const;
+
+public:
+    // Files are kept in the given order within each level
+    CompileOrder(Design *design, const UnitGraph &unitGraph, const QList<FileId> &files);
+
+    const QList<FileId> &dependencies(FileId file) const;
+    const QList<QList<FileId>> &levels() const;
+    const QList<QList<FileId>> &cycles() const;
+
+    // Export formats
+    QString fileList() const;
+    QString makefile() const;
+    QString ninja() const;
+};
+
+/******************************************************************************/
+
+#endif // COMPILEORDER_H
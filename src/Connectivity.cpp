@@ -0,0 +1,179 @@
+/* Lambila | Connectivity.cpp
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#include "Connectivity.h"
+
+#include <algorithm>
+
+/******************************************************************************/
+
+int Connectivity::addNode(Kind kind, const QString &name, const Location &location)
+{
+    _nodes.append(Node { kind, name, location });
+    _nodeIds.insert(name.toLower(), _nodes.count() - 1);
+    return _nodes.count() - 1;
+}
+
+// Sort the edges by source, then store the targets of each source contiguously
+void Connectivity::compress(QList<QPair<int, int>> &edges, QList<int> &offsets, QList<int> &targets)
+{
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    offsets = QList<int>(_nodes.count() + 1, 0);
+    targets.clear();
+    targets.reserve(edges.count());
+    for (const auto &edge : edges)
+    {
+        offsets[edge.first + 1] += 1;
+        targets.append(edge.second);
+    }
+    for (int node = 0; node < _nodes.count(); ++node)
+        offsets[node + 1] += offsets.at(node);
+}
+
+void Connectivity::build(Design *design)
+{
+    clear();
+
+    // Ports first, so that the port maps of any architecture can refer to them
+    QHash<Entity *, QHash<QString, PortNode>> portNodes;
+    for (auto entity : design->getEntities())
+    {
+        QHash<QString, PortNode> &ports = portNodes[entity];
+        for (const QString &name : entity->portNames())
+        {
+            Port *port = entity->port(name);
+            ports.insert(name.toLower(), PortNode { addNode(Kind::Port, QString("%1.%2").arg(entity->name()).arg(name), port->location), port });
+        }
+    }
+
+    QList<QPair<int, int>> edges;
+    for (auto entity : design->getEntities())
+        for (auto architecture : entity->getArchitectures())
+        {
+            // Names visible in the architecture, VHDL identifiers are case insensitive
+            const QString scope = QString("%1(%2)").arg(entity->name()).arg(architecture->name());
+            const QHash<QString, PortNode> &entityPorts = portNodes[entity];
+            QHash<QString, int> names;
+            for (auto it = entityPorts.cbegin(); it != entityPorts.cend(); ++it)
+                names.insert(it.key(), it.value().node);
+            for (auto it = architecture->getSignals().cbegin(); it != architecture->getSignals().cend(); ++it)
+                names.insert(it.key().toLower(), addNode(Kind::Signal, QString("%1.%2").arg(scope).arg(it.key()), it.value()->location));
+
+            // Names that are not signals nor ports, such as constants and functions, are not connected
+            for (int i = 0; i < architecture->getAssignments().count(); ++i)
+            {
+                const Assignment &assignment = architecture->getAssignments().at(i);
+                const int statement = addNode(Kind::Statement, QString("%1#%2").arg(scope).arg(i), assignment.location);
+                for (const QString &source : assignment.sources)
+                    if (names.contains(source))
+                        edges.append(qMakePair(names.value(source), statement));
+                for (const QString &target : assignment.targets)
+                    if (names.contains(target))
+                        edges.append(qMakePair(statement, names.value(target)));
+            }
+
+            for (auto instance : architecture->getInstances())
+            {
+                Entity *instantiated = design->entity(instance->unit);
+                if (instantiated == nullptr)
+                    continue;
+                const QHash<QString, PortNode> &ports = portNodes[instantiated];
+                for (int i = 0; i < instance->portMap.count(); ++i)
+                {
+                    // Positional associations follow the declaration order of the ports
+                    const Association &association = instance->portMap.at(i);
+                    const QString formal = association.formal.isEmpty() ? instantiated->portNames().value(i) : association.formal.section('(', 0, 0);
+                    const PortNode port = ports.value(formal.trimmed().toLower(), PortNode { -1, nullptr });
+                    if (port.node == -1)
+                        continue;
+                    const QString direction = port.port->direction.toLower();
+                    const bool input = (direction != "out" && direction != "output" && direction != "buffer");
+                    const bool output = (direction != "in" && direction != "input");
+                    for (const QString &name : association.names)
+                    {
+                        if (!names.contains(name))
+                            continue;
+                        if (input)
+                            edges.append(qMakePair(names.value(name), port.node));
+                        if (output)
+                            edges.append(qMakePair(port.node, names.value(name)));
+                    }
+                }
+            }
+        }
+
+    compress(edges, _fanoutOffsets, _fanoutTargets);
+    for (auto &edge : edges)
+        edge = qMakePair(edge.second, edge.first);
+    compress(edges, _faninOffsets, _faninSources);
+    Logger::debug(QString("connectivity: %1 nodes, %2 edges").arg(_nodes.count()).arg(_fanoutTargets.count()));
+}
+
+void Connectivity::clear()
+{
+    _nodes.clear();
+    _nodeIds.clear();
+    _fanoutOffsets.clear();
+    _fanoutTargets.clear();
+    _faninOffsets.clear();
+    _faninSources.clear();
+}
+
+/******************************************************************************/
+
+const QList<Connectivity::Node> &Connectivity::getNodes() const
+{
+    return _nodes;
+}
+
+int Connectivity::node(const QString &name) const
+{
+    return _nodeIds.value(name.trimmed().toLower(), -1);
+}
+
+Connectivity::Edges Connectivity::fanout(int node) const
+{
+    const int *targets = _fanoutTargets.constData();
+    return Edges { targets + _fanoutOffsets.at(node), targets + _fanoutOffsets.at(node + 1) };
+}
+
+Connectivity::Edges Connectivity::fanin(int node) const
+{
+    const int *sources = _faninSources.constData();
+    return Edges { sources + _faninOffsets.at(node), sources + _faninOffsets.at(node + 1) };
+}
+
+/******************************************************************************/
+
+QList<int> Connectivity::reachable(int node, bool downstream, int maxDepth) const
+{
+    QList<int> reached;
+    if (node < 0 || node >= _nodes.count())
+        return reached;
+
+    // Breadth-first walk, the depth of each node also marks it as visited
+    QList<int> depths(_nodes.count(), -1);
+    depths[node] = 0;
+    reached.append(node);
+    for (int i = 0; i < reached.count(); ++i)
+    {
+        const int current = reached.at(i);
+        if (maxDepth >= 0 && depths.at(current) >= maxDepth)
+            continue;
+        for (int next : downstream ? fanout(current) : fanin(current))
+        {
+            if (depths.at(next) != -1)
+                continue;
+            depths[next] = depths.at(current) + 1;
+            reached.append(next);
+        }
+    }
+    reached.removeFirst();
+    return reached;
+}
@@ -0,0 +1,92 @@
+/* Lambila | Connectivity.h
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#ifndef CONNECTIVITY_H
+#define CONNECTIVITY_H
+
+/******************************************************************************/
+
+#include "Design.h"
+
+/******************************************************************************/
+
+// Directed graph of the ports and signals of the design, from the drivers to the readers.
+// Port maps connect the signals of an architecture to the ports of the instantiated entity, assignments connect
+// their sources to their targets through a statement node. All the instances of an entity share the nodes of its
+// ports, so walking up the hierarchy reaches every place where the entity is instantiated.
+// The edges are stored in compressed sparse rows, built once after each refresh.
+class Connectivity
+{
+public:
+    enum class Kind {
+        Port,
+        Signal,
+        Statement
+    };
+
+    struct Node {
+        Kind kind;
+        QString name;
+        Location location;
+    };
+
+    // Edges of a node, contiguous in the CSR arrays
+    struct Edges {
+        const int *first;
+        const int *last;
+
+        const int *begin() const
+        {
+            return first;
+        }
+        const int *end() const
+        {
+            return last;
+        }
+        int count() const
+        {
+            return last - first;
+        }
+    };
+
+protected:
+    struct PortNode {
+        int node;
+        Port *port;
+    };
+
+    QList<Node> _nodes;
+    QHash<QString, int> _nodeIds;
+
+    // The edges of node n are at [offsets[n], offsets[n + 1]) in the target arrays
+    QList<int> _fanoutOffsets;
+    QList<int> _fanoutTargets;
+    QList<int> _faninOffsets;
+    QList<int> _faninSources;
+
+    int addNode(Kind kind, const QString &name, const Location &location);
+    void compress(QList<QPair<int, int>> &edges, QList<int> &offsets, QList<int> &targets);
+
+public:
+    void build(Design *design);
+    void clear();
+
+    const QList<Node> &getNodes() const;
+    // Ports are named “library.entity.port”, signals “library.entity(architecture).signal”, case is ignored
+    int node(const QString &name) const;
+
+    Edges fanout(int node) const;
+    Edges fanin(int node) const;
+
+    // Nodes reached from a node, downstream through the readers or upstream through the drivers, nearest first.
+    // A negative depth does not limit the walk.
+    QList<int> reachable(int node, bool downstream, int maxDepth = -1) const;
+};
+
+/******************************************************************************/
+
+#endif // CONNECTIVITY_H
@@ -10,18 +10,269 @@
 
 #include "Logger.h"
 
+#include <QDateTime>
 #include <QMultiHash>
+#include <QSet>
+#include <QStringList>
+#include <algorithm>
 
 /******************************************************************************/
 
-typedef QString Signal;
-typedef QPair<QString, QString> Constant;
+// Source files are interned in the design, elements only refer to them by ID
+typedef int FileId;
+static constexpr FileId INVALID_FILE_ID = -1;
+
+struct SourceFile {
+    QString path;
+    QDateTime lastModified;
+    QList<quint32> lineOffsets;
+    // Detail of a file parsed in netlist mode, empty if it was not spilled
+    QString spillPath;
+};
+
+// Position in a source file, packed in two 32-bit words: the file ID and a character offset.
+// The line and the column are found from the line offset table of the file.
+struct Location {
+    FileId file = INVALID_FILE_ID;
+    quint32 offset = 0;
+};
+
+/******************************************************************************/
+
+// Types are interned in the design, so that comparing two types is an integer comparison
+typedef int TypeId;
+static constexpr TypeId INVALID_TYPE_ID = -1;
+
+class Type {
+public:
+    enum class Kind {
+        Unresolved,
+        Incomplete,
+        Enumeration,
+        Scalar,
+        Physical,
+        Array,
+        Record,
+        Access,
+        File,
+        Subtype
+    };
+
+protected:
+    TypeId _id;
+    TypeId _baseType;
+    TypeId _elementType;
+    QString _name;
+    Location _location;
+    Kind _kind;
+    QString _constraint;
+    QStringList _literals;
+    QList<TypeId> _fieldTypes;
+
+public:
+    Type(TypeId id, const QString &name)
+    {
+        _id = id;
+        _name = name;
+        reset();
+    }
+
+    // Turn the type back into a placeholder, keeping its ID
+    void reset()
+    {
+        _baseType = _id;
+        _elementType = INVALID_TYPE_ID;
+        _location = Location();
+        _kind = Kind::Unresolved;
+        _constraint = "";
+        _literals.clear();
+        _fieldTypes.clear();
+    }
+
+    TypeId id()
+    {
+        return _id;
+    }
+    const QString &name()
+    {
+        return _name;
+    }
+    void setName(const QString &name)
+    {
+        _name = name;
+    }
+
+    FileId file()
+    {
+        return _location.file;
+    }
+    const Location &location()
+    {
+        return _location;
+    }
+    void setLocation(const Location &location)
+    {
+        _location = location;
+    }
+
+    Kind kind()
+    {
+        return _kind;
+    }
+    void setKind(Kind kind)
+    {
+        _kind = kind;
+    }
+
+    // Subtypes share the base type of their type mark, all other types are their own base type
+    TypeId baseType()
+    {
+        return _baseType;
+    }
+    void setBaseType(TypeId baseType)
+    {
+        _baseType = baseType;
+    }
+
+    // Element type of arrays, designated type of access and file types
+    TypeId elementType()
+    {
+        return _elementType;
+    }
+    void setElementType(TypeId elementType)
+    {
+        _elementType = elementType;
+    }
+
+    // Range of scalar types and subtypes, index constraint of arrays
+    const QString &constraint()
+    {
+        return _constraint;
+    }
+    void setConstraint(const QString &constraint)
+    {
+        _constraint = constraint.trimmed();
+    }
+
+    // Enumeration literals, physical units or record fields
+    const QStringList &literals()
+    {
+        return _literals;
+    }
+    const QList<TypeId> &fieldTypes()
+    {
+        return _fieldTypes;
+    }
+    void addLiteral(const QString &literal)
+    {
+        _literals.append(literal.trimmed());
+    }
+    void addField(const QString &name, TypeId type)
+    {
+        _literals.append(name.trimmed());
+        _fieldTypes.append(type);
+    }
+};
+
+/******************************************************************************/
+
+struct Signal {
+    QString type;
+    TypeId typeId;
+    Location location;
+};
+struct Constant {
+    QString type;
+    TypeId typeId;
+    QString value;
+    Location location;
+};
+// Name declared again in the same declarative region, only the last declaration is kept
+struct Redeclaration {
+    QString name;
+    Location location;
+};
+
+// Generate statements are kept as templates, their instances are only unrolled by the elaboration
+static constexpr int NO_GENERATE = -1;
+
+struct Generate {
+    enum class Kind {
+        For,
+        If
+    };
+
+    Kind kind;
+    QString label;
+    // Loop parameter of for-generates
+    QString parameter;
+    // Discrete range of for-generates, condition of if-generates
+    QString scheme;
+    // Enclosing generate statement, NO_GENERATE at the top level of the architecture
+    int parent;
+    Location location;
+};
+// Element of a generic map or of a port map
+struct Association {
+    // Empty for positional associations
+    QString formal;
+    QString actual;
+    // Names read by the actual
+    QStringList names;
+};
+struct Instance {
+    QString unit;
+    // Innermost generate statement around the instance
+    int generate;
+    QList<Association> genericMap;
+    QList<Association> portMap;
+    Location location;
+};
+// Concurrent signal assignment, or process as a whole: every target depends on every source
+struct Assignment {
+    QStringList targets;
+    QStringList sources;
+    Location location;
+};
+// Signal whose edges trigger a process, found in its conditions
+struct Clock {
+    enum class Edge {
+        Rising,
+        Falling,
+        Any
+    };
+
+    QString signal;
+    Edge edge;
+};
+struct Process {
+    QString label;
+    // Names of the sensitivity list, in lower case, “all” for VHDL-2008 processes
+    QStringList sensitivity;
+    QList<Clock> clocks;
+    // Names assigned inside the process, in lower case
+    QStringList targets;
+    // The process as a whole is also recorded as an assignment
+    int assignment;
+    Location location;
+};
 
 class Architecture {
 protected:
     QString _name;
+    Location _location;
     QHash<QString, Constant *> _constants;
     QHash<QString, Signal *> _signals;
+    // Instances inside generate statements are named after the labels of these statements, as in “rows.columns.cell”
+    QHash<QString, Instance *> _instances;
+    QList<Generate> _generates;
+    QList<Assignment> _assignments;
+    QList<Process> _processes;
+    QList<Redeclaration> _redeclarations;
+    // Architectures parsed in netlist mode only count their signals and instances
+    bool _summarized = false;
+    qint64 _signalCount = 0;
+    QHash<QString, qint64> _instanceCounts;
 
 public:
     ~Architecture()
@@ -38,6 +289,16 @@ public:
         for (auto signal : _signals)
             delete signal;
         _signals.clear();
+        for (auto instance : _instances)
+            delete instance;
+        _instances.clear();
+        _generates.clear();
+        _assignments.clear();
+        _processes.clear();
+        _redeclarations.clear();
+        _summarized = false;
+        _signalCount = 0;
+        _instanceCounts.clear();
     }
 
     const QString &name()
@@ -49,6 +310,19 @@ public:
         _name = name.trimmed();
     }
 
+    FileId file()
+    {
+        return _location.file;
+    }
+    const Location &location()
+    {
+        return _location;
+    }
+    void setLocation(const Location &location)
+    {
+        _location = location;
+    }
+
     Constant *constant(QString name)
     {
         return _constants.value(name.trimmed(), nullptr);
@@ -57,10 +331,13 @@ public:
     {
         return _constants;
     }
-    void addConstant(const QString &name, const QString &type, const QString &value)
+    void addConstant(const QString &name, const QString &type, TypeId typeId, const QString &value, const Location &location)
     {
         Logger::debug(QString("%1 add constant: %2 | %3 | %4").arg(_name).arg(name.trimmed()).arg(type.trimmed()).arg(value.trimmed()));
-        _constants.insert(name.trimmed(), new Constant(type.trimmed(), value.trimmed()));
+        if (_constants.contains(name.trimmed()) || _signals.contains(name.trimmed()))
+            _redeclarations.append(Redeclaration { name.trimmed(), location });
+        delete _constants.take(name.trimmed());
+        _constants.insert(name.trimmed(), new Constant { type.trimmed(), typeId, value.trimmed(), location });
     }
 
     Signal *signal(QString name)
@@ -71,24 +348,153 @@ public:
     {
         return _signals;
     }
-    void addSignal(const QString &name, const QString &type)
+    void addSignal(const QString &name, const QString &type, TypeId typeId, const Location &location)
     {
         Logger::debug(QString("%1 add signal: %2 | %3").arg(_name).arg(name.trimmed()).arg(type.trimmed()));
-        _signals.insert(name.trimmed(), new Signal(type.trimmed()));
+        if (_constants.contains(name.trimmed()) || _signals.contains(name.trimmed()))
+            _redeclarations.append(Redeclaration { name.trimmed(), location });
+        delete _signals.take(name.trimmed());
+        _signals.insert(name.trimmed(), new Signal { type.trimmed(), typeId, location });
+    }
+
+    const QList<Redeclaration> &getRedeclarations()
+    {
+        return _redeclarations;
+    }
+
+    // Summarized architectures have no signal, instance, assignment or process objects
+    bool summarized()
+    {
+        return _summarized;
+    }
+    void setSummarized(bool summarized)
+    {
+        _summarized = summarized;
+    }
+    qint64 signalCount()
+    {
+        return _signals.count() + _signalCount;
+    }
+    void countSignal()
+    {
+        _signalCount += 1;
+    }
+    // Number of instances of each unit, including the instances that are only counted
+    QHash<QString, qint64> instanceCounts()
+    {
+        QHash<QString, qint64> counts = _instanceCounts;
+        for (auto instance : _instances)
+            counts[instance->unit] += 1;
+        return counts;
+    }
+    void countInstance(const QString &unit)
+    {
+        _instanceCounts[unit.trimmed()] += 1;
+    }
+
+    Instance *instance(QString name)
+    {
+        return _instances.value(name.trimmed(), nullptr);
+    }
+    const QHash<QString, Instance *> &getInstances()
+    {
+        return _instances;
+    }
+    Instance *addInstance(const QString &name, const QString &unit, const Location &location, int generate = NO_GENERATE)
+    {
+        const QString path = generatePath(generate, name.trimmed());
+        Logger::debug(QString("%1 add instance: %2 | %3").arg(_name).arg(path).arg(unit.trimmed()));
+        delete _instances.take(path);
+        Instance *instance = new Instance { unit.trimmed(), generate, { }, { }, location };
+        _instances.insert(path, instance);
+        return instance;
+    }
+
+    const QList<Assignment> &getAssignments()
+    {
+        return _assignments;
+    }
+    int addAssignment(const QStringList &targets, const QStringList &sources, const Location &location)
+    {
+        Logger::debug(QString("%1 add assignment: %2 | %3").arg(_name).arg(targets.join(' ')).arg(sources.join(' ')));
+        _assignments.append(Assignment { targets, sources, location });
+        return _assignments.count() - 1;
+    }
+
+    const QList<Process> &getProcesses()
+    {
+        return _processes;
+    }
+    void addProcess(const Process &process)
+    {
+        Logger::debug(QString("%1 add process: %2 | %3 | %4 clock(s)").arg(_name).arg(process.label).arg(process.sensitivity.join(' ')).arg(process.clocks.count()));
+        _processes.append(process);
+    }
+
+    const Generate &generate(int index)
+    {
+        return _generates.at(index);
+    }
+    const QList<Generate> &getGenerates()
+    {
+        return _generates;
+    }
+    int addGenerate(const Generate &generate)
+    {
+        Logger::debug(QString("%1 add generate: %2 | %3").arg(_name).arg(generatePath(generate.parent, generate.label)).arg(generate.scheme));
+        _generates.append(generate);
+        return _generates.count() - 1;
+    }
+    // Generate statements around an element, outermost first
+    QList<int> generateChain(int generate)
+    {
+        QList<int> chain;
+        for (; generate != NO_GENERATE; generate = _generates.at(generate).parent)
+            chain.prepend(generate);
+        return chain;
+    }
+    QString generatePath(int generate, const QString &name)
+    {
+        QStringList path;
+        for (int index : generateChain(generate))
+            path.append(_generates.at(index).label);
+        path.append(name);
+        return path.join('.');
     }
 };
 
 /******************************************************************************/
 
+class Package;
+
 typedef QString Use;
-typedef QPair<QString, QString> Port;
+struct Port {
+    QString direction;
+    QString type;
+    TypeId typeId;
+    Location location;
+};
+typedef Constant Generic;
 
 class Entity {
 protected:
     QString _name;
+    Location _location;
     QMultiHash<QString, Use> _uses;
+    // Generics are indexed in lower case, their declaration order is needed for positional associations
+    QHash<QString, Generic *> _generics;
+    QStringList _genericNames;
+    // Ports too, as VHDL identifiers are case-insensitive
     QHash<QString, Port *> _ports;
+    // Declaration order of the ports, for positional associations
+    QStringList _portNames;
     QHash<QString, Architecture *> _architectures;
+    QList<Redeclaration> _redeclarations;
+
+    // Packages made visible by the use clauses, resolved on the first lookup
+    bool _usesResolved = false;
+    QList<Package *> _visiblePackages;
+    QHash<QString, Package *> _visibleNames;
 
 public:
     ~Entity()
@@ -100,9 +506,18 @@ public:
     {
         _name = "";
         _uses.clear();
+        _usesResolved = false;
+        _visiblePackages.clear();
+        _visibleNames.clear();
+        for (auto generic : _generics)
+            delete generic;
+        _generics.clear();
+        _genericNames.clear();
         for (auto port : _ports)
             delete port;
         _ports.clear();
+        _portNames.clear();
+        _redeclarations.clear();
         for (auto architecture : _architectures)
             delete architecture;
         _architectures.clear();
@@ -117,23 +532,105 @@ public:
         _name = name.trimmed();
     }
 
+    FileId file()
+    {
+        return _location.file;
+    }
+    const Location &location()
+    {
+        return _location;
+    }
+    void setLocation(const Location &location)
+    {
+        _location = location;
+    }
+
+    const QMultiHash<QString, Use> &getUses()
+    {
+        return _uses;
+    }
     void addUse(const QString &library, const QString &use)
     {
         _uses.insert(library.trimmed(), use.trimmed());
+        _usesResolved = false;
+    }
+
+    bool usesResolved()
+    {
+        return _usesResolved;
+    }
+    const QList<Package *> &visiblePackages()
+    {
+        return _visiblePackages;
+    }
+    const QHash<QString, Package *> &visibleNames()
+    {
+        return _visibleNames;
+    }
+    void setVisibleSymbols(const QList<Package *> &packages, const QHash<QString, Package *> &names)
+    {
+        _visiblePackages = packages;
+        _visibleNames = names;
+        _usesResolved = true;
+    }
+    void invalidateUses()
+    {
+        _usesResolved = false;
+        _visiblePackages.clear();
+        _visibleNames.clear();
+    }
+
+    Generic *generic(QString name)
+    {
+        return _generics.value(name.trimmed().toLower(), nullptr);
+    }
+    const QHash<QString, Generic *> &getGenerics()
+    {
+        return _generics;
+    }
+    const QStringList &genericNames()
+    {
+        return _genericNames;
+    }
+    void addGeneric(const QString &name, const QString &type, TypeId typeId, const QString &value, const Location &location)
+    {
+        const QString key = name.trimmed().toLower();
+        Logger::debug(QString("%1 add generic: %2 | %3 | %4").arg(_name).arg(name.trimmed()).arg(type.trimmed()).arg(value.trimmed()));
+        if (!_generics.contains(key))
+            _genericNames.append(name.trimmed());
+        else
+            _redeclarations.append(Redeclaration { name.trimmed(), location });
+        delete _generics.take(key);
+        _generics.insert(key, new Generic { type.trimmed(), typeId, value.trimmed(), location });
     }
 
     Port *port(QString name)
     {
-        return _ports.value(name.trimmed(), nullptr);
+        return _ports.value(name.trimmed().toLower(), nullptr);
     }
     const QHash<QString, Port *> &getPorts()
     {
         return _ports;
     }
-    void addPort(const QString &name, const QString &direction, const QString &type)
+    const QStringList &portNames()
+    {
+        return _portNames;
+    }
+    void addPort(const QString &name, const QString &direction, const QString &type, TypeId typeId, const Location &location)
     {
+        const QString key = name.trimmed().toLower();
         Logger::debug(QString("%1 add port: %2 | %3 | %4").arg(_name).arg(name.trimmed()).arg(direction.trimmed()).arg(type.trimmed()));
-        _ports.insert(name.trimmed(), new Port(direction.trimmed(), type.trimmed()));
+        if (!_ports.contains(key))
+            _portNames.append(name.trimmed());
+        else
+            _redeclarations.append(Redeclaration { name.trimmed(), location });
+        delete _ports.take(key);
+        _ports.insert(key, new Port { direction.trimmed(), type.trimmed(), typeId, location });
+    }
+
+    const QList<Redeclaration> &getRedeclarations()
+    {
+        return _redeclarations;
     }
 
     Architecture *architecture(QString name)
@@ -149,6 +646,311 @@ public:
         Logger::debug(QString("%1 add architecture: %2").arg(_name).arg(architecture->name()));
         _architectures.insert(architecture->name(), architecture);
     }
+    void removeArchitectures(FileId file)
+    {
+        for (auto it = _architectures.begin(); it != _architectures.end();)
+        {
+            if (it.value()->file() != file)
+            {
+                ++it;
+                continue;
+            }
+            delete it.value();
+            it = _architectures.erase(it);
+        }
+    }
+};
+
+/******************************************************************************/
+
+typedef QString Subprogram;
+
+struct Symbol {
+    enum class Kind {
+        None,
+        Constant,
+        Type,
+        Component,
+        Subprogram
+    };
+
+    Kind kind;
+    Package *package;
+};
+
+class Package {
+protected:
+    QString _name;
+    Location _location;
+    Location _bodyLocation;
+    QMultiHash<QString, Use> _uses;
+    QMultiHash<QString, Use> _bodyUses;
+    QHash<QString, Constant *> _constants;
+    // Constants declared in the body only, they are not visible outside of the package
+    QHash<QString, Constant *> _bodyConstants;
+    QHash<QString, TypeId> _types;
+    QHash<QString, Entity *> _components;
+    QMultiHash<QString, Subprogram *> _subprograms;
+
+    // Every name declared in the package declaration, VHDL identifiers are case insensitive
+    QHash<QString, Symbol::Kind> _symbols;
+
+public:
+    ~Package()
+    {
+        for (auto constant : _constants)
+            delete constant;
+        for (auto constant : _bodyConstants)
+            delete constant;
+        for (auto component : _components)
+            delete component;
+        for (auto subprogram : _subprograms)
+            delete subprogram;
+    }
+
+    const QString &name()
+    {
+        return _name;
+    }
+    void setName(const QString &name)
+    {
+        _name = name.trimmed();
+    }
+
+    // The package declaration and the package body can come from different files
+    FileId file()
+    {
+        return _location.file;
+    }
+    const Location &location()
+    {
+        return _location;
+    }
+    void setLocation(const Location &location)
+    {
+        _location = location;
+    }
+    FileId bodyFile()
+    {
+        return _bodyLocation.file;
+    }
+    const Location &bodyLocation()
+    {
+        return _bodyLocation;
+    }
+    void setBodyLocation(const Location &location)
+    {
+        _bodyLocation = location;
+    }
+
+    // Context clauses of the declaration and of the body
+    const QMultiHash<QString, Use> &getUses()
+    {
+        return _uses;
+    }
+    void setUses(const QMultiHash<QString, Use> &uses)
+    {
+        _uses = uses;
+    }
+    const QMultiHash<QString, Use> &getBodyUses()
+    {
+        return _bodyUses;
+    }
+    void setBodyUses(const QMultiHash<QString, Use> &uses)
+    {
+        _bodyUses = uses;
+    }
+
+    Symbol::Kind symbol(const QString &name)
+    {
+        return _symbols.value(name.trimmed().toLower(), Symbol::Kind::None);
+    }
+    const QHash<QString, Symbol::Kind> &getSymbols()
+    {
+        return _symbols;
+    }
+
+    Constant *constant(QString name)
+    {
+        return _constants.value(name.trimmed().toLower(), nullptr);
+    }
+    const QHash<QString, Constant *> &getConstants()
+    {
+        return _constants;
+    }
+    Constant *bodyConstant(QString name)
+    {
+        return _bodyConstants.value(name.trimmed().toLower(), nullptr);
+    }
+    // The package body completes deferred constants, its other constants are kept apart
+    void addConstant(const QString &name, const QString &type, TypeId typeId, const QString &value, const Location &location, bool body = false)
+    {
+        const QString key = name.trimmed().toLower();
+        Logger::debug(QString("%1 add constant: %2 | %3 | %4").arg(_name).arg(name.trimmed()).arg(type.trimmed()).arg(value.trimmed()));
+        if (body && !_constants.contains(key))
+        {
+            delete _bodyConstants.take(key);
+            _bodyConstants.insert(key, new Constant { type.trimmed(), typeId, value.trimmed(), location });
+            return;
+        }
+        delete _constants.take(key);
+        _constants.insert(key, new Constant { type.trimmed(), typeId, value.trimmed(), location });
+        _symbols.insert(key, Symbol::Kind::Constant);
+    }
+
+    TypeId type(QString name)
+    {
+        return _types.value(name.trimmed().toLower(), INVALID_TYPE_ID);
+    }
+    const QHash<QString, TypeId> &getTypes()
+    {
+        return _types;
+    }
+    void addType(const QString &name, TypeId typeId)
+    {
+        const QString key = name.trimmed().toLower();
+        _types.insert(key, typeId);
+        _symbols.insert(key, Symbol::Kind::Type);
+    }
+
+    Entity *component(QString name)
+    {
+        return _components.value(name.trimmed().toLower(), nullptr);
+    }
+    const QHash<QString, Entity *> &getComponents()
+    {
+        return _components;
+    }
+    void addComponent(Entity *component)
+    {
+        const QString key = component->name().toLower();
+        Logger::debug(QString("%1 add component: %2").arg(_name).arg(component->name()));
+        delete _components.take(key);
+        _components.insert(key, component);
+        _symbols.insert(key, Symbol::Kind::Component);
+    }
+
+    // Subprograms can be overloaded
+    QList<Subprogram *> subprograms(QString name)
+    {
+        return _subprograms.values(name.trimmed().toLower());
+    }
+    const QMultiHash<QString, Subprogram *> &getSubprograms()
+    {
+        return _subprograms;
+    }
+    void addSubprogram(const QString &name, const QString &specification)
+    {
+        const QString key = name.trimmed().toLower();
+        Logger::debug(QString("%1 add subprogram: %2 | %3").arg(_name).arg(name.trimmed()).arg(specification.trimmed()));
+        _subprograms.insert(key, new Subprogram(specification.trimmed()));
+        _symbols.insert(key, Symbol::Kind::Subprogram);
+    }
+};
+
+/******************************************************************************/
+
+// Identifiers are interned in the cross-reference index, in lower case
+typedef int IdentifierId;
+static constexpr IdentifierId INVALID_IDENTIFIER_ID = -1;
+
+struct Reference {
+    enum class Kind {
+        Declaration,
+        Read,
+        Write,
+        Instantiation
+    };
+
+    IdentifierId identifier;
+    IdentifierId scope;
+    Location location;
+    Kind kind;
+};
+
+class CrossReferenceIndex {
+protected:
+    QStringList _identifiers;
+    QHash<QString, IdentifierId> _identifierIds;
+
+    // References are stored per file, in source order, and indexed by identifier
+    QHash<FileId, QList<Reference>> _fileReferences;
+    QHash<IdentifierId, QHash<FileId, QList<int>>> _postings;
+
+public:
+    IdentifierId identifier(const QString &name)
+    {
+        const QString key = name.trimmed().toLower();
+        IdentifierId id = _identifierIds.value(key, INVALID_IDENTIFIER_ID);
+        if (id == INVALID_IDENTIFIER_ID)
+        {
+            id = _identifiers.count();
+            _identifiers.append(key);
+            _identifierIds.insert(key, id);
+        }
+        return id;
+    }
+    IdentifierId findIdentifier(const QString &name)
+    {
+        return _identifierIds.value(name.trimmed().toLower(), INVALID_IDENTIFIER_ID);
+    }
+    QString identifierName(IdentifierId id)
+    {
+        return _identifiers.value(id);
+    }
+
+    void addReference(const Reference &reference)
+    {
+        QList<Reference> &references = _fileReferences[reference.location.file];
+        _postings[reference.identifier][reference.location.file].append(references.count());
+        references.append(reference);
+    }
+
+    // Only the identifiers that appear in the file are visited
+    void removeFile(FileId file)
+    {
+        const QList<Reference> references = _fileReferences.take(file);
+        for (const Reference &reference : references)
+        {
+            auto posting = _postings.find(reference.identifier);
+            if (posting == _postings.end())
+                continue;
+            posting->remove(file);
+            if (posting->isEmpty())
+                _postings.erase(posting);
+        }
+    }
+
+    QList<Reference> fileReferences(FileId file)
+    {
+        return _fileReferences.value(file);
+    }
+    QList<Reference> references(IdentifierId identifier)
+    {
+        QList<Reference> result;
+        const auto posting = _postings.constFind(identifier);
+        if (posting == _postings.cend())
+            return result;
+        for (auto it = posting->cbegin(); it != posting->cend(); ++it)
+        {
+            const QList<Reference> &references = _fileReferences[it.key()];
+            for (int index : it.value())
+                result.append(references.at(index));
+        }
+        return result;
+    }
+    QList<Reference> references(IdentifierId identifier, Reference::Kind kind)
+    {
+        QList<Reference> result;
+        for (const Reference &reference : references(identifier))
+            if (reference.kind == kind)
+                result.append(reference);
+        return result;
+    }
+    QList<Reference> references(const QString &name, Reference::Kind kind)
+    {
+        return references(findIdentifier(name), kind);
+    }
 };
 
 /******************************************************************************/
@@ -156,14 +958,148 @@ public:
 class Design {
 protected:
     QHash<QString, Entity *> _entities;
+    QHash<QString, Package *> _packages;
+    QList<Type *> _types;
+    QHash<QString, TypeId> _typeIds;
+    QList<SourceFile> _files;
+    QHash<QString, FileId> _fileIds;
+    CrossReferenceIndex _references;
 
 public:
     ~Design()
     {
         for (auto entity : _entities)
             delete entity;
+        for (auto package : _packages)
+            delete package;
+        for (auto type : _types)
+            delete type;
+    }
+
+    /******************************************************************************/
+
+    FileId fileId(const QString &path)
+    {
+        return _fileIds.value(path, INVALID_FILE_ID);
+    }
+    const QList<SourceFile> &getFiles()
+    {
+        return _files;
+    }
+
+    // A file keeps its ID when it is parsed again
+    FileId addFile(const QString &path, const QDateTime &lastModified)
+    {
+        FileId id = fileId(path);
+        if (id == INVALID_FILE_ID)
+        {
+            id = _files.count();
+            _files.append(SourceFile { path, lastModified, { }, { } });
+            _fileIds.insert(path, id);
+        }
+        else
+            _files[id].lastModified = lastModified;
+        return id;
+    }
+
+    // Offset of the first character of each line, filled by the parsers
+    void setLineOffsets(FileId file, const QList<quint32> &lineOffsets)
+    {
+        _files[file].lineOffsets = lineOffsets;
+    }
+    void setSpillPath(FileId file, const QString &spillPath)
+    {
+        _files[file].spillPath = spillPath;
+    }
+
+    // Lines and columns start at 1, 0 means unknown
+    int line(const Location &location)
+    {
+        if (location.file < 0 || location.file >= _files.count())
+            return 0;
+        const QList<quint32> &lineOffsets = _files.at(location.file).lineOffsets;
+        return std::upper_bound(lineOffsets.cbegin(), lineOffsets.cend(), location.offset) - lineOffsets.cbegin();
+    }
+    int column(const Location &location)
+    {
+        const int line = this->line(location);
+        if (line == 0)
+            return 0;
+        return location.offset - _files.at(location.file).lineOffsets.at(line - 1) + 1;
+    }
+    QString locationString(const Location &location)
+    {
+        if (location.file < 0 || location.file >= _files.count())
+            return QString();
+        return QString("%1:%2:%3").arg(_files.at(location.file).path).arg(line(location)).arg(column(location));
     }
 
+    // Remove everything declared in the given files, as well as in the files that depend on them.
+    // Returns all the files that were removed, these have to be parsed again.
+    QSet<FileId> removeFiles(const QSet<FileId> &files)
+    {
+        QSet<FileId> removed;
+        QList<FileId> pending(files.cbegin(), files.cend());
+        while (!pending.isEmpty())
+        {
+            const FileId file = pending.takeLast();
+            if (file == INVALID_FILE_ID || removed.contains(file))
+                continue;
+            removed.insert(file);
+            _files[file].lastModified = QDateTime();
+            _files[file].lineOffsets.clear();
+            _files[file].spillPath.clear();
+
+            // Architectures declared elsewhere are lost along with their entity
+            for (auto it = _entities.begin(); it != _entities.end();)
+            {
+                Entity *entity = it.value();
+                if (entity->file() != file)
+                {
+                    entity->removeArchitectures(file);
+                    entity->invalidateUses();
+                    ++it;
+                    continue;
+                }
+                for (auto architecture : entity->getArchitectures())
+                    if (architecture->file() != file)
+                        pending.append(architecture->file());
+                delete entity;
+                it = _entities.erase(it);
+            }
+
+            // Both the declaration and the body have to be parsed again
+            for (auto it = _packages.begin(); it != _packages.end();)
+            {
+                Package *package = it.value();
+                if (package->file() != file && package->bodyFile() != file)
+                {
+                    ++it;
+                    continue;
+                }
+                pending.append(package->file());
+                pending.append(package->bodyFile());
+                delete package;
+                it = _packages.erase(it);
+            }
+
+            // Types keep their ID, so that the elements referring to them stay valid
+            for (auto type : _types)
+                if (type->file() == file)
+                    type->reset();
+
+            _references.removeFile(file);
+        }
+        return removed;
+    }
+
+    CrossReferenceIndex &references()
+    {
+        return _references;
+    }
+
+    /******************************************************************************/
+
     Entity *entity(QString name)
     {
         return _entities.value(name, nullptr);
@@ -177,6 +1113,141 @@ public:
         Logger::debug(QString("add entity: %1").arg(entity->name()));
         _entities.insert(entity->name(), entity);
     }
+
+    /******************************************************************************/
+
+    // Packages are indexed by library and name, in lower case
+    Package *package(QString name)
+    {
+        return _packages.value(name.trimmed().toLower(), nullptr);
+    }
+    const QHash<QString, Package *> &getPackages()
+    {
+        return _packages;
+    }
+    void addPackage(Package *package)
+    {
+        Logger::debug(QString("add package: %1").arg(package->name()));
+        _packages.insert(package->name().toLower(), package);
+    }
+
+    // Resolve the use clauses of an entity against the package index, once
+    void resolveUses(Entity *entity)
+    {
+        QList<Package *> packages;
+        QHash<QString, Package *> names;
+        for (auto it = entity->getUses().cbegin(); it != entity->getUses().cend(); ++it)
+        {
+            Package *package = this->package(QString("%1.%2").arg(it.key()).arg(it.value().section('.', 0, 0)));
+            if (package == nullptr)
+                continue;
+            const QString item = it.value().section('.', 1).toLower();
+            if (item == "all")
+            {
+                if (!packages.contains(package))
+                    packages.append(package);
+            }
+            else
+                names.insert(item, package);
+        }
+        entity->setVisibleSymbols(packages, names);
+    }
+
+    // Find a name made visible by the use clauses of an entity
+    Symbol lookup(Entity *entity, const QString &name)
+    {
+        if (!entity->usesResolved())
+            resolveUses(entity);
+        const QString key = name.trimmed().toLower();
+        Package *package = entity->visibleNames().value(key, nullptr);
+        if (package != nullptr && package->symbol(key) != Symbol::Kind::None)
+            return Symbol { package->symbol(key), package };
+        for (Package *visible : entity->visiblePackages())
+        {
+            const Symbol::Kind kind = visible->symbol(key);
+            if (kind != Symbol::Kind::None)
+                return Symbol { kind, visible };
+        }
+        return Symbol { Symbol::Kind::None, nullptr };
+    }
+
+    /******************************************************************************/
+
+    Type *type(TypeId id)
+    {
+        return (id >= 0 && id < _types.count()) ? _types.at(id) : nullptr;
+    }
+    const QList<Type *> &getTypes()
+    {
+        return _types;
+    }
+    TypeId typeId(const QString &name)
+    {
+        return _typeIds.value(name.trimmed().toLower(), INVALID_TYPE_ID);
+    }
+
+    // Get the ID of a type, creating an unresolved placeholder if it is not known yet
+    TypeId internType(const QString &name)
+    {
+        const QString key = name.trimmed().toLower();
+        TypeId id = _typeIds.value(key, INVALID_TYPE_ID);
+        if (id == INVALID_TYPE_ID)
+        {
+            id = _types.count();
+            _types.append(new Type(id, key));
+            _typeIds.insert(key, id);
+        }
+        return id;
+    }
+
+    // Look for a type mark in the given scopes first, innermost first, then in the global scope
+    TypeId resolveType(const QStringList &scopes, const QString &typeMark)
+    {
+        const QString mark = typeMark.trimmed().section('.', -1).toLower();
+        for (const QString &scope : scopes)
+        {
+            const TypeId id = _typeIds.value(QString("%1.%2").arg(scope.toLower()).arg(mark), INVALID_TYPE_ID);
+            if (id != INVALID_TYPE_ID)
+                return id;
+        }
+        return internType(mark);
+    }
+
+    // Declaring a type that was used or announced before fills its placeholder, so that its ID does not change.
+    // Type marks that could not be resolved are interned under their simple name, the first declaration of that name
+    // claims their placeholder.
+    Type *declareType(const QString &name, Type::Kind kind)
+    {
+        Logger::debug(QString("add type: %1").arg(name.trimmed()));
+        const QString key = name.trimmed().toLower();
+        Type *declared = type(typeId(key));
+        if (declared == nullptr || (declared->kind() != Type::Kind::Unresolved && declared->kind() != Type::Kind::Incomplete))
+        {
+            const QString simpleName = key.section('.', -1);
+            Type *placeholder = (simpleName != key) ? type(typeId(simpleName)) : nullptr;
+            if (placeholder != nullptr && placeholder->kind() == Type::Kind::Unresolved)
+            {
+                declared = placeholder;
+                declared->setName(key);
+                _typeIds.remove(simpleName);
+            }
+            else
+            {
+                declared = new Type(_types.count(), key);
+                _types.append(declared);
+            }
+            _typeIds.insert(key, declared->id());
+        }
+        declared->setKind(kind);
+        return declared;
+    }
+
+    bool compatibleTypes(TypeId a, TypeId b)
+    {
+        Type *typeA = type(a);
+        Type *typeB = type(b);
+        return typeA != nullptr && typeB != nullptr && typeA->baseType() == typeB->baseType();
+    }
 };
 
 /******************************************************************************/
@@ -0,0 +1,219 @@
+/* Lambila | DesignDiff.cpp
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#include "DesignDiff.h"
+
+/******************************************************************************/
+
+static QString associations(const QList<Association> &map)
+{
+    QStringList elements;
+    for (const Association &association : map)
+        elements.append(QString("%1=>%2").arg(association.formal).arg(association.actual));
+    return elements.join(',');
+}
+
+// Changes of the elements of one kind, in name order. Returns true if any element changed.
+static bool compareElements(const QHash<QString, QString> &previous, const QHash<QString, QString> &current, DesignDiff::Element element,
+                            const QString &entity, const QString &architecture, DesignDiff::ChangeSet &changes)
+{
+    QStringList names = QSet<QString>(previous.keyBegin(), previous.keyEnd()).unite(QSet<QString>(current.keyBegin(), current.keyEnd())).values();
+    names.sort();
+    bool changed = false;
+    for (const QString &name : names)
+    {
+        const auto before = previous.constFind(name);
+        const auto after = current.constFind(name);
+        DesignDiff::Kind kind;
+        if (before == previous.cend())
+            kind = DesignDiff::Kind::Added;
+        else if (after == current.cend())
+            kind = DesignDiff::Kind::Removed;
+        else if (before.value() != after.value())
+            kind = DesignDiff::Kind::Modified;
+        else
+            continue;
+        changes.append(DesignDiff::Change { kind, element, entity, architecture, name });
+        changed = true;
+    }
+    return changed;
+}
+
+/******************************************************************************/
+
+QString DesignDiff::kindName(Kind kind)
+{
+    switch (kind)
+    {
+    case Kind::Added:    return "added";
+    case Kind::Removed:  return "removed";
+    case Kind::Modified: return "modified";
+    }
+    return QString();
+}
+
+QString DesignDiff::elementName(Element element)
+{
+    switch (element)
+    {
+    case Element::Entity:       return "entity";
+    case Element::Port:         return "port";
+    case Element::Architecture: return "architecture";
+    case Element::Signal:       return "signal";
+    case Element::Instance:     return "instance";
+    }
+    return QString();
+}
+
+/******************************************************************************/
+
+DesignDiff::EntitySnapshot DesignDiff::snapshot(Entity *entity)
+{
+    EntitySnapshot snapshot;
+    snapshot.files.insert(entity->file());
+    for (const QString &name : entity->genericNames())
+    {
+        const Generic *generic = entity->generic(name);
+        snapshot.generics += QString("%1:%2:=%3;").arg(name).arg(generic->type).arg(generic->value);
+    }
+    for (const QString &name : entity->portNames())
+    {
+        const Port *port = entity->port(name);
+        snapshot.ports.insert(name, QString("%1 %2").arg(port->direction).arg(port->type));
+    }
+
+    for (auto architecture : entity->getArchitectures())
+    {
+        snapshot.files.insert(architecture->file());
+        ArchitectureSnapshot &architectureSnapshot = snapshot.architectures[architecture->name()];
+        for (auto it = architecture->getSignals().cbegin(); it != architecture->getSignals().cend(); ++it)
+            architectureSnapshot.signalTypes.insert(it.key(), it.value()->type);
+        for (auto it = architecture->getInstances().cbegin(); it != architecture->getInstances().cend(); ++it)
+        {
+            const Instance *instance = it.value();
+            architectureSnapshot.instances.insert(it.key(), QString("%1 %2 generic map(%3) port map(%4)")
+                .arg(instance->unit).arg(instance->generate).arg(associations(instance->genericMap)).arg(associations(instance->portMap)));
+        }
+        if (architecture->summarized())
+        {
+            const QHash<QString, qint64> counts = architecture->instanceCounts();
+            QStringList units = counts.keys();
+            units.sort();
+            architectureSnapshot.summary = QString::number(architecture->signalCount());
+            for (const QString &unit : units)
+                architectureSnapshot.summary += QString(";%1:%2").arg(unit).arg(counts.value(unit));
+        }
+    }
+    return snapshot;
+}
+
+void DesignDiff::compare(const QString &entity, const EntitySnapshot &previous, const EntitySnapshot &current, ChangeSet &changes)
+{
+    bool changed = (previous.generics != current.generics);
+    changed |= compareElements(previous.ports, current.ports, Element::Port, entity, QString(), changes);
+
+    QStringList names = QSet<QString>(previous.architectures.keyBegin(), previous.architectures.keyEnd())
+        .unite(QSet<QString>(current.architectures.keyBegin(), current.architectures.keyEnd())).values();
+    names.sort();
+    for (const QString &name : names)
+    {
+        const auto before = previous.architectures.constFind(name);
+        const auto after = current.architectures.constFind(name);
+        if (before == previous.architectures.cend() || after == current.architectures.cend())
+        {
+            changes.append(Change { (after == current.architectures.cend()) ? Kind::Removed : Kind::Added, Element::Architecture, entity, name, QString() });
+            changed = true;
+            continue;
+        }
+        bool architectureChanged = (before->summary != after->summary);
+        architectureChanged |= compareElements(before->signalTypes, after->signalTypes, Element::Signal, entity, name, changes);
+        architectureChanged |= compareElements(before->instances, after->instances, Element::Instance, entity, name, changes);
+        if (architectureChanged)
+            changes.append(Change { Kind::Modified, Element::Architecture, entity, name, QString() });
+        changed |= architectureChanged;
+    }
+
+    if (changed)
+        changes.append(Change { Kind::Modified, Element::Entity, entity, QString(), QString() });
+}
+
+void DesignDiff::remove(const QString &entity)
+{
+    const EntitySnapshot snapshot = _entities.take(entity);
+    for (FileId file : snapshot.files)
+    {
+        const auto it = _fileEntities.find(file);
+        if (it == _fileEntities.end())
+            continue;
+        it->remove(entity);
+        if (it->isEmpty())
+            _fileEntities.erase(it);
+    }
+}
+
+void DesignDiff::insert(const QString &entity, const EntitySnapshot &snapshot)
+{
+    _entities.insert(entity, snapshot);
+    for (FileId file : snapshot.files)
+        _fileEntities[file].insert(entity);
+}
+
+/******************************************************************************/
+
+DesignDiff::ChangeSet DesignDiff::update(Design *design, const QSet<FileId> &files)
+{
+    // Entities that were in the files, and entities that are in them now
+    QSet<QString> candidates;
+    for (FileId file : files)
+        candidates.unite(_fileEntities.value(file));
+    for (auto entity : design->getEntities())
+    {
+        // Entities of the library summaries have no file, they only appear once
+        if (files.contains(entity->file()) || (entity->file() == INVALID_FILE_ID && !_entities.contains(entity->name())))
+        {
+            candidates.insert(entity->name());
+            continue;
+        }
+        for (auto architecture : entity->getArchitectures())
+            if (files.contains(architecture->file()))
+            {
+                candidates.insert(entity->name());
+                break;
+            }
+    }
+
+    ChangeSet changes;
+    QStringList names = candidates.values();
+    names.sort();
+    for (const QString &name : names)
+    {
+        Entity *entity = design->entity(name);
+        const bool known = _entities.contains(name);
+        if (entity == nullptr)
+        {
+            if (known)
+                changes.append(Change { Kind::Removed, Element::Entity, name, QString(), QString() });
+            remove(name);
+            continue;
+        }
+        const EntitySnapshot current = snapshot(entity);
+        if (known)
+            compare(name, _entities.value(name), current, changes);
+        else
+            changes.append(Change { Kind::Added, Element::Entity, name, QString(), QString() });
+        remove(name);
+        insert(name, current);
+    }
+    Logger::debug(QString("design diff: %1 change(s) in %2 of %3 entities").arg(changes.count()).arg(names.count()).arg(design->getEntities().count()));
+    return changes;
+}
+
+void DesignDiff::clear()
+{
+    _entities.clear();
+    _fileEntities.clear();
+}
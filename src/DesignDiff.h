@@ -0,0 +1,88 @@
+/* Lambila | DesignDiff.h
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#ifndef DESIGNDIFF_H
+#define DESIGNDIFF_H
+
+/******************************************************************************/
+
+#include "Design.h"
+
+/******************************************************************************/
+
+// Structural differences of the design from one refresh to the next.
+// The entities are parsed again as new objects, so their structure is kept as a snapshot. Only the entities declared
+// in the files that changed, or whose architectures are, are compared with their snapshot, so that a refresh costs
+// in proportion to what changed.
+class DesignDiff
+{
+public:
+    enum class Kind {
+        Added,
+        Removed,
+        Modified
+    };
+
+    enum class Element {
+        Entity,
+        Port,
+        Architecture,
+        Signal,
+        Instance
+    };
+
+    // Entities and architectures are modified when one of their elements is, their changes come after those of the
+    // elements
+    struct Change {
+        Kind kind;
+        Element element;
+        QString entity;
+        // Empty for entities and ports
+        QString architecture;
+        // Name of the port or signal, label of the instance, empty for entities and architectures
+        QString name;
+    };
+    typedef QList<Change> ChangeSet;
+
+protected:
+    struct ArchitectureSnapshot {
+        QHash<QString, QString> signalTypes;
+        // Unit and associations of each instance
+        QHash<QString, QString> instances;
+        // Counts of the summarized architectures, whose signals and instances are not modelled
+        QString summary;
+    };
+
+    struct EntitySnapshot {
+        QSet<FileId> files;
+        QString generics;
+        // Direction and type of each port
+        QHash<QString, QString> ports;
+        QHash<QString, ArchitectureSnapshot> architectures;
+    };
+
+    QHash<QString, EntitySnapshot> _entities;
+    // Entities declared in each file, or having an architecture in it
+    QHash<FileId, QSet<QString>> _fileEntities;
+
+    static EntitySnapshot snapshot(Entity *entity);
+    static void compare(const QString &entity, const EntitySnapshot &previous, const EntitySnapshot &current, ChangeSet &changes);
+    void remove(const QString &entity);
+    void insert(const QString &entity, const EntitySnapshot &snapshot);
+
+public:
+    static QString kindName(Kind kind);
+    static QString elementName(Element element);
+
+    // Compare the entities touched by the given files with their previous snapshot
+    ChangeSet update(Design *design, const QSet<FileId> &files);
+    void clear();
+};
+
+/******************************************************************************/
+
+#endif // DESIGNDIFF_H
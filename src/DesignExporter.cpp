@@ -0,0 +1,390 @@
+/* Lambila | DesignExporter.cpp
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#include "DesignExporter.h"
+
+#include <QFileInfo>
+#include <QtEndian>
+
+/******************************************************************************/
+
+// Size from which the buffer is written to the device
+static const int FLUSH_SIZE = 64 * 1024;
+static const char BINARY_MAGIC[4] = { 'L', 'D', 'E', 'S' };
+
+/******************************************************************************/
+
+static QByteArray jsonString(const QString &string)
+{
+    QByteArray escaped = "\"";
+    for (const char c : string.toUtf8())
+    {
+        switch (c)
+        {
+        case '"':  escaped += "\\\""; break;
+        case '\\': escaped += "\\\\"; break;
+        case '\n': escaped += "\\n"; break;
+        case '\r': escaped += "\\r"; break;
+        case '\t': escaped += "\\t"; break;
+        default:
+            if (static_cast<uchar>(c) < 0x20)
+                escaped += QString("\\u%1").arg(int(static_cast<uchar>(c)), 4, 16, QChar('0')).toLatin1();
+            else
+                escaped += c;
+        }
+    }
+    return escaped + "\"";
+}
+
+static QByteArray dotString(const QString &string)
+{
+    QByteArray escaped = string.toUtf8();
+    escaped.replace('\\', "\\\\").replace('"', "\\\"");
+    return "\"" + escaped + "\"";
+}
+
+/******************************************************************************/
+
+DesignExporter::DesignExporter(Design *design, QIODevice *device)
+{
+    _design = design;
+    _device = device;
+    _failed = false;
+}
+
+bool DesignExporter::formatFor(const QString &filePath, Format *format)
+{
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+    if (suffix == "json")
+        *format = Format::Json;
+    else if (suffix == "lbd")
+        *format = Format::Binary;
+    else if (suffix == "dot" || suffix == "gv")
+        *format = Format::Dot;
+    else
+        return false;
+    return true;
+}
+
+bool DesignExporter::write(Format format)
+{
+    switch (format)
+    {
+    case Format::Json:   writeJson(); break;
+    case Format::Binary: writeBinary(); break;
+    case Format::Dot:    writeDot(); break;
+    }
+    return flush();
+}
+
+/******************************************************************************/
+
+void DesignExporter::write(const QByteArray &data)
+{
+    _buffer.append(data);
+    if (_buffer.size() >= FLUSH_SIZE)
+        flush();
+}
+
+bool DesignExporter::flush()
+{
+    // Once failed, the rest is dropped
+    if (!_failed && !_buffer.isEmpty() && _device->write(_buffer) != _buffer.size())
+        _failed = true;
+    _buffer.clear();
+    return !_failed;
+}
+
+bool DesignExporter::readSpill(Entity *entity, Architecture *architecture, const NetlistSpill::Visitor &visitor)
+{
+    const FileId file = architecture->file();
+    if (file == INVALID_FILE_ID || _design->getFiles().at(file).spillPath.isEmpty())
+        return false;
+    const QString &spillPath = _design->getFiles().at(file).spillPath;
+    auto index = _spillIndexes.find(file);
+    if (index == _spillIndexes.end())
+    {
+        index = _spillIndexes.insert(file, NetlistSpill::Index());
+        if (!NetlistSpill::index(spillPath, &index.value()))
+            Logger::warning(QString("Failed to index spill file %1").arg(spillPath));
+    }
+    const QList<qint64> runs = index->value(QString("%1.%2").arg(entity->name()).arg(architecture->name()).toLower());
+    return NetlistSpill::read(spillPath, runs, [&](const NetlistSpill::Record &record) {
+        NetlistSpill::Record located = record;
+        located.location.file = file;
+        return visitor(located);
+    });
+}
+
+/******************************************************************************/
+
+void DesignExporter::writeJson()
+{
+    write(QString("{\"format\":\"lambila-design\",\"version\":%1,\"files\":[").arg(VERSION).toUtf8());
+    const QList<SourceFile> &files = _design->getFiles();
+    for (FileId id = 0; id < files.count(); ++id)
+        write(QString("%1{\"id\":%2,\"path\":").arg(id == 0 ? "" : ",").arg(id).toUtf8() + jsonString(files.at(id).path) + "}");
+
+    write("],\"packages\":[");
+    bool first = true;
+    for (Package *package : _design->getPackages())
+    {
+        write((first ? "{\"name\":" : ",{\"name\":") + jsonString(package->name())
+              + QString(",\"file\":%1,\"line\":%2,\"constants\":[").arg(package->file()).arg(_design->line(package->location())).toUtf8());
+        first = false;
+        bool firstConstant = true;
+        for (auto it = package->getConstants().cbegin(); it != package->getConstants().cend(); ++it)
+        {
+            write((firstConstant ? "{\"name\":" : ",{\"name\":") + jsonString(it.key()) + ",\"type\":" + jsonString(it.value()->type)
+                  + ",\"value\":" + jsonString(it.value()->value) + "}");
+            firstConstant = false;
+        }
+        write("]}");
+    }
+
+    write("],\"entities\":[");
+    first = true;
+    for (Entity *entity : _design->getEntities())
+    {
+        if (!first)
+            write(",");
+        first = false;
+        writeJsonEntity(entity);
+    }
+    write("]}\n");
+}
+
+void DesignExporter::writeJsonEntity(Entity *entity)
+{
+    write("{\"name\":" + jsonString(entity->name()) + QString(",\"file\":%1,\"line\":%2,\"generics\":[").arg(entity->file()).arg(_design->line(entity->location())).toUtf8());
+    for (int i = 0; i < entity->genericNames().count(); ++i)
+    {
+        const Generic *generic = entity->generic(entity->genericNames().at(i));
+        write((i == 0 ? "{\"name\":" : ",{\"name\":") + jsonString(entity->genericNames().at(i)) + ",\"type\":" + jsonString(generic->type)
+              + ",\"value\":" + jsonString(generic->value) + "}");
+    }
+    write("],\"ports\":[");
+    for (int i = 0; i < entity->portNames().count(); ++i)
+    {
+        const Port *port = entity->port(entity->portNames().at(i));
+        write((i == 0 ? "{\"name\":" : ",{\"name\":") + jsonString(entity->portNames().at(i)) + ",\"direction\":" + jsonString(port->direction)
+              + ",\"type\":" + jsonString(port->type) + "}");
+    }
+    write("],\"architectures\":[");
+    bool first = true;
+    for (Architecture *architecture : entity->getArchitectures())
+    {
+        if (!first)
+            write(",");
+        first = false;
+        writeJsonArchitecture(entity, architecture);
+    }
+    write("]}");
+}
+
+void DesignExporter::writeJsonArchitecture(Entity *entity, Architecture *architecture)
+{
+    write("{\"name\":" + jsonString(architecture->name()) + QString(",\"file\":%1,\"line\":%2,\"summarized\":%3,\"constants\":[")
+          .arg(architecture->file()).arg(_design->line(architecture->location())).arg(architecture->summarized() ? "true" : "false").toUtf8());
+    bool first = true;
+    for (auto it = architecture->getConstants().cbegin(); it != architecture->getConstants().cend(); ++it)
+    {
+        write((first ? "{\"name\":" : ",{\"name\":") + jsonString(it.key()) + ",\"type\":" + jsonString(it.value()->type)
+              + ",\"value\":" + jsonString(it.value()->value) + QString(",\"line\":%1}").arg(_design->line(it.value()->location)).toUtf8());
+        first = false;
+    }
+
+    const auto writeSignal = [&](const QString &name, const QString &type, const Location &location) {
+        write((first ? "{\"name\":" : ",{\"name\":") + jsonString(name) + ",\"type\":" + jsonString(type) + QString(",\"line\":%1}").arg(_design->line(location)).toUtf8());
+        first = false;
+    };
+    const auto writeInstance = [&](const QString &label, const QString &unit, const Location &location) {
+        write((first ? "{\"label\":" : ",{\"label\":") + jsonString(label) + ",\"unit\":" + jsonString(unit) + QString(",\"line\":%1}").arg(_design->line(location)).toUtf8());
+        first = false;
+    };
+
+    write("],\"signals\":[");
+    first = true;
+    for (auto it = architecture->getSignals().cbegin(); it != architecture->getSignals().cend(); ++it)
+        writeSignal(it.key(), it.value()->type, it.value()->location);
+    if (architecture->summarized())
+        readSpill(entity, architecture, [&](const NetlistSpill::Record &record) {
+            if (record.kind == NetlistSpill::Kind::Signal)
+                writeSignal(record.name, record.detail, record.location);
+            return true;
+        });
+
+    write("],\"instances\":[");
+    first = true;
+    for (auto it = architecture->getInstances().cbegin(); it != architecture->getInstances().cend(); ++it)
+        writeInstance(it.key(), it.value()->unit, it.value()->location);
+    if (architecture->summarized())
+        readSpill(entity, architecture, [&](const NetlistSpill::Record &record) {
+            if (record.kind == NetlistSpill::Kind::Instance)
+                writeInstance(record.name, record.detail, record.location);
+            return true;
+        });
+    write("]}");
+}
+
+/******************************************************************************/
+
+void DesignExporter::beginRecord(Tag tag)
+{
+    _record.clear();
+    _record.append(static_cast<char>(tag));
+}
+
+void DesignExporter::addNumber(quint32 number)
+{
+    const quint32 little = qToLittleEndian(number);
+    _record.append(reinterpret_cast<const char *>(&little), sizeof(little));
+}
+
+void DesignExporter::addString(const QString &string)
+{
+    const QByteArray utf8 = string.toUtf8();
+    addNumber(utf8.size());
+    _record.append(utf8);
+}
+
+// The payload length goes between the tag and the payload
+void DesignExporter::endRecord()
+{
+    const quint32 little = qToLittleEndian(static_cast<quint32>(_record.size() - 1));
+    _record.insert(1, reinterpret_cast<const char *>(&little), sizeof(little));
+    write(_record);
+}
+
+void DesignExporter::writeBinary()
+{
+    beginRecord(Tag::Header);
+    _record.append(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    addNumber(VERSION);
+    endRecord();
+
+    const QList<SourceFile> &files = _design->getFiles();
+    for (FileId id = 0; id < files.count(); ++id)
+    {
+        beginRecord(Tag::File);
+        addNumber(id);
+        addString(files.at(id).path);
+        endRecord();
+    }
+
+    // Locations are the file ID and the line, files of the library summaries are written as 0xffffffff
+    const auto addLocation = [&](const Location &location) {
+        addNumber(location.file);
+        addNumber(_design->line(location));
+    };
+    const auto addConstant = [&](const QString &name, const Constant *constant) {
+        beginRecord(Tag::Constant);
+        addString(name);
+        addString(constant->type);
+        addString(constant->value);
+        addLocation(constant->location);
+        endRecord();
+    };
+    for (Package *package : _design->getPackages())
+    {
+        beginRecord(Tag::Package);
+        addString(package->name());
+        addLocation(package->location());
+        endRecord();
+        for (auto it = package->getConstants().cbegin(); it != package->getConstants().cend(); ++it)
+            addConstant(it.key(), it.value());
+    }
+
+    const auto addSignal = [&](const QString &name, const QString &type, const Location &location) {
+        beginRecord(Tag::Signal);
+        addString(name);
+        addString(type);
+        addLocation(location);
+        endRecord();
+    };
+    const auto addInstance = [&](const QString &label, const QString &unit, const Location &location) {
+        beginRecord(Tag::Instance);
+        addString(label);
+        addString(unit);
+        addLocation(location);
+        endRecord();
+    };
+    for (Entity *entity : _design->getEntities())
+    {
+        beginRecord(Tag::Entity);
+        addString(entity->name());
+        addLocation(entity->location());
+        endRecord();
+        for (const QString &name : entity->genericNames())
+        {
+            const Generic *generic = entity->generic(name);
+            beginRecord(Tag::Generic);
+            addString(name);
+            addString(generic->type);
+            addString(generic->value);
+            endRecord();
+        }
+        for (const QString &name : entity->portNames())
+        {
+            const Port *port = entity->port(name);
+            beginRecord(Tag::Port);
+            addString(name);
+            addString(port->direction);
+            addString(port->type);
+            endRecord();
+        }
+
+        for (Architecture *architecture : entity->getArchitectures())
+        {
+            beginRecord(Tag::Architecture);
+            addString(architecture->name());
+            addLocation(architecture->location());
+            endRecord();
+            for (auto it = architecture->getConstants().cbegin(); it != architecture->getConstants().cend(); ++it)
+                addConstant(it.key(), it.value());
+            for (auto it = architecture->getSignals().cbegin(); it != architecture->getSignals().cend(); ++it)
+                addSignal(it.key(), it.value()->type, it.value()->location);
+            for (auto it = architecture->getInstances().cbegin(); it != architecture->getInstances().cend(); ++it)
+                addInstance(it.key(), it.value()->unit, it.value()->location);
+            if (architecture->summarized())
+                readSpill(entity, architecture, [&](const NetlistSpill::Record &record) {
+                    if (record.kind == NetlistSpill::Kind::Signal)
+                        addSignal(record.name, record.detail, record.location);
+                    else if (record.kind == NetlistSpill::Kind::Instance)
+                        addInstance(record.name, record.detail, record.location);
+                    return true;
+                });
+        }
+    }
+
+    beginRecord(Tag::End);
+    endRecord();
+}
+
+/******************************************************************************/
+
+void DesignExporter::writeDot()
+{
+    write("digraph design {\n    node [shape=box];\n");
+    for (Entity *entity : _design->getEntities())
+        write("    " + dotString(entity->name()) + ";\n");
+
+    // Instances of the same unit are merged into a single edge, summarized architectures are counted the same way
+    for (Entity *entity : _design->getEntities())
+    {
+        QHash<QString, qint64> counts;
+        for (Architecture *architecture : entity->getArchitectures())
+        {
+            const QHash<QString, qint64> instanceCounts = architecture->instanceCounts();
+            for (auto it = instanceCounts.cbegin(); it != instanceCounts.cend(); ++it)
+                counts[it.key()] += it.value();
+        }
+        for (auto it = counts.cbegin(); it != counts.cend(); ++it)
+            write("    " + dotString(entity->name()) + " -> " + dotString(it.key()) + QString(" [label=\"%1\"];\n").arg(it.value()).toUtf8());
+    }
+    write("}\n");
+}
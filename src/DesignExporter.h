@@ -0,0 +1,99 @@
+/* Lambila | DesignExporter.h
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#ifndef DESIGNEXPORTER_H
+#define DESIGNEXPORTER_H
+
+/******************************************************************************/
+
+#include "Design.h"
+#include "NetlistSpill.h"
+
+#include <QIODevice>
+
+/******************************************************************************/
+
+// Writes the files, packages, entities and architectures of the design, with their ports, signals, constants and
+// instances, for other tools. The design is walked once and written as it goes through a small buffer, so the extra
+// memory does not depend on the size of the design. Elements are written in the order of the design, ports and
+// generics in their declaration order. The signals and instances of summarized architectures are read back from their
+// spill file.
+//
+// JSON: one object, files and packages first, then the entities with their architectures nested.
+// Binary: a sequence of records, each made of a tag byte, the length of its payload and the payload. Integers are
+// 32-bit little-endian, strings are their UTF-8 length followed by their bytes. Generics and ports belong to the last
+// entity, signals, constants and instances to the last architecture, or to the last package for constants.
+// DOT: the instance graph, an edge from each entity to the units its architectures instantiate, labelled with the
+// number of instances.
+class DesignExporter
+{
+public:
+    enum class Format {
+        Json,
+        Binary,
+        Dot
+    };
+
+    // Binary records, a new tag is a new version
+    enum class Tag : quint8 {
+        Header,
+        File,
+        Package,
+        Entity,
+        Generic,
+        Port,
+        Architecture,
+        Signal,
+        Constant,
+        Instance,
+        End = 0xff
+    };
+
+    static const quint32 VERSION = 1;
+
+protected:
+    Design *_design;
+    QIODevice *_device;
+    QByteArray _buffer;
+    bool _failed;
+
+    // Payload of the binary record being written
+    QByteArray _record;
+
+    // Each spill file is indexed the first time one of its architectures is read, then only their runs are read
+    QHash<FileId, NetlistSpill::Index> _spillIndexes;
+
+    void write(const QByteArray &data);
+    bool flush();
+
+    // Reads the records of a summarized architecture from the spill file of its netlist
+    bool readSpill(Entity *entity, Architecture *architecture, const NetlistSpill::Visitor &visitor);
+
+    void writeJson();
+    void writeJsonEntity(Entity *entity);
+    void writeJsonArchitecture(Entity *entity, Architecture *architecture);
+
+    void beginRecord(Tag tag);
+    void addNumber(quint32 number);
+    void addString(const QString &string);
+    void endRecord();
+    void writeBinary();
+
+    void writeDot();
+
+public:
+    DesignExporter(Design *design, QIODevice *device);
+
+    // Format given by the file extension: “.json”, “.lbd” or “.dot” and “.gv”
+    static bool formatFor(const QString &filePath, Format *format);
+
+    bool write(Format format);
+};
+
+/******************************************************************************/
+
+#endif // DESIGNEXPORTER_H
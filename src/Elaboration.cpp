@@ -0,0 +1,599 @@
+/* Lambila | Elaboration.cpp
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#include "Elaboration.h"
+
+#include <QRegularExpression>
+#include <limits>
+
+/******************************************************************************/
+
+// Deepest chain of types followed to find a width, deeper chains are assumed to be circular
+static constexpr int MAX_TYPE_DEPTH = 16;
+
+// Width of the predefined VHDL types and of the Verilog net and variable types
+static int predefinedWidth(const QString &name)
+{
+    static const QHash<QString, int> widths {
+        { "std_logic",  1 },
+        { "std_ulogic", 1 },
+        { "bit",        1 },
+        { "boolean",    1 },
+        { "character",  8 },
+        { "integer",   32 },
+        { "natural",   32 },
+        { "positive",  32 },
+        { "wire",       1 },
+        { "reg",        1 },
+        { "logic",      1 },
+        { "tri",        1 },
+        { "wand",       1 },
+        { "wor",        1 },
+        { "uwire",      1 },
+        { "byte",       8 },
+        { "shortint",  16 },
+        { "int",       32 },
+        { "longint",   64 },
+        { "parameter", 32 },
+        { "localparam", 32 }
+    };
+    return widths.value(name, Elaboration::UNKNOWN_WIDTH);
+}
+
+// Predefined one-dimensional arrays of bits
+static bool isBitVector(const QString &name)
+{
+    static const QSet<QString> names {
+        "std_logic_vector",
+        "std_ulogic_vector",
+        "bit_vector",
+        "boolean_vector",
+        "unsigned",
+        "signed",
+        "ufixed",
+        "sfixed"
+    };
+    return names.contains(name);
+}
+
+// Start of the constraint of a subtype indication: an index constraint, Verilog dimensions or a range constraint
+static int constraintStart(const QString &subtypeIndication)
+{
+    static const QRegularExpression start("\\(|\\[|\\brange\\b", QRegularExpression::CaseInsensitiveOption);
+    return subtypeIndication.indexOf(start);
+}
+
+static bool isRangeConstraint(const QString &constraint)
+{
+    return constraint.startsWith("range", Qt::CaseInsensitive);
+}
+
+/******************************************************************************/
+
+Elaboration::Elaboration()
+{
+    _design = nullptr;
+}
+
+Elaboration::~Elaboration()
+{
+    reset(nullptr);
+}
+
+void Elaboration::reset(Design *design)
+{
+    for (auto context : _contexts)
+    {
+        for (auto architecture : context->architectures)
+            delete architecture;
+        delete context;
+    }
+    _contexts.clear();
+    _packageConstants.clear();
+    _pending.clear();
+    _design = design;
+}
+
+/******************************************************************************/
+
+QString Elaboration::bindingKey(const GenericBinding &binding)
+{
+    // The map is sorted, so that equal bindings give the same key
+    QStringList associations;
+    for (auto it = binding.cbegin(); it != binding.cend(); ++it)
+        associations.append(QString("%1=%2").arg(it.key()).arg(it.value().toString()));
+    return associations.join(',');
+}
+
+Elaboration::Context *Elaboration::context(Entity *entity, const GenericBinding &binding)
+{
+    // Generics that are bound to their default value do not make a new context
+    GenericBinding effective;
+    for (auto it = binding.cbegin(); it != binding.cend(); ++it)
+        if (entity->generic(it.key()) != nullptr && it.value().isValid())
+            effective.insert(it.key().toLower(), it.value());
+
+    const QString key = QString("%1(%2)").arg(entity->name()).arg(bindingKey(effective));
+    Context *context = _contexts.value(key, nullptr);
+    if (context == nullptr)
+    {
+        context = new Context { key, entity, effective, { }, { }, { } };
+        _contexts.insert(key, context);
+    }
+    return context;
+}
+
+Elaboration::ArchitectureContext *Elaboration::architectureContext(Context *context, Architecture *architecture)
+{
+    ArchitectureContext *architectureContext = context->architectures.value(architecture, nullptr);
+    if (architectureContext == nullptr)
+    {
+        architectureContext = new ArchitectureContext;
+        for (auto it = architecture->getConstants().cbegin(); it != architecture->getConstants().cend(); ++it)
+            architectureContext->constants.insert(it.key().toLower(), it.value());
+        context->architectures.insert(architecture, architectureContext);
+    }
+    return architectureContext;
+}
+
+/******************************************************************************/
+
+// Names are looked up in the entity first, then in the architecture, then in the packages made visible by the use clauses
+Elaboration::Value Elaboration::lookup(Context *context, Architecture *architecture, const QString &name)
+{
+    if (context->entity->generic(name) != nullptr)
+        return genericValue(context, name);
+    if (architecture != nullptr && architectureContext(context, architecture)->constants.contains(name))
+        return constantValue(context, architecture, name);
+    const Symbol symbol = _design->lookup(context->entity, name);
+    if (symbol.kind == Symbol::Kind::Constant)
+        return packageConstant(symbol.package, name);
+    return Value();
+}
+
+Elaboration::Value Elaboration::genericValue(Context *context, const QString &name)
+{
+    auto cached = context->generics.constFind(name);
+    if (cached != context->generics.cend())
+        return *cached;
+
+    Value value = context->binding.value(name);
+    const QString pendingKey = QString("%1.%2").arg(context->key).arg(name);
+    if (!value.isValid() && !_pending.contains(pendingKey))
+    {
+        // Defaults may refer to the generics declared before them
+        _pending.insert(pendingKey);
+        value = ExpressionEvaluator::evaluate(context->entity->generic(name)->value, [=](const QString &identifier) {
+            return lookup(context, nullptr, identifier);
+        });
+        _pending.remove(pendingKey);
+    }
+    context->generics.insert(name, value);
+    return value;
+}
+
+Elaboration::Value Elaboration::constantValue(Context *context, Architecture *architecture, const QString &name)
+{
+    ArchitectureContext *architectureContext = this->architectureContext(context, architecture);
+    auto cached = architectureContext->constantValues.constFind(name);
+    if (cached != architectureContext->constantValues.cend())
+        return *cached;
+
+    Value value;
+    const QString pendingKey = QString("%1.%2.%3").arg(context->key).arg(architecture->name()).arg(name);
+    if (!_pending.contains(pendingKey))
+    {
+        _pending.insert(pendingKey);
+        value = ExpressionEvaluator::evaluate(architectureContext->constants.value(name)->value, [=](const QString &identifier) {
+            return lookup(context, architecture, identifier);
+        });
+        _pending.remove(pendingKey);
+    }
+    architectureContext->constantValues.insert(name, value);
+    return value;
+}
+
+// Package constants do not depend on any generic, they are shared by all the contexts
+Elaboration::Value Elaboration::packageConstant(Package *package, const QString &name)
+{
+    const QString key = QString("%1.%2").arg(package->name().toLower()).arg(name);
+    auto cached = _packageConstants.constFind(key);
+    if (cached != _packageConstants.cend())
+        return *cached;
+
+    Value value;
+    // The constants of the body are visible to the deferred constants it completes
+    Constant *constant = package->constant(name);
+    if (constant == nullptr)
+        constant = package->bodyConstant(name);
+    if (constant != nullptr && !_pending.contains(key))
+    {
+        _pending.insert(key);
+        value = ExpressionEvaluator::evaluate(constant->value, [=](const QString &identifier) {
+            const bool known = package->symbol(identifier) == Symbol::Kind::Constant || package->bodyConstant(identifier) != nullptr;
+            return known ? packageConstant(package, identifier) : Value();
+        });
+        _pending.remove(key);
+    }
+    _packageConstants.insert(key, value);
+    return value;
+}
+
+/******************************************************************************/
+
+int Elaboration::typeWidth(TypeId typeId, const ExpressionEvaluator::Lookup &lookup, int depth)
+{
+    Type *type = _design->type(typeId);
+    if (type == nullptr || depth > MAX_TYPE_DEPTH)
+        return UNKNOWN_WIDTH;
+    // Types of the library summaries are declared, but std_ulogic is still a single bit
+    if (type->file() == INVALID_FILE_ID && predefinedWidth(type->name().section('.', -1)) != UNKNOWN_WIDTH)
+        return predefinedWidth(type->name().section('.', -1));
+
+    switch (type->kind())
+    {
+    case Type::Kind::Unresolved:
+        // Types of the standard libraries are not parsed
+        return predefinedWidth(type->name().section('.', -1));
+    case Type::Kind::Enumeration:
+        return ExpressionEvaluator::bitsFor(type->literals().count());
+    case Type::Kind::Scalar:
+    {
+        const QList<Value> ranges = ExpressionEvaluator::evaluateConstraint(type->constraint(), lookup);
+        if (ranges.count() != 1 || !ranges.first().isValid())
+            return UNKNOWN_WIDTH;
+        return ExpressionEvaluator::bitsFor(ranges.first().length());
+    }
+    case Type::Kind::Array:
+        return constrainedWidth(type->constraint(), typeWidth(type->elementType(), lookup, depth + 1), lookup);
+    case Type::Kind::Record:
+    {
+        int width = 0;
+        for (TypeId field : type->fieldTypes())
+        {
+            const int fieldWidth = typeWidth(field, lookup, depth + 1);
+            if (fieldWidth == UNKNOWN_WIDTH)
+                return UNKNOWN_WIDTH;
+            width += fieldWidth;
+        }
+        return width;
+    }
+    case Type::Kind::Subtype:
+        if (type->constraint().isEmpty())
+            return typeWidth(type->baseType(), lookup, depth + 1);
+        if (isRangeConstraint(type->constraint()))
+        {
+            const QList<Value> ranges = ExpressionEvaluator::evaluateConstraint(type->constraint(), lookup);
+            if (ranges.count() != 1 || !ranges.first().isValid())
+                return UNKNOWN_WIDTH;
+            return ExpressionEvaluator::bitsFor(ranges.first().length());
+        }
+        return constrainedWidth(type->constraint(), elementWidth(type->baseType(), lookup, depth + 1), lookup);
+    default:
+        return UNKNOWN_WIDTH;
+    }
+}
+
+// Width of the elements of an array type, which can still be constrained
+int Elaboration::elementWidth(TypeId typeId, const ExpressionEvaluator::Lookup &lookup, int depth)
+{
+    Type *type = _design->type(typeId);
+    if (type == nullptr || depth > MAX_TYPE_DEPTH)
+        return UNKNOWN_WIDTH;
+
+    switch (type->kind())
+    {
+    case Type::Kind::Unresolved:
+        // Verilog dimensions apply to the net or variable type itself
+        if (isBitVector(type->name().section('.', -1)))
+            return 1;
+        return predefinedWidth(type->name().section('.', -1));
+    case Type::Kind::Array:
+        return typeWidth(type->elementType(), lookup, depth + 1);
+    case Type::Kind::Subtype:
+        return elementWidth(type->baseType(), lookup, depth + 1);
+    default:
+        return UNKNOWN_WIDTH;
+    }
+}
+
+int Elaboration::constrainedWidth(const QString &constraint, int elementWidth, const ExpressionEvaluator::Lookup &lookup)
+{
+    if (elementWidth == UNKNOWN_WIDTH)
+        return UNKNOWN_WIDTH;
+
+    // All the dimensions are multiplied, an unconstrained array has no static width
+    const QList<Value> ranges = ExpressionEvaluator::evaluateConstraint(constraint, lookup);
+    if (ranges.isEmpty())
+        return UNKNOWN_WIDTH;
+    qint64 width = elementWidth;
+    for (const Value &range : ranges)
+    {
+        if (range.kind == Value::Kind::Range)
+            width *= range.length();
+        // Verilog unpacked dimensions can be given as a size
+        else if (range.kind == Value::Kind::Integer && range.left >= 0)
+            width *= range.left;
+        else
+            return UNKNOWN_WIDTH;
+        if (width > std::numeric_limits<int>::max())
+            return UNKNOWN_WIDTH;
+    }
+    return static_cast<int>(width);
+}
+
+int Elaboration::subtypeWidth(const QString &subtypeIndication, TypeId typeId, const ExpressionEvaluator::Lookup &lookup)
+{
+    const int start = constraintStart(subtypeIndication);
+    if (start < 0)
+        return typeWidth(typeId, lookup);
+
+    const QString constraint = subtypeIndication.mid(start);
+    if (isRangeConstraint(constraint))
+    {
+        const QList<Value> ranges = ExpressionEvaluator::evaluateConstraint(constraint, lookup);
+        if (ranges.count() != 1 || !ranges.first().isValid())
+            return UNKNOWN_WIDTH;
+        return ExpressionEvaluator::bitsFor(ranges.first().length());
+    }
+
+    // Verilog vectors without a net type are wires
+    if (subtypeIndication.left(start).trimmed().isEmpty())
+        return constrainedWidth(constraint, 1, lookup);
+    return constrainedWidth(constraint, elementWidth(typeId, lookup, 0), lookup);
+}
+
+/******************************************************************************/
+
+// Value taken by the loop parameter of a for-generate on the given iteration
+static qint64 iterationValue(const ExpressionEvaluator::Value &range, qint64 iteration)
+{
+    return range.ascending ? range.left + iteration : range.left - iteration;
+}
+
+Elaboration::Value Elaboration::schemeValue(Context *context, Architecture *architecture, int generate, const GenericBinding &parameters, bool *dependent)
+{
+    ArchitectureContext *architectureContext = this->architectureContext(context, architecture);
+    auto cached = architectureContext->schemeValues.constFind(generate);
+    if (cached != architectureContext->schemeValues.cend())
+        return *cached;
+
+    // Loop parameters hide the other names
+    bool usesParameters = false;
+    const Generate &statement = architecture->generate(generate);
+    const ExpressionEvaluator::Lookup lookup = [&](const QString &identifier) {
+        auto parameter = parameters.constFind(identifier);
+        if (parameter == parameters.cend())
+            return this->lookup(context, architecture, identifier);
+        usesParameters = true;
+        return *parameter;
+    };
+    const Value value = (statement.kind == Generate::Kind::For) ? ExpressionEvaluator::evaluateRange(statement.scheme, lookup)
+                                                                : ExpressionEvaluator::evaluate(statement.scheme, lookup);
+    if (usesParameters)
+        *dependent = true;
+    else
+        architectureContext->schemeValues.insert(generate, value);
+    return value;
+}
+
+// Copies made by the generate statements of the chain from the given level, the parameters of the outer levels being bound
+qint64 Elaboration::copyCount(Context *context, Architecture *architecture, const QList<int> &chain, int level, GenericBinding &parameters, bool *dependent)
+{
+    if (level == chain.count())
+        return 1;
+
+    const Generate &generate = architecture->generate(chain.at(level));
+    const Value scheme = schemeValue(context, architecture, chain.at(level), parameters, dependent);
+    if (generate.kind == Generate::Kind::If)
+    {
+        if (scheme.kind != Value::Kind::Boolean)
+            return UNKNOWN_COUNT;
+        return (scheme.left != 0) ? copyCount(context, architecture, chain, level + 1, parameters, dependent) : 0;
+    }
+    if (scheme.kind != Value::Kind::Range)
+        return UNKNOWN_COUNT;
+
+    // Inner schemes rarely depend on the parameter, then all the iterations have the same count
+    const QString parameter = generate.parameter.toLower();
+    qint64 count = 0;
+    for (qint64 iteration = 0; iteration < scheme.length(); ++iteration)
+    {
+        bool innerDependent = false;
+        parameters.insert(parameter, Value::integer(iterationValue(scheme, iteration)));
+        const qint64 inner = copyCount(context, architecture, chain, level + 1, parameters, &innerDependent);
+        if (inner == UNKNOWN_COUNT)
+        {
+            count = UNKNOWN_COUNT;
+            break;
+        }
+        if (!innerDependent)
+        {
+            count = inner * scheme.length();
+            break;
+        }
+        *dependent = true;
+        count += inner;
+    }
+    parameters.remove(parameter);
+    return count;
+}
+
+// Bind the parameters of the generate statements of the chain for one of the copies
+bool Elaboration::selectCopy(Context *context, Architecture *architecture, const QList<int> &chain, int level, qint64 index, GenericBinding &parameters)
+{
+    if (level == chain.count())
+        return index == 0;
+
+    bool dependent = false;
+    const Generate &generate = architecture->generate(chain.at(level));
+    const Value scheme = schemeValue(context, architecture, chain.at(level), parameters, &dependent);
+    if (generate.kind == Generate::Kind::If)
+        return scheme.kind == Value::Kind::Boolean && scheme.left != 0 && selectCopy(context, architecture, chain, level + 1, index, parameters);
+    if (scheme.kind != Value::Kind::Range)
+        return false;
+
+    const QString parameter = generate.parameter.toLower();
+    for (qint64 iteration = 0; iteration < scheme.length(); ++iteration)
+    {
+        bool innerDependent = false;
+        parameters.insert(parameter, Value::integer(iterationValue(scheme, iteration)));
+        const qint64 inner = copyCount(context, architecture, chain, level + 1, parameters, &innerDependent);
+        if (inner == UNKNOWN_COUNT)
+            return false;
+        if (!innerDependent)
+        {
+            // Same count on every iteration, the iteration is found by a division
+            if (inner == 0 || index >= inner * scheme.length())
+                return false;
+            parameters.insert(parameter, Value::integer(iterationValue(scheme, index / inner)));
+            return selectCopy(context, architecture, chain, level + 1, index % inner, parameters);
+        }
+        if (index < inner)
+            return selectCopy(context, architecture, chain, level + 1, index, parameters);
+        index -= inner;
+    }
+    return false;
+}
+
+/******************************************************************************/
+
+Elaboration::Value Elaboration::generic(Entity *entity, const GenericBinding &binding, const QString &name)
+{
+    if (_design == nullptr || entity == nullptr || entity->generic(name) == nullptr)
+        return Value();
+    return genericValue(context(entity, binding), name.trimmed().toLower());
+}
+
+Elaboration::Value Elaboration::constant(Entity *entity, Architecture *architecture, const GenericBinding &binding, const QString &name)
+{
+    if (_design == nullptr || entity == nullptr || architecture == nullptr)
+        return Value();
+    Context *context = this->context(entity, binding);
+    const QString key = name.trimmed().toLower();
+    if (!architectureContext(context, architecture)->constants.contains(key))
+        return Value();
+    return constantValue(context, architecture, key);
+}
+
+int Elaboration::portWidth(Entity *entity, const GenericBinding &binding, const QString &port)
+{
+    if (_design == nullptr || entity == nullptr)
+        return UNKNOWN_WIDTH;
+    Port *declaration = entity->port(port);
+    if (declaration == nullptr)
+        return UNKNOWN_WIDTH;
+
+    Context *context = this->context(entity, binding);
+    auto cached = context->portWidths.constFind(port);
+    if (cached != context->portWidths.cend())
+        return *cached;
+    const int width = subtypeWidth(declaration->type, declaration->typeId, [=](const QString &identifier) {
+        return lookup(context, nullptr, identifier);
+    });
+    context->portWidths.insert(port, width);
+    return width;
+}
+
+int Elaboration::signalWidth(Entity *entity, Architecture *architecture, const GenericBinding &binding, const QString &signal)
+{
+    if (_design == nullptr || entity == nullptr || architecture == nullptr)
+        return UNKNOWN_WIDTH;
+    Signal *declaration = architecture->signal(signal);
+    if (declaration == nullptr)
+        return UNKNOWN_WIDTH;
+
+    Context *context = this->context(entity, binding);
+    ArchitectureContext *architectureContext = this->architectureContext(context, architecture);
+    auto cached = architectureContext->signalWidths.constFind(signal);
+    if (cached != architectureContext->signalWidths.cend())
+        return *cached;
+    const int width = subtypeWidth(declaration->type, declaration->typeId, [=](const QString &identifier) {
+        return lookup(context, architecture, identifier);
+    });
+    architectureContext->signalWidths.insert(signal, width);
+    return width;
+}
+
+qint64 Elaboration::instanceCount(Entity *entity, Architecture *architecture, const GenericBinding &binding, const QString &instance)
+{
+    if (_design == nullptr || entity == nullptr || architecture == nullptr)
+        return UNKNOWN_COUNT;
+    Instance *declaration = architecture->instance(instance);
+    if (declaration == nullptr)
+        return UNKNOWN_COUNT;
+
+    Context *context = this->context(entity, binding);
+    ArchitectureContext *architectureContext = this->architectureContext(context, architecture);
+    auto cached = architectureContext->instanceCounts.constFind(instance);
+    if (cached != architectureContext->instanceCounts.cend())
+        return *cached;
+    bool dependent = false;
+    GenericBinding parameters;
+    const qint64 count = copyCount(context, architecture, architecture->generateChain(declaration->generate), 0, parameters, &dependent);
+    architectureContext->instanceCounts.insert(instance, count);
+    return count;
+}
+
+QString Elaboration::instancePath(Entity *entity, Architecture *architecture, const GenericBinding &binding, const QString &instance, qint64 index, GenericBinding *parameters)
+{
+    if (_design == nullptr || entity == nullptr || architecture == nullptr)
+        return QString();
+    Instance *declaration = architecture->instance(instance);
+    if (declaration == nullptr)
+        return QString();
+
+    const QList<int> chain = architecture->generateChain(declaration->generate);
+    GenericBinding values;
+    if (!selectCopy(context(entity, binding), architecture, chain, 0, index, values))
+        return QString();
+
+    QStringList path;
+    for (int generate : chain)
+    {
+        const Generate &statement = architecture->generate(generate);
+        if (statement.kind == Generate::Kind::For)
+            path.append(QString("%1(%2)").arg(statement.label).arg(values.value(statement.parameter.toLower()).toString()));
+        else
+            path.append(statement.label);
+    }
+    path.append(instance.section('.', -1));
+    if (parameters != nullptr)
+        *parameters = values;
+    return path.join('.');
+}
+
+Elaboration::GenericBinding Elaboration::instanceBinding(Entity *entity, Architecture *architecture, const GenericBinding &binding, const QString &instance, const GenericBinding &parameters)
+{
+    GenericBinding generics;
+    if (_design == nullptr || entity == nullptr || architecture == nullptr)
+        return generics;
+    Instance *declaration = architecture->instance(instance);
+    Entity *instantiated = (declaration != nullptr) ? _design->entity(declaration->unit) : nullptr;
+    if (instantiated == nullptr)
+        return generics;
+
+    Context *context = this->context(entity, binding);
+    const ExpressionEvaluator::Lookup lookup = [&](const QString &identifier) {
+        auto parameter = parameters.constFind(identifier);
+        if (parameter == parameters.cend())
+            return this->lookup(context, architecture, identifier);
+        return *parameter;
+    };
+    for (int i = 0; i < declaration->genericMap.count(); ++i)
+    {
+        // Positional associations follow the declaration order of the generics
+        const Association &association = declaration->genericMap.at(i);
+        const QString formal = association.formal.isEmpty() ? instantiated->genericNames().value(i) : association.formal;
+        if (formal.isEmpty() || instantiated->generic(formal) == nullptr)
+            continue;
+        const Value value = ExpressionEvaluator::evaluate(association.actual, lookup);
+        if (value.isValid())
+            generics.insert(formal.trimmed().toLower(), value);
+    }
+    return generics;
+}
@@ -0,0 +1,105 @@
+/* Lambila | Elaboration.h
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#ifndef ELABORATION_H
+#define ELABORATION_H
+
+/******************************************************************************/
+
+#include "Design.h"
+#include "ExpressionEvaluator.h"
+
+#include <QMap>
+
+/******************************************************************************/
+
+// Static values of an entity once its generics are bound: generics, constants and the widths of ports and signals.
+// Everything is evaluated on demand and memoized per (entity, generic binding), so that entities instantiated
+// many times with the same generics are only evaluated once.
+// Generate statements are not unrolled: the copies of an instance are counted, and one copy is only named
+// when it is asked for.
+class Elaboration
+{
+public:
+    typedef ExpressionEvaluator::Value Value;
+    // Values of the generics, by name in lower case. Generics that are not bound take their default value.
+    typedef QMap<QString, Value> GenericBinding;
+
+    static constexpr int UNKNOWN_WIDTH = -1;
+    static constexpr qint64 UNKNOWN_COUNT = -1;
+
+protected:
+    struct ArchitectureContext {
+        // Constants are indexed in lower case, like the names given to the lookup
+        QHash<QString, Constant *> constants;
+        QHash<QString, Value> constantValues;
+        QHash<QString, int> signalWidths;
+        // Schemes of the generate statements that do not depend on the parameters of enclosing ones
+        QHash<int, Value> schemeValues;
+        QHash<QString, qint64> instanceCounts;
+    };
+
+    struct Context {
+        QString key;
+        Entity *entity;
+        GenericBinding binding;
+        QHash<QString, Value> generics;
+        QHash<QString, int> portWidths;
+        QHash<Architecture *, ArchitectureContext *> architectures;
+    };
+
+    Design *_design;
+    QHash<QString, Context *> _contexts;
+    QHash<QString, Value> _packageConstants;
+    // Values being evaluated, to stop on circular definitions
+    QSet<QString> _pending;
+
+    Context *context(Entity *entity, const GenericBinding &binding);
+    ArchitectureContext *architectureContext(Context *context, Architecture *architecture);
+
+    Value lookup(Context *context, Architecture *architecture, const QString &name);
+    Value genericValue(Context *context, const QString &name);
+    Value constantValue(Context *context, Architecture *architecture, const QString &name);
+    Value packageConstant(Package *package, const QString &name);
+
+    int typeWidth(TypeId typeId, const ExpressionEvaluator::Lookup &lookup, int depth = 0);
+    int elementWidth(TypeId typeId, const ExpressionEvaluator::Lookup &lookup, int depth);
+    int constrainedWidth(const QString &constraint, int elementWidth, const ExpressionEvaluator::Lookup &lookup);
+    int subtypeWidth(const QString &subtypeIndication, TypeId typeId, const ExpressionEvaluator::Lookup &lookup);
+
+    Value schemeValue(Context *context, Architecture *architecture, int generate, const GenericBinding &parameters, bool *dependent);
+    qint64 copyCount(Context *context, Architecture *architecture, const QList<int> &chain, int level, GenericBinding &parameters, bool *dependent);
+    bool selectCopy(Context *context, Architecture *architecture, const QList<int> &chain, int level, qint64 index, GenericBinding &parameters);
+
+public:
+    Elaboration();
+    ~Elaboration();
+
+    // Forget all the values, they have to be evaluated again after each refresh
+    void reset(Design *design);
+
+    static QString bindingKey(const GenericBinding &binding);
+
+    Value generic(Entity *entity, const GenericBinding &binding, const QString &name);
+    Value constant(Entity *entity, Architecture *architecture, const GenericBinding &binding, const QString &name);
+
+    // Widths in bits, UNKNOWN_WIDTH if they cannot be evaluated statically
+    int portWidth(Entity *entity, const GenericBinding &binding, const QString &port);
+    int signalWidth(Entity *entity, Architecture *architecture, const GenericBinding &binding, const QString &signal);
+
+    // Number of copies of an instance once its generate statements are unrolled, UNKNOWN_COUNT if a scheme cannot be evaluated
+    qint64 instanceCount(Entity *entity, Architecture *architecture, const GenericBinding &binding, const QString &instance);
+    // One of these copies, named after the values of the generate parameters as in “rows(2).columns(5).cell”.
+    // The parameters are returned in lower case, so that they can be used to evaluate the generics of the copy.
+    QString instancePath(Entity *entity, Architecture *architecture, const GenericBinding &binding, const QString &instance, qint64 index, GenericBinding *parameters = nullptr);
+    // Generics of the instantiated entity, from the generic map evaluated with the given generate parameters
+    GenericBinding instanceBinding(Entity *entity, Architecture *architecture, const GenericBinding &binding, const QString &instance, const GenericBinding &parameters = GenericBinding());
+};
+
+/******************************************************************************/
+
+#endif // ELABORATION_H
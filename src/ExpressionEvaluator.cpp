@@ -0,0 +1,512 @@
+/* Lambila | ExpressionEvaluator.cpp
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#include "ExpressionEvaluator.h"
+
+#include <limits>
+
+/******************************************************************************/
+
+// Delimiters made of two characters, checked before single characters
+static const char *const COMPOUND_DELIMITERS[] = { "**", "/=", "==", "!=", "<=", ">=", "&&", "||", "<<", ">>" };
+
+static bool isWordCharacter(QChar c)
+{
+    return c.isLetterOrNumber() || c == '_' || c == '$';
+}
+
+// Split an expression into lower case tokens: words, numbers and delimiters
+static QStringList tokenize(const QString &text)
+{
+    QStringList tokens;
+    const int length = text.length();
+    int i = 0;
+    while (i < length)
+    {
+        const QChar c = text.at(i);
+        const QChar next = (i + 1 < length) ? text.at(i + 1) : QChar();
+        const int start = i;
+        if (c.isSpace())
+        {
+            i += 1;
+            continue;
+        }
+
+        // Verilog numbers can start with the base, unless the tick is an attribute
+        const bool afterName = !tokens.isEmpty() && (isWordCharacter(tokens.last().at(0)) || tokens.last() == ")");
+        if (c.isDigit() || (c == '\'' && !afterName && QString("bodhBODHsS").contains(next)))
+        {
+            while (i < length && (text.at(i).isLetterOrNumber() || text.at(i) == '_' || text.at(i) == '.'))
+                i += 1;
+            if (i < length && text.at(i) == '#')
+            {
+                // VHDL based literal
+                const int end = text.indexOf('#', i + 1);
+                i = (end < 0) ? length : end + 1;
+            }
+            else if (i < length && text.at(i) == '\'')
+            {
+                // Verilog sized literal
+                i += 1;
+                while (i < length && (text.at(i).isLetterOrNumber() || text.at(i) == '_' || text.at(i) == '?'))
+                    i += 1;
+            }
+        }
+        else if (c.isLetter() || c == '_' || c == '$')
+        {
+            while (i < length && isWordCharacter(text.at(i)))
+                i += 1;
+        }
+        else
+        {
+            i += 1;
+            for (const char *delimiter : COMPOUND_DELIMITERS)
+                if (c == delimiter[0] && next == delimiter[1])
+                    i = start + 2;
+        }
+        tokens.append(text.mid(start, i - start).toLower());
+    }
+    return tokens;
+}
+
+// Integer literals, in VHDL or Verilog notation
+static ExpressionEvaluator::Value parseNumber(QString token)
+{
+    typedef ExpressionEvaluator::Value Value;
+    token.remove('_');
+    int base = 10;
+    QString digits = token;
+    qint64 exponent = 0;
+    if (token.contains('#'))
+    {
+        base = token.section('#', 0, 0).toInt();
+        digits = token.section('#', 1, 1);
+        const QString exponentPart = token.section('#', 2);
+        if (exponentPart.startsWith('e'))
+            exponent = exponentPart.mid(1).toLongLong();
+    }
+    else if (token.contains('\''))
+    {
+        // The size is ignored, the value is only meaningful as an integer
+        QString suffix = token.section('\'', 1);
+        if (suffix.startsWith('s'))
+            suffix.remove(0, 1);
+        switch (suffix.isEmpty() ? 'd' : suffix.at(0).toLatin1())
+        {
+        case 'b': base = 2; break;
+        case 'o': base = 8; break;
+        case 'h': base = 16; break;
+        default: base = 10; break;
+        }
+        digits = suffix.mid(1);
+    }
+    else if (token.contains('e'))
+    {
+        digits = token.section('e', 0, 0);
+        exponent = token.section('e', 1).toLongLong();
+    }
+
+    // Reals, as well as Verilog unknown and high impedance digits, have no integer value
+    bool ok = false;
+    qint64 value = digits.toLongLong(&ok, base);
+    if (!ok || exponent < 0)
+        return Value();
+    // Values that do not fit in 64 bits have no integer value either
+    for (qint64 e = 0; e < exponent && value != 0; ++e)
+        if (__builtin_mul_overflow(value, static_cast<qint64>(base), &value))
+            return Value();
+    return Value::integer(value);
+}
+
+/******************************************************************************/
+
+// Recursive descent parser, evaluating while parsing.
+// Operators of both languages are accepted, with the VHDL precedence.
+class ExpressionEvaluator::Parser
+{
+protected:
+    const QStringList &_tokens;
+    const Lookup &_lookup;
+    int _position;
+
+    QString peek(int offset = 0) const
+    {
+        return _tokens.value(_position + offset);
+    }
+    bool accept(const QString &token)
+    {
+        if (peek() != token)
+            return false;
+        _position += 1;
+        return true;
+    }
+    bool acceptAny(std::initializer_list<const char *> tokens, QString *accepted)
+    {
+        for (const char *token : tokens)
+        {
+            if (peek() == QLatin1String(token))
+            {
+                *accepted = peek();
+                _position += 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static Value binary(const QString &op, const Value &a, const Value &b)
+    {
+        if (!a.isValid() || !b.isValid())
+            return Value();
+        if (a.kind == Value::Kind::Boolean && b.kind == Value::Kind::Boolean)
+        {
+            const bool x = a.left != 0;
+            const bool y = b.left != 0;
+            if (op == "and" || op == "&&") return Value::boolean(x && y);
+            if (op == "or" || op == "||")  return Value::boolean(x || y);
+            if (op == "xor")               return Value::boolean(x != y);
+            if (op == "nand")              return Value::boolean(!(x && y));
+            if (op == "nor")               return Value::boolean(!(x || y));
+            if (op == "=" || op == "==")   return Value::boolean(x == y);
+            if (op == "/=" || op == "!=")  return Value::boolean(x != y);
+            return Value();
+        }
+        if (a.kind != Value::Kind::Integer || b.kind != Value::Kind::Integer)
+            return Value();
+        const qint64 x = a.left;
+        const qint64 y = b.left;
+        // Results that overflow 64 bits are not known
+        qint64 result;
+        if (op == "+")                 return __builtin_add_overflow(x, y, &result) ? Value() : Value::integer(result);
+        if (op == "-")                 return __builtin_sub_overflow(x, y, &result) ? Value() : Value::integer(result);
+        if (op == "*")                 return __builtin_mul_overflow(x, y, &result) ? Value() : Value::integer(result);
+        if (op == "=" || op == "==")   return Value::boolean(x == y);
+        if (op == "/=" || op == "!=")  return Value::boolean(x != y);
+        if (op == "<")                 return Value::boolean(x < y);
+        if (op == "<=")                return Value::boolean(x <= y);
+        if (op == ">")                 return Value::boolean(x > y);
+        if (op == ">=")                return Value::boolean(x >= y);
+        if (op == "<<" || op == "sll") return (y >= 0 && y < 63) ? Value::integer(x << y) : Value();
+        if (op == ">>" || op == "srl") return (y >= 0 && y < 63) ? Value::integer(x >> y) : Value();
+        if (op == "**")
+        {
+            if (y < 0 || y > 63)
+                return Value();
+            result = 1;
+            for (qint64 i = 0; i < y; ++i)
+                if (__builtin_mul_overflow(result, x, &result))
+                    return Value();
+            return Value::integer(result);
+        }
+        if (y == 0 || (x == std::numeric_limits<qint64>::min() && y == -1))
+            return Value();
+        if (op == "/")                 return Value::integer(x / y);
+        if (op == "rem" || op == "%")  return Value::integer(x % y);
+        // The result of mod has the sign of the right operand
+        if (op == "mod")
+        {
+            result = x % y;
+            return Value::integer((result != 0 && (result < 0) != (y < 0)) ? result + y : result);
+        }
+        return Value();
+    }
+
+    Value call(const QString &name, const QList<Value> &arguments)
+    {
+        for (const Value &argument : arguments)
+            if (argument.kind != Value::Kind::Integer)
+                return Value();
+        if (arguments.count() == 1 && (name == "$clog2" || name == "clog2" || name == "log2ceil" || name == "ceil_log2"))
+            return Value::integer(bitsFor(arguments.first().left));
+        if (arguments.count() == 2 && (name == "maximum" || name == "max"))
+            return Value::integer(qMax(arguments.at(0).left, arguments.at(1).left));
+        if (arguments.count() == 2 && (name == "minimum" || name == "min"))
+            return Value::integer(qMin(arguments.at(0).left, arguments.at(1).left));
+        // Type conversions
+        if (arguments.count() == 1 && (name == "integer" || name == "natural" || name == "positive"))
+            return arguments.first();
+        return Value();
+    }
+
+    Value primary()
+    {
+        const QString token = peek();
+        if (token.isEmpty())
+            return Value();
+        _position += 1;
+        if (token == "(")
+        {
+            const Value value = expression();
+            return accept(")") ? value : Value();
+        }
+        if (token.at(0).isDigit() || token.at(0) == '\'')
+            return parseNumber(token);
+        if (token == "true")
+            return Value::boolean(true);
+        if (token == "false")
+            return Value::boolean(false);
+        if (!isWordCharacter(token.at(0)))
+            return Value();
+
+        // Function call, or plain name
+        if (accept("("))
+        {
+            QList<Value> arguments;
+            do
+                arguments.append(expression());
+            while (accept(","));
+            return accept(")") ? call(token, arguments) : Value();
+        }
+        // Attributes are not supported
+        if (peek() == "'")
+            return Value();
+        return _lookup(token);
+    }
+
+    Value unary()
+    {
+        QString op;
+        if (acceptAny({ "abs", "not", "!", "-", "+" }, &op))
+        {
+            const Value value = unary();
+            if ((op == "abs" || op == "-") && value.kind == Value::Kind::Integer && value.left == std::numeric_limits<qint64>::min())
+                return Value();
+            if (op == "abs" && value.kind == Value::Kind::Integer)
+                return Value::integer(qAbs(value.left));
+            if ((op == "not" || op == "!") && value.kind == Value::Kind::Boolean)
+                return Value::boolean(value.left == 0);
+            if (op == "-" && value.kind == Value::Kind::Integer)
+                return Value::integer(-value.left);
+            if (op == "+" && value.kind == Value::Kind::Integer)
+                return value;
+            return Value();
+        }
+        return primary();
+    }
+
+    Value factor()
+    {
+        Value value = unary();
+        QString op;
+        while (acceptAny({ "**" }, &op))
+            value = binary(op, value, unary());
+        return value;
+    }
+
+    Value term()
+    {
+        Value value = factor();
+        QString op;
+        while (acceptAny({ "*", "/", "mod", "rem", "%" }, &op))
+            value = binary(op, value, factor());
+        return value;
+    }
+
+    Value additive()
+    {
+        // In VHDL, a leading sign applies to the whole first term
+        QString op;
+        Value value;
+        if (acceptAny({ "-", "+" }, &op))
+            value = binary(op, Value::integer(0), term());
+        else
+            value = term();
+        while (acceptAny({ "+", "-" }, &op))
+            value = binary(op, value, term());
+        return value;
+    }
+
+    Value shift()
+    {
+        Value value = additive();
+        QString op;
+        while (acceptAny({ "<<", ">>", "sll", "srl" }, &op))
+            value = binary(op, value, additive());
+        return value;
+    }
+
+    Value relation()
+    {
+        Value value = shift();
+        QString op;
+        if (acceptAny({ "=", "==", "/=", "!=", "<", "<=", ">", ">=" }, &op))
+            value = binary(op, value, shift());
+        return value;
+    }
+
+    Value logical()
+    {
+        Value value = relation();
+        QString op;
+        while (acceptAny({ "and", "or", "xor", "nand", "nor", "&&", "||" }, &op))
+            value = binary(op, value, relation());
+        return value;
+    }
+
+public:
+    Parser(const QStringList &tokens, const Lookup &lookup) : _tokens(tokens), _lookup(lookup)
+    {
+        _position = 0;
+    }
+
+    bool atEnd() const
+    {
+        return _position >= _tokens.count();
+    }
+
+    Value expression()
+    {
+        const Value condition = logical();
+        if (!accept("?"))
+            return condition;
+        const Value whenTrue = expression();
+        if (!accept(":"))
+            return Value();
+        const Value whenFalse = expression();
+        if (condition.kind != Value::Kind::Boolean && condition.kind != Value::Kind::Integer)
+            return Value();
+        return (condition.left != 0) ? whenTrue : whenFalse;
+    }
+};
+
+/******************************************************************************/
+
+QString ExpressionEvaluator::Value::toString() const
+{
+    switch (kind)
+    {
+    case Kind::Integer: return QString::number(left);
+    case Kind::Boolean: return left ? "true" : "false";
+    case Kind::Range:   return QString("%1 %2 %3").arg(left).arg(ascending ? "to" : "downto").arg(right);
+    default:            return "?";
+    }
+}
+
+ExpressionEvaluator::Value ExpressionEvaluator::evaluateTokens(const QStringList &tokens, const Lookup &lookup)
+{
+    Parser parser(tokens, lookup);
+    const Value value = parser.expression();
+    return parser.atEnd() ? value : Value();
+}
+
+ExpressionEvaluator::Value ExpressionEvaluator::evaluate(const QString &expression, const Lookup &lookup)
+{
+    return evaluateTokens(tokenize(expression), lookup);
+}
+
+// Split a token list at the given separator, outside of parentheses and brackets
+static QList<QStringList> splitTokens(const QStringList &tokens, const QString &separator)
+{
+    QList<QStringList> parts { QStringList() };
+    int depth = 0;
+    for (const QString &token : tokens)
+    {
+        if (token == "(" || token == "[")
+            depth += 1;
+        else if (token == ")" || token == "]")
+            depth -= 1;
+        else if (depth == 0 && token == separator)
+        {
+            parts.append(QStringList());
+            continue;
+        }
+        parts.last().append(token);
+    }
+    return parts;
+}
+
+ExpressionEvaluator::Value ExpressionEvaluator::evaluateRangeTokens(QStringList tokens, const Lookup &lookup)
+{
+    // Only keep the range of “integer range 0 to 7”
+    const int rangeKeyword = tokens.indexOf("range");
+    if (rangeKeyword >= 0)
+        tokens = tokens.mid(rangeKeyword + 1);
+
+    for (const char *direction : { "to", "downto", ":" })
+    {
+        // A colon is part of a conditional expression when there is a question mark
+        if (QLatin1String(direction) == ":" && tokens.contains("?"))
+            continue;
+        const QList<QStringList> bounds = splitTokens(tokens, direction);
+        if (bounds.count() != 2)
+            continue;
+        const Value left = evaluateTokens(bounds.first(), lookup);
+        const Value right = evaluateTokens(bounds.last(), lookup);
+        if (left.kind != Value::Kind::Integer || right.kind != Value::Kind::Integer)
+            return Value();
+        // Verilog ranges are written [msb:lsb], in any direction
+        const bool ascending = (QLatin1String(direction) == "to") || (QLatin1String(direction) == ":" && left.left < right.left);
+        return Value::range(left.left, right.left, ascending);
+    }
+
+    // The name of a subtype, or of a range constant
+    const Value value = evaluateTokens(tokens, lookup);
+    return (value.kind == Value::Kind::Range) ? value : Value();
+}
+
+ExpressionEvaluator::Value ExpressionEvaluator::evaluateRange(const QString &range, const Lookup &lookup)
+{
+    return evaluateRangeTokens(tokenize(range), lookup);
+}
+
+QList<ExpressionEvaluator::Value> ExpressionEvaluator::evaluateConstraint(const QString &constraint, const Lookup &lookup)
+{
+    QList<Value> ranges;
+    const QStringList tokens = tokenize(constraint);
+    if (tokens.isEmpty())
+        return ranges;
+
+    // Scalar range constraint
+    if (tokens.first() == "range")
+    {
+        ranges.append(evaluateRangeTokens(tokens, lookup));
+        return ranges;
+    }
+
+    // Verilog packed and unpacked dimensions, or a VHDL index constraint
+    int depth = 0;
+    QStringList element;
+    for (const QString &token : tokens)
+    {
+        if (token == "(" || token == "[")
+        {
+            depth += 1;
+            if (depth == 1)
+                continue;
+        }
+        else if (token == ")" || token == "]")
+        {
+            depth -= 1;
+            if (depth == 0)
+            {
+                ranges.append(evaluateRangeTokens(element, lookup));
+                element.clear();
+                continue;
+            }
+        }
+        else if (depth == 1 && token == ",")
+        {
+            ranges.append(evaluateRangeTokens(element, lookup));
+            element.clear();
+            continue;
+        }
+        // Element constraints of VHDL-2008 are ignored
+        if (depth == 0)
+            break;
+        element.append(token);
+    }
+    return ranges;
+}
+
+// Number of bits needed for count different values, which is also ceil(log2(count))
+int ExpressionEvaluator::bitsFor(qint64 count)
+{
+    int bits = 0;
+    while (bits < 63 && (qint64(1) << bits) < count)
+        bits += 1;
+    return bits;
+}
@@ -0,0 +1,86 @@
+/* Lambila | ExpressionEvaluator.h
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#ifndef EXPRESSIONEVALUATOR_H
+#define EXPRESSIONEVALUATOR_H
+
+/******************************************************************************/
+
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+/******************************************************************************/
+
+// Evaluates the static expressions found in generics, constants and constraints.
+// Only integers, booleans and ranges are supported, in VHDL as well as in Verilog syntax.
+class ExpressionEvaluator
+{
+public:
+    struct Value {
+        enum class Kind {
+            Invalid,
+            Integer,
+            Boolean,
+            Range
+        };
+
+        Kind kind = Kind::Invalid;
+        // Integer and boolean values are stored in left, ranges use both bounds
+        qint64 left = 0;
+        qint64 right = 0;
+        bool ascending = false;
+
+        static Value integer(qint64 value)
+        {
+            return Value { Kind::Integer, value, value, false };
+        }
+        static Value boolean(bool value)
+        {
+            return Value { Kind::Boolean, value ? 1 : 0, 0, false };
+        }
+        static Value range(qint64 left, qint64 right, bool ascending)
+        {
+            return Value { Kind::Range, left, right, ascending };
+        }
+
+        bool isValid() const
+        {
+            return kind != Kind::Invalid;
+        }
+        // Number of elements of a range, null ranges are empty
+        qint64 length() const
+        {
+            if (kind != Kind::Range)
+                return 0;
+            return qMax<qint64>(0, (ascending ? right - left : left - right) + 1);
+        }
+        QString toString() const;
+    };
+
+    // Gives the value of a name, in lower case
+    typedef std::function<Value(const QString &name)> Lookup;
+
+protected:
+    class Parser;
+
+    static Value evaluateTokens(const QStringList &tokens, const Lookup &lookup);
+    static Value evaluateRangeTokens(QStringList tokens, const Lookup &lookup);
+
+public:
+    static Value evaluate(const QString &expression, const Lookup &lookup);
+    // Discrete range, either “left to right”, “left downto right” or “left:right”
+    static Value evaluateRange(const QString &range, const Lookup &lookup);
+    // Index ranges of a constraint such as “(7 downto 0, 1 to 4)” or “[7:0][3:0]”
+    static QList<Value> evaluateConstraint(const QString &constraint, const Lookup &lookup);
+
+    static int bitsFor(qint64 count);
+};
+
+/******************************************************************************/
+
+#endif // EXPRESSIONEVALUATOR_H
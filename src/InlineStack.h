@@ -0,0 +1,63 @@
+/* Lambila | InlineStack.h
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#ifndef INLINESTACK_H
+#define INLINESTACK_H
+
+/******************************************************************************/
+
+#include <QtGlobal>
+
+/******************************************************************************/
+
+// Fixed-capacity stack stored inline, so that pushing and popping never allocates
+template <typename T, int Capacity>
+class InlineStack {
+protected:
+    T _items[Capacity];
+    int _length = 0;
+
+public:
+    bool push(const T &item)
+    {
+        if (_length >= Capacity)
+            return false;
+        _items[_length++] = item;
+        return true;
+    }
+    void pop()
+    {
+        Q_ASSERT(_length > 0);
+        _length -= 1;
+    }
+
+    T &top()
+    {
+        return _items[_length - 1];
+    }
+    const T &top() const
+    {
+        return _items[_length - 1];
+    }
+
+    int length() const
+    {
+        return _length;
+    }
+    bool isEmpty() const
+    {
+        return _length == 0;
+    }
+    void clear()
+    {
+        _length = 0;
+    }
+};
+
+/******************************************************************************/
+
+#endif // INLINESTACK_H
@@ -0,0 +1,531 @@
+/* Lambila | LanguageServer.cpp
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#include "LanguageServer.h"
+#include "Logger.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QJsonDocument>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QUrl>
+#include <iostream>
+#include <string>
+
+/******************************************************************************/
+
+// Changes typed in an editor are gathered for this long, in milliseconds, before parsing
+static constexpr int REFRESH_DELAY = 200;
+
+// JSON-RPC error codes
+static constexpr int PARSE_ERROR = -32700;
+static constexpr int METHOD_NOT_FOUND = -32601;
+
+// Values defined by the protocol
+static constexpr int SYNC_FULL = 1;
+static constexpr int DIAGNOSTIC_WARNING = 2;
+
+enum class SymbolKind {
+    Module = 2,
+    Package = 4,
+    Class = 5,
+    Field = 8,
+    Variable = 13,
+    Constant = 14,
+    Object = 19,
+    TypeParameter = 26
+};
+
+/******************************************************************************/
+
+void LanguageServerReader::run()
+{
+    // Headers end with an empty line, then comes the content
+    std::string header;
+    qint64 length = -1;
+    while (std::getline(std::cin, header))
+    {
+        if (!header.empty() && header.back() == '\r')
+            header.pop_back();
+        if (!header.empty())
+        {
+            const QByteArray line = QByteArray::fromStdString(header);
+            if (line.toLower().startsWith("content-length:"))
+                length = line.mid(15).trimmed().toLongLong();
+            continue;
+        }
+        if (length < 0)
+            continue;
+        QByteArray content(length, Qt::Uninitialized);
+        if (!std::cin.read(content.data(), length))
+            break;
+        emit messageReceived(content);
+        length = -1;
+    }
+}
+
+/******************************************************************************/
+
+LanguageServer::LanguageServer(const QString &projectPath, QObject *parent) : QObject(parent)
+{
+    _project = new Project(this);
+    _projectPath = projectPath;
+    _reader = nullptr;
+    _server = nullptr;
+    _socket = nullptr;
+    _refreshPending = false;
+    _shutdown = false;
+
+    _refreshTimer.setSingleShot(true);
+    _refreshTimer.setInterval(REFRESH_DELAY);
+    connect(&_refreshTimer, &QTimer::timeout, this, &LanguageServer::refresh);
+    connect(_project, &Project::refreshed, this, &LanguageServer::refreshed);
+
+    // The log is forwarded to the client, there is no other place to show it
+    Logger::setVerbosity(Logger::LogLevel::Info);
+    connect(Logger::instance(), &Logger::logReceived, this, [=](Logger::LogLevel logLevel, const QString &message) {
+        const int type = (logLevel == Logger::LogLevel::Error) ? 1 : (logLevel == Logger::LogLevel::Warning) ? 2 : (logLevel == Logger::LogLevel::Info) ? 3 : 4;
+        notify("window/logMessage", QJsonObject { { "type", type }, { "message", message } });
+    });
+}
+
+LanguageServer::~LanguageServer()
+{
+    // A reader still blocked on the standard input cannot be interrupted safely, terminating it could leave the
+    // stream locked. It is left running until the end of the process, which follows.
+    if (_reader != nullptr && _reader->isFinished())
+        delete _reader;
+}
+
+bool LanguageServer::start()
+{
+    if (!_output.open(stdout, QIODevice::WriteOnly))
+        return false;
+    _reader = new LanguageServerReader;
+    connect(_reader, &LanguageServerReader::messageReceived, this, &LanguageServer::handleMessage);
+    connect(_reader, &QThread::finished, this, [=] {
+        QCoreApplication::exit(_shutdown ? 0 : 1);
+    });
+    _reader->start();
+    return true;
+}
+
+bool LanguageServer::listen(const QString &socketName)
+{
+    _server = new QLocalServer(this);
+    QLocalServer::removeServer(socketName);
+    if (!_server->listen(socketName))
+    {
+        Logger::error(tr("Failed to listen on %1: %2").arg(socketName).arg(_server->errorString()));
+        return false;
+    }
+    connect(_server, &QLocalServer::newConnection, this, [=] {
+        QLocalSocket *socket = _server->nextPendingConnection();
+        // A single client is served, like on the standard input
+        if (_socket != nullptr)
+        {
+            socket->abort();
+            socket->deleteLater();
+            return;
+        }
+        _socket = socket;
+        connect(_socket, &QLocalSocket::readyRead, this, &LanguageServer::readSocket);
+        connect(_socket, &QLocalSocket::disconnected, this, [=] {
+            QCoreApplication::exit(_shutdown ? 0 : 1);
+        });
+    });
+    return true;
+}
+
+/******************************************************************************/
+
+void LanguageServer::readSocket()
+{
+    _input.append(_socket->readAll());
+    for (;;)
+    {
+        const qsizetype end = _input.indexOf("\r\n\r\n");
+        if (end < 0)
+            return;
+        qint64 length = -1;
+        for (const QByteArray &line : _input.left(end).split('\n'))
+            if (line.trimmed().toLower().startsWith("content-length:"))
+                length = line.trimmed().mid(15).trimmed().toLongLong();
+        if (length < 0)
+        {
+            _input.remove(0, end + 4);
+            continue;
+        }
+        if (_input.size() < end + 4 + length)
+            return;
+        const QByteArray content = _input.mid(end + 4, length);
+        _input.remove(0, end + 4 + length);
+        handleMessage(content);
+    }
+}
+
+void LanguageServer::handleMessage(const QByteArray &message)
+{
+    QJsonParseError e;
+    const QJsonDocument document = QJsonDocument::fromJson(message, &e);
+    if (e.error != QJsonParseError::ParseError::NoError || !document.isObject())
+    {
+        respondError(QJsonValue::Null, PARSE_ERROR, e.errorString());
+        return;
+    }
+    const QJsonObject object = document.object();
+    const QString method = object["method"].toString();
+    const QJsonObject params = object["params"].toObject();
+
+    // Notifications
+    if (method == "exit")
+    {
+        QCoreApplication::exit(_shutdown ? 0 : 1);
+        return;
+    }
+    if (method == "textDocument/didOpen")
+    {
+        documentChanged(params["textDocument"]["uri"].toString(), params["textDocument"]["text"].toString());
+        return;
+    }
+    if (method == "textDocument/didChange")
+    {
+        // Only full contents are requested in the capabilities
+        const QJsonArray changes = params["contentChanges"].toArray();
+        if (!changes.isEmpty())
+            documentChanged(params["textDocument"]["uri"].toString(), changes.last()["text"].toString());
+        return;
+    }
+    if (method == "textDocument/didClose")
+    {
+        documentClosed(params["textDocument"]["uri"].toString());
+        return;
+    }
+    if (method == "textDocument/didSave" || method == "workspace/didChangeWatchedFiles")
+    {
+        scheduleRefresh();
+        return;
+    }
+    if (!object.contains("id") || method.isEmpty())
+        return;
+
+    // The design is being modified while parsing
+    if (_project->refreshing())
+    {
+        _pendingRequests.append(object);
+        return;
+    }
+    handleRequest(object);
+}
+
+void LanguageServer::handleRequest(const QJsonObject &request)
+{
+    const QJsonValue id = request["id"];
+    const QString method = request["method"].toString();
+    const QJsonObject params = request["params"].toObject();
+    if (method == "initialize")
+        respond(id, initialize(params));
+    else if (method == "shutdown")
+    {
+        _shutdown = true;
+        respond(id, QJsonValue::Null);
+    }
+    else if (method == "textDocument/documentSymbol")
+        respond(id, documentSymbols(params));
+    else if (method == "textDocument/definition")
+        respond(id, definition(params));
+    else if (method == "textDocument/references")
+        respond(id, references(params));
+    else
+        respondError(id, METHOD_NOT_FOUND, tr("Unsupported method: %1").arg(method));
+}
+
+/******************************************************************************/
+
+void LanguageServer::send(const QJsonObject &message)
+{
+    QJsonObject object = message;
+    object["jsonrpc"] = "2.0";
+    const QByteArray content = QJsonDocument(object).toJson(QJsonDocument::Compact);
+    QIODevice *device = (_socket != nullptr) ? static_cast<QIODevice *>(_socket) : &_output;
+    if (!device->isOpen())
+        return;
+    device->write(QString("Content-Length: %1\r\n\r\n").arg(content.size()).toLatin1() + content);
+    if (device == &_output)
+        _output.flush();
+}
+
+void LanguageServer::respond(const QJsonValue &id, const QJsonValue &result)
+{
+    send(QJsonObject { { "id", id }, { "result", result } });
+}
+
+void LanguageServer::respondError(const QJsonValue &id, int code, const QString &message)
+{
+    send(QJsonObject { { "id", id }, { "error", QJsonObject { { "code", code }, { "message", message } } } });
+}
+
+void LanguageServer::notify(const QString &method, const QJsonValue &params)
+{
+    send(QJsonObject { { "method", method }, { "params", params } });
+}
+
+/******************************************************************************/
+
+QJsonValue LanguageServer::initialize(const QJsonObject &params)
+{
+    // The project is given on the command line, or is the first one found at the root of the workspace
+    if (_projectPath.isEmpty())
+    {
+        const QString rootUri = params["rootUri"].toString();
+        const QDir root(rootUri.isEmpty() ? params["rootPath"].toString() : QUrl(rootUri).toLocalFile());
+        const QStringList projects = root.entryList({ "*.lila" }, QDir::Files, QDir::Name);
+        if (!projects.isEmpty())
+            _projectPath = root.filePath(projects.first());
+    }
+    if (_projectPath.isEmpty() || !_project->open(_projectPath))
+        Logger::warning(tr("No project loaded"));
+    else
+        refresh();
+
+    return QJsonObject {
+        { "capabilities", QJsonObject {
+            { "textDocumentSync", QJsonObject { { "openClose", true }, { "change", SYNC_FULL }, { "save", true } } },
+            { "documentSymbolProvider", true },
+            { "definitionProvider", true },
+            { "referencesProvider", true }
+        } },
+        { "serverInfo", QJsonObject { { "name", "lambila" }, { "version", Project::version() } } }
+    };
+}
+
+// Unsaved contents are parsed instead of the file on disk
+void LanguageServer::documentChanged(const QString &uri, const QString &text)
+{
+    const QString path = filePath(uri);
+    if (path.isEmpty())
+        return;
+    _project->setBuffer(path, text.toUtf8());
+    scheduleRefresh();
+}
+
+void LanguageServer::documentClosed(const QString &uri)
+{
+    const QString path = filePath(uri);
+    if (path.isEmpty())
+        return;
+    _project->removeBuffer(path);
+    scheduleRefresh();
+}
+
+void LanguageServer::scheduleRefresh()
+{
+    _refreshTimer.start();
+}
+
+void LanguageServer::refresh()
+{
+    // A single refresh runs at a time, changes made meanwhile are parsed afterwards
+    if (_project->refreshing())
+    {
+        _refreshPending = true;
+        return;
+    }
+    _project->refresh();
+}
+
+void LanguageServer::refreshed()
+{
+    publishDiagnostics();
+
+    // Requests received while parsing, in order
+    const QList<QJsonObject> requests = _pendingRequests;
+    _pendingRequests.clear();
+    for (const QJsonObject &request : requests)
+        handleRequest(request);
+
+    if (_refreshPending)
+    {
+        _refreshPending = false;
+        refresh();
+    }
+}
+
+// Only the files whose diagnostics changed are published
+void LanguageServer::publishDiagnostics()
+{
+    QHash<QString, QJsonArray> diagnostics;
+    for (const Lint::Issue &issue : _project->lint().issues())
+    {
+        const QString file = uri(issue.location.file);
+        if (file.isEmpty())
+            continue;
+        diagnostics[file].append(QJsonObject {
+            { "range", range(issue.location, 0) },
+            { "severity", DIAGNOSTIC_WARNING },
+            { "source", "lambila" },
+            { "code", Lint::ruleName(issue.rule) },
+            { "message", issue.message }
+        });
+    }
+    for (auto it = _diagnostics.cbegin(); it != _diagnostics.cend(); ++it)
+        if (!diagnostics.contains(it.key()))
+            notify("textDocument/publishDiagnostics", QJsonObject { { "uri", it.key() }, { "diagnostics", QJsonArray() } });
+    for (auto it = diagnostics.cbegin(); it != diagnostics.cend(); ++it)
+        if (_diagnostics.value(it.key()) != it.value())
+            notify("textDocument/publishDiagnostics", QJsonObject { { "uri", it.key() }, { "diagnostics", it.value() } });
+    _diagnostics = diagnostics;
+}
+
+/******************************************************************************/
+
+QJsonValue LanguageServer::documentSymbols(const QJsonObject &params)
+{
+    QJsonArray symbols;
+    Design *design = _project->design();
+    if (design == nullptr)
+        return symbols;
+    const FileId file = design->fileId(filePath(params["textDocument"]["uri"].toString()));
+    if (file == INVALID_FILE_ID)
+        return symbols;
+
+    const auto addSymbol = [&](const QString &name, SymbolKind kind, const Location &location, const QString &container) {
+        QJsonObject symbol { { "name", name }, { "kind", static_cast<int>(kind) }, { "location", this->location(location, name.length()) } };
+        if (!container.isEmpty())
+            symbol["containerName"] = container;
+        symbols.append(symbol);
+    };
+    for (auto entity : design->getEntities())
+    {
+        const QString entityName = entity->name().section('.', -1);
+        if (entity->file() == file)
+        {
+            addSymbol(entityName, SymbolKind::Class, entity->location(), QString());
+            for (const QString &name : entity->genericNames())
+                addSymbol(name, SymbolKind::TypeParameter, entity->generic(name)->location, entityName);
+            for (const QString &name : entity->portNames())
+                addSymbol(name, SymbolKind::Field, entity->port(name)->location, entityName);
+        }
+        for (auto architecture : entity->getArchitectures())
+        {
+            if (architecture->file() != file)
+                continue;
+            const QString scope = QString("%1(%2)").arg(entityName).arg(architecture->name());
+            addSymbol(architecture->name(), SymbolKind::Module, architecture->location(), entityName);
+            for (auto it = architecture->getConstants().cbegin(); it != architecture->getConstants().cend(); ++it)
+                addSymbol(it.key(), SymbolKind::Constant, it.value()->location, scope);
+            for (auto it = architecture->getSignals().cbegin(); it != architecture->getSignals().cend(); ++it)
+                addSymbol(it.key(), SymbolKind::Variable, it.value()->location, scope);
+            for (auto it = architecture->getInstances().cbegin(); it != architecture->getInstances().cend(); ++it)
+                addSymbol(it.key(), SymbolKind::Object, it.value()->location, scope);
+        }
+    }
+    for (auto package : design->getPackages())
+    {
+        if (package->file() != file)
+            continue;
+        const QString packageName = package->name().section('.', -1);
+        addSymbol(packageName, SymbolKind::Package, package->location(), QString());
+        for (auto it = package->getConstants().cbegin(); it != package->getConstants().cend(); ++it)
+            addSymbol(it.key(), SymbolKind::Constant, it.value()->location, packageName);
+    }
+    return symbols;
+}
+
+QJsonValue LanguageServer::definition(const QJsonObject &params)
+{
+    Reference reference;
+    if (!findReference(params, &reference))
+        return QJsonValue::Null;
+    CrossReferenceIndex &index = _project->design()->references();
+    const int length = index.identifierName(reference.identifier).length();
+
+    // Names are not resolved, the declarations in the scope of the reference are the most likely ones
+    const QList<Reference> declarations = index.references(reference.identifier, Reference::Kind::Declaration);
+    QJsonArray locations;
+    for (const Reference &declaration : declarations)
+        if (declaration.scope == reference.scope)
+            locations.append(location(declaration.location, length));
+    if (locations.isEmpty())
+        for (const Reference &declaration : declarations)
+            locations.append(location(declaration.location, length));
+    return locations;
+}
+
+QJsonValue LanguageServer::references(const QJsonObject &params)
+{
+    QJsonArray locations;
+    Reference reference;
+    if (!findReference(params, &reference))
+        return locations;
+    CrossReferenceIndex &index = _project->design()->references();
+    const int length = index.identifierName(reference.identifier).length();
+    const bool includeDeclaration = params["context"]["includeDeclaration"].toBool();
+    for (const Reference &other : index.references(reference.identifier))
+        if (includeDeclaration || other.kind != Reference::Kind::Declaration)
+            locations.append(location(other.location, length));
+    return locations;
+}
+
+/******************************************************************************/
+
+QString LanguageServer::filePath(const QString &uri)
+{
+    return QFileInfo(QUrl(uri).toLocalFile()).canonicalFilePath();
+}
+
+QString LanguageServer::uri(FileId file)
+{
+    Design *design = _project->design();
+    const QString path = (design != nullptr) ? design->getFiles().value(file).path : QString();
+    return path.isEmpty() ? QString() : QUrl::fromLocalFile(path).toString();
+}
+
+// Lines and characters start at 0 in the protocol, characters are counted in UTF-16 code units like in QString
+QJsonObject LanguageServer::range(const Location &location, int length)
+{
+    Design *design = _project->design();
+    const int line = qMax(design->line(location) - 1, 0);
+    const int character = qMax(design->column(location) - 1, 0);
+    return QJsonObject {
+        { "start", QJsonObject { { "line", line }, { "character", character } } },
+        { "end", QJsonObject { { "line", line }, { "character", character + length } } }
+    };
+}
+
+QJsonObject LanguageServer::location(const Location &location, int length)
+{
+    return QJsonObject { { "uri", uri(location.file) }, { "range", range(location, length) } };
+}
+
+// Reference under the position given in a request
+bool LanguageServer::findReference(const QJsonObject &params, Reference *reference)
+{
+    Design *design = _project->design();
+    if (design == nullptr)
+        return false;
+    const FileId file = design->fileId(filePath(params["textDocument"]["uri"].toString()));
+    if (file == INVALID_FILE_ID)
+        return false;
+    const QList<quint32> &lineOffsets = design->getFiles().at(file).lineOffsets;
+    const int line = params["position"]["line"].toInt();
+    if (line < 0 || line >= lineOffsets.count())
+        return false;
+    const quint32 offset = lineOffsets.at(line) + params["position"]["character"].toInt();
+
+    CrossReferenceIndex &index = design->references();
+    for (const Reference &candidate : index.fileReferences(file))
+    {
+        if (offset >= candidate.location.offset && offset < candidate.location.offset + index.identifierName(candidate.identifier).length())
+        {
+            *reference = candidate;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,103 @@
+/* Lambila | LanguageServer.h
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#ifndef LANGUAGESERVER_H
+#define LANGUAGESERVER_H
+
+/******************************************************************************/
+
+#include "Project.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QThread>
+#include <QTimer>
+
+class QLocalServer;
+class QLocalSocket;
+
+/******************************************************************************/
+
+// Reads the messages sent on the standard input, which cannot be watched by the event loop on every platform
+class LanguageServerReader : public QThread
+{
+    Q_OBJECT
+
+protected:
+    void run() override;
+
+signals:
+    void messageReceived(const QByteArray &message);
+};
+
+/******************************************************************************/
+
+// Language Server Protocol over the standard input and output, or over a local socket.
+// The project is loaded once and kept in memory: the files changed on disk or in an editor are parsed again in the
+// background, and the requests received meanwhile are answered once the design is consistent again.
+class LanguageServer : public QObject
+{
+    Q_OBJECT
+
+protected:
+    Project *_project;
+    QString _projectPath;
+
+    LanguageServerReader *_reader;
+    QFile _output;
+    QLocalServer *_server;
+    QLocalSocket *_socket;
+    QByteArray _input;
+
+    // Changes are gathered for a short while before refreshing
+    QTimer _refreshTimer;
+    bool _refreshPending;
+    QList<QJsonObject> _pendingRequests;
+    // Diagnostics last published, by URI
+    QHash<QString, QJsonArray> _diagnostics;
+    bool _shutdown;
+
+    void readSocket();
+    void handleMessage(const QByteArray &message);
+    void handleRequest(const QJsonObject &request);
+
+    void send(const QJsonObject &message);
+    void respond(const QJsonValue &id, const QJsonValue &result);
+    void respondError(const QJsonValue &id, int code, const QString &message);
+    void notify(const QString &method, const QJsonValue &params);
+
+    QJsonValue initialize(const QJsonObject &params);
+    void documentChanged(const QString &uri, const QString &text);
+    void documentClosed(const QString &uri);
+    void scheduleRefresh();
+    void refresh();
+    void refreshed();
+    void publishDiagnostics();
+
+    QJsonValue documentSymbols(const QJsonObject &params);
+    QJsonValue definition(const QJsonObject &params);
+    QJsonValue references(const QJsonObject &params);
+
+    static QString filePath(const QString &uri);
+    QString uri(FileId file);
+    QJsonObject range(const Location &location, int length);
+    QJsonObject location(const Location &location, int length);
+    bool findReference(const QJsonObject &params, Reference *reference);
+
+public:
+    LanguageServer(const QString &projectPath, QObject *parent = nullptr);
+    ~LanguageServer();
+
+    // Serve a single client, on the standard input and output or on a local socket
+    bool start();
+    bool listen(const QString &socketName);
+};
+
+/******************************************************************************/
+
+#endif // LANGUAGESERVER_H
@@ -0,0 +1,470 @@
+/* Lambila | LibrarySummary.cpp
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#include "LibrarySummary.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+/******************************************************************************/
+
+static const char SUMMARY_MAGIC[4] = { 'L', 'L', 'I', 'B' };
+static const char WORKSPACE_NAME[] = "work";
+// Magic, version, unit count, offset and length of the library name
+static const quint32 HEADER_SIZE = 5 * sizeof(quint32);
+// Offset and length of the name, kind, offset and length of the data
+static const quint32 ENTRY_SIZE = 5 * sizeof(quint32);
+
+QHash<QString, QList<LibrarySummary *>> LibrarySummary::_libraries;
+
+/******************************************************************************/
+
+static void appendWord(QByteArray &data, quint32 word)
+{
+    const quint32 little = qToLittleEndian(word);
+    data.append(reinterpret_cast<const char *>(&little), sizeof(little));
+}
+
+static quint32 readWord(const uchar *data)
+{
+    return qFromLittleEndian<quint32>(data);
+}
+
+// Units of the work library belong to the library being written
+static QString renameLibrary(const QString &name, const QString &library)
+{
+    if (name.contains('.') && name.section('.', 0, 0).compare(WORKSPACE_NAME, Qt::CaseInsensitive) == 0)
+        return QString("%1.%2").arg(library).arg(name.section('.', 1));
+    return name;
+}
+
+static QString typeName(Design *design, TypeId typeId, const QString &library)
+{
+    Type *type = design->type(typeId);
+    return type == nullptr ? QString() : renameLibrary(type->name(), library);
+}
+
+static void writeUses(QDataStream &stream, const QMultiHash<QString, Use> &uses, const QString &library)
+{
+    stream << static_cast<quint32>(uses.count());
+    for (auto it = uses.cbegin(); it != uses.cend(); ++it)
+        stream << (it.key().compare(WORKSPACE_NAME, Qt::CaseInsensitive) == 0 ? library : it.key().toLower()) << it.value();
+}
+
+// Generics and ports, in declaration order
+static void writeInterface(QDataStream &stream, Design *design, Entity *entity, const QString &library)
+{
+    stream << renameLibrary(entity->name(), library);
+    writeUses(stream, entity->getUses(), library);
+    stream << static_cast<quint32>(entity->genericNames().count());
+    for (const QString &name : entity->genericNames())
+    {
+        const Generic *generic = entity->generic(name);
+        stream << name << generic->type << typeName(design, generic->typeId, library) << generic->value;
+    }
+    stream << static_cast<quint32>(entity->portNames().count());
+    for (const QString &name : entity->portNames())
+    {
+        const Port *port = entity->port(name);
+        stream << name << port->direction << port->type << typeName(design, port->typeId, library);
+    }
+}
+
+/******************************************************************************/
+
+// Names qualified with their library were resolved when the summary was written, the others are resolved again
+static TypeId resolveName(Design *design, const QStringList &scopes, const QString &name)
+{
+    if (name.isEmpty())
+        return INVALID_TYPE_ID;
+    return name.contains('.') ? design->internType(name) : design->resolveType(scopes, name);
+}
+
+static QStringList readUses(QDataStream &stream, QMultiHash<QString, Use> &uses)
+{
+    quint32 count = 0;
+    stream >> count;
+    QStringList scopes;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+    {
+        QString library;
+        QString use;
+        stream >> library >> use;
+        uses.insert(library, use);
+        scopes.append(QString("%1.%2").arg(library).arg(use.section('.', 0, 0)));
+    }
+    return scopes;
+}
+
+static void importUses(Design *design, const QMultiHash<QString, Use> &uses)
+{
+    for (auto it = uses.cbegin(); it != uses.cend(); ++it)
+        LibrarySummary::importUnit(design, it.key(), it.value().section('.', 0, 0));
+}
+
+static Entity *readInterface(QDataStream &stream, Design *design)
+{
+    Entity *entity = new Entity;
+    QString name;
+    stream >> name;
+    entity->setName(name);
+    QMultiHash<QString, Use> uses;
+    const QStringList scopes = QStringList { name } + readUses(stream, uses);
+    for (auto it = uses.cbegin(); it != uses.cend(); ++it)
+        entity->addUse(it.key(), it.value());
+    importUses(design, uses);
+
+    quint32 count = 0;
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+    {
+        QString genericName, type, typeRef, value;
+        stream >> genericName >> type >> typeRef >> value;
+        entity->addGeneric(genericName, type, resolveName(design, scopes, typeRef), value, Location());
+    }
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+    {
+        QString portName, direction, type, typeRef;
+        stream >> portName >> direction >> type >> typeRef;
+        entity->addPort(portName, direction, type, resolveName(design, scopes, typeRef), Location());
+    }
+    return entity;
+}
+
+/******************************************************************************/
+
+LibrarySummary::LibrarySummary()
+{
+    _data = nullptr;
+    _size = 0;
+    _unitCount = 0;
+}
+
+bool LibrarySummary::open(const QString &path)
+{
+    _file.setFileName(path);
+    if (!_file.open(QIODevice::ReadOnly))
+    {
+        Logger::warning(QString("Failed to open library summary %1: %2").arg(path).arg(_file.errorString()));
+        return false;
+    }
+    _size = _file.size();
+    _data = _file.map(0, _size);
+    if (_data == nullptr)
+    {
+        // Compressed resources cannot be mapped
+        _copy = _file.readAll();
+        _data = reinterpret_cast<const uchar *>(_copy.constData());
+    }
+
+    if (_size < HEADER_SIZE || memcmp(_data, SUMMARY_MAGIC, sizeof(SUMMARY_MAGIC)) != 0)
+    {
+        Logger::warning(QString("%1 is not a library summary").arg(path));
+        return false;
+    }
+    if (readWord(_data + 4) != VERSION)
+    {
+        Logger::warning(QString("Library summary %1 was written by another version, it is ignored").arg(path));
+        return false;
+    }
+    _unitCount = readWord(_data + 8);
+    const quint32 libraryOffset = readWord(_data + 12);
+    const quint32 libraryLength = readWord(_data + 16);
+    if (HEADER_SIZE + static_cast<qint64>(_unitCount) * ENTRY_SIZE > _size || static_cast<qint64>(libraryOffset) + libraryLength > _size)
+    {
+        Logger::warning(QString("Library summary %1 is truncated").arg(path));
+        return false;
+    }
+    _library = QString::fromUtf8(reinterpret_cast<const char *>(_data + libraryOffset), libraryLength).toLower();
+    return true;
+}
+
+// Binary search over the table of units, without decoding the names
+bool LibrarySummary::findUnit(const QString &name, UnitEntry *entry) const
+{
+    const QByteArray key = name.trimmed().toLower().toUtf8();
+    quint32 first = 0;
+    quint32 last = _unitCount;
+    while (first < last)
+    {
+        const quint32 middle = first + (last - first) / 2;
+        const uchar *table = _data + HEADER_SIZE + middle * ENTRY_SIZE;
+        const quint32 nameOffset = readWord(table);
+        const quint32 nameLength = readWord(table + 4);
+        if (static_cast<qint64>(nameOffset) + nameLength > _size)
+            return false;
+        const QByteArray unitName = QByteArray::fromRawData(reinterpret_cast<const char *>(_data + nameOffset), nameLength);
+        if (unitName < key)
+            first = middle + 1;
+        else if (key < unitName)
+            last = middle;
+        else
+        {
+            const quint32 dataOffset = readWord(table + 12);
+            const quint32 dataLength = readWord(table + 16);
+            if (static_cast<qint64>(dataOffset) + dataLength > _size)
+                return false;
+            entry->name = unitName;
+            entry->kind = static_cast<UnitKind>(readWord(table + 8));
+            entry->data = QByteArray::fromRawData(reinterpret_cast<const char *>(_data + dataOffset), dataLength);
+            return true;
+        }
+    }
+    return false;
+}
+
+const QString &LibrarySummary::library() const
+{
+    return _library;
+}
+
+bool LibrarySummary::contains(const QString &unit) const
+{
+    UnitEntry entry;
+    return findUnit(unit, &entry);
+}
+
+/******************************************************************************/
+
+bool LibrarySummary::importPackage(Design *design, const QByteArray &data) const
+{
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_6_0);
+    QString name;
+    stream >> name;
+    if (design->package(name) != nullptr)
+        return true;
+
+    // The package is declared before the packages it uses, in case they use it in turn
+    Package *package = new Package;
+    package->setName(name);
+    design->addPackage(package);
+    QMultiHash<QString, Use> uses;
+    const QStringList scopes = QStringList { name } + readUses(stream, uses);
+    package->setUses(uses);
+    importUses(design, uses);
+
+    quint32 count = 0;
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+    {
+        QString typeName, fullName, baseName, elementName, constraint;
+        quint8 kind;
+        QStringList literals;
+        QStringList fieldTypes;
+        stream >> typeName >> fullName >> kind >> baseName >> elementName >> constraint >> literals >> fieldTypes;
+        Type *type = design->declareType(fullName, static_cast<Type::Kind>(kind));
+        type->setBaseType(baseName.isEmpty() ? type->id() : resolveName(design, scopes, baseName));
+        type->setElementType(resolveName(design, scopes, elementName));
+        type->setConstraint(constraint);
+        for (int field = 0; field < literals.count(); ++field)
+        {
+            if (field < fieldTypes.count())
+                type->addField(literals.at(field), resolveName(design, scopes, fieldTypes.at(field)));
+            else
+                type->addLiteral(literals.at(field));
+        }
+        package->addType(typeName, type->id());
+    }
+
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+    {
+        QString constantName, type, typeRef, value;
+        stream >> constantName >> type >> typeRef >> value;
+        package->addConstant(constantName, type, resolveName(design, scopes, typeRef), value, Location());
+    }
+
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+        package->addComponent(readInterface(stream, design));
+
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+    {
+        QString subprogramName, specification;
+        stream >> subprogramName >> specification;
+        package->addSubprogram(subprogramName, specification);
+    }
+
+    if (stream.status() != QDataStream::Ok)
+    {
+        Logger::warning(QString("Library summary %1 is corrupted in %2").arg(_file.fileName()).arg(name));
+        return false;
+    }
+    return true;
+}
+
+bool LibrarySummary::importEntity(Design *design, const QByteArray &data) const
+{
+    // The name comes first, the entity is only read if it is not declared yet
+    QString name;
+    QDataStream(data) >> name;
+    if (design->entity(name) != nullptr)
+        return true;
+
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_6_0);
+    Entity *entity = readInterface(stream, design);
+    if (stream.status() != QDataStream::Ok)
+    {
+        Logger::warning(QString("Library summary %1 is corrupted in %2").arg(_file.fileName()).arg(name));
+        delete entity;
+        return false;
+    }
+    design->addEntity(entity);
+    return true;
+}
+
+/******************************************************************************/
+
+bool LibrarySummary::write(Design *design, const QString &library, const QString &path)
+{
+    const QString lowerLibrary = library.trimmed().toLower();
+    QMap<QByteArray, QPair<UnitKind, QByteArray>> units;
+
+    // Units imported from other summaries have no file, they are not part of the library
+    for (Package *package : design->getPackages())
+    {
+        if (package->file() == INVALID_FILE_ID)
+            continue;
+        QByteArray data;
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream << renameLibrary(package->name(), lowerLibrary);
+        writeUses(stream, package->getUses(), lowerLibrary);
+
+        // Types in declaration order, so that the summary does not change from one run to the next
+        QList<QPair<TypeId, QString>> types;
+        for (auto it = package->getTypes().cbegin(); it != package->getTypes().cend(); ++it)
+            types.append(qMakePair(it.value(), it.key()));
+        std::sort(types.begin(), types.end());
+        stream << static_cast<quint32>(types.count());
+        for (const auto &pair : types)
+        {
+            Type *type = design->type(pair.first);
+            QStringList fieldTypes;
+            for (TypeId field : type->fieldTypes())
+                fieldTypes.append(typeName(design, field, lowerLibrary));
+            const QString baseName = (type->baseType() == type->id()) ? QString() : typeName(design, type->baseType(), lowerLibrary);
+            stream << pair.second << renameLibrary(type->name(), lowerLibrary) << static_cast<quint8>(type->kind()) << baseName
+                   << typeName(design, type->elementType(), lowerLibrary) << type->constraint() << type->literals() << fieldTypes;
+        }
+
+        QStringList constants = package->getConstants().keys();
+        constants.sort();
+        stream << static_cast<quint32>(constants.count());
+        for (const QString &name : constants)
+        {
+            const Constant *constant = package->constant(name);
+            stream << name << constant->type << typeName(design, constant->typeId, lowerLibrary) << constant->value;
+        }
+
+        QStringList components = package->getComponents().keys();
+        components.sort();
+        stream << static_cast<quint32>(components.count());
+        for (const QString &name : components)
+            writeInterface(stream, design, package->component(name), lowerLibrary);
+
+        QStringList subprograms = package->getSubprograms().uniqueKeys();
+        subprograms.sort();
+        stream << static_cast<quint32>(package->getSubprograms().count());
+        for (const QString &name : subprograms)
+            for (const Subprogram *specification : package->subprograms(name))
+                stream << name << *specification;
+
+        units.insert(package->name().section('.', -1).toLower().toUtf8(), qMakePair(UnitKind::Package, data));
+    }
+
+    for (Entity *entity : design->getEntities())
+    {
+        if (entity->file() == INVALID_FILE_ID)
+            continue;
+        QByteArray data;
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_6_0);
+        writeInterface(stream, design, entity, lowerLibrary);
+        units.insert(entity->name().section('.', -1).toLower().toUtf8(), qMakePair(UnitKind::Entity, data));
+    }
+
+    // Header and table first, then the library name, and the name and data of each unit in the order of the table
+    QByteArray contents(SUMMARY_MAGIC, sizeof(SUMMARY_MAGIC));
+    const QByteArray libraryName = lowerLibrary.toUtf8();
+    quint32 offset = HEADER_SIZE + units.count() * ENTRY_SIZE;
+    appendWord(contents, VERSION);
+    appendWord(contents, units.count());
+    appendWord(contents, offset);
+    appendWord(contents, libraryName.size());
+    offset += libraryName.size();
+    QByteArray blobs = libraryName;
+    for (auto it = units.cbegin(); it != units.cend(); ++it)
+    {
+        appendWord(contents, offset);
+        appendWord(contents, it.key().size());
+        offset += it.key().size();
+        appendWord(contents, static_cast<quint32>(it.value().first));
+        appendWord(contents, offset);
+        appendWord(contents, it.value().second.size());
+        offset += it.value().second.size();
+        blobs.append(it.key());
+        blobs.append(it.value().second);
+    }
+    contents.append(blobs);
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(contents) != contents.size() || !file.commit())
+    {
+        Logger::error(QString("Failed to write library summary %1: %2").arg(path).arg(file.errorString()));
+        return false;
+    }
+    Logger::info(QString("Library %1: %2 unit(s) written to %3").arg(lowerLibrary).arg(units.count()).arg(path));
+    return true;
+}
+
+/******************************************************************************/
+
+void LibrarySummary::loadLibraries(const QStringList &directories)
+{
+    for (const QString &directory : directories)
+    {
+        const QDir dir(directory);
+        for (const QString &name : dir.entryList(QStringList { "*.lib" }, QDir::Files, QDir::Name))
+        {
+            LibrarySummary *summary = new LibrarySummary;
+            if (!summary->open(dir.filePath(name)))
+            {
+                delete summary;
+                continue;
+            }
+            Logger::debug(QString("library summary: %1 (%2 unit(s))").arg(dir.filePath(name)).arg(summary->_unitCount));
+            _libraries[summary->library()].append(summary);
+        }
+    }
+}
+
+bool LibrarySummary::importUnit(Design *design, const QString &library, const QString &unit)
+{
+    const auto summaries = _libraries.constFind(library.trimmed().toLower());
+    if (summaries == _libraries.cend())
+        return false;
+    for (const LibrarySummary *summary : *summaries)
+    {
+        UnitEntry entry;
+        if (!summary->findUnit(unit, &entry))
+            continue;
+        if (entry.kind == UnitKind::Package)
+            return summary->importPackage(design, entry.data);
+        return summary->importEntity(design, entry.data);
+    }
+    return false;
+}
@@ -0,0 +1,78 @@
+/* Lambila | LibrarySummary.h
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#ifndef LIBRARYSUMMARY_H
+#define LIBRARYSUMMARY_H
+
+/******************************************************************************/
+
+#include "Design.h"
+
+#include <QFile>
+
+/******************************************************************************/
+
+// Declarations of a compiled library, such as “ieee” or a vendor primitive library: the types, constants, components
+// and subprograms of its packages, and the generics and ports of its entities.
+// A summary is a binary file made of a table of units sorted by name, followed by the declarations of each unit. It is
+// mapped in memory, a unit is found with a binary search over the table, and only the units named by a use clause or
+// an entity instantiation are declared in the design. Types are stored by name: the names that were not resolved when
+// the summary was written are resolved again against the use clauses of the package, like the parser does.
+// Summaries are embedded as resources under “:/libraries”, or loaded from the directories given at startup.
+class LibrarySummary
+{
+public:
+    // Summaries written with another version are ignored
+    static const quint32 VERSION = 1;
+
+    enum class UnitKind : quint32 {
+        Package,
+        Entity
+    };
+
+protected:
+    struct UnitEntry {
+        QByteArray name;
+        UnitKind kind;
+        QByteArray data;
+    };
+
+    QFile _file;
+    // Mapped contents of the file, or a copy when it cannot be mapped
+    const uchar *_data;
+    qint64 _size;
+    QByteArray _copy;
+    QString _library;
+    quint32 _unitCount;
+
+    // Summaries loaded at startup, by library name in lower case, the first ones found first
+    static QHash<QString, QList<LibrarySummary *>> _libraries;
+
+    bool open(const QString &path);
+    bool findUnit(const QString &name, UnitEntry *entry) const;
+    bool importPackage(Design *design, const QByteArray &data) const;
+    bool importEntity(Design *design, const QByteArray &data) const;
+
+public:
+    LibrarySummary();
+
+    const QString &library() const;
+    bool contains(const QString &unit) const;
+
+    // Write the packages and the entities of a design, renaming the work library to the given library
+    static bool write(Design *design, const QString &library, const QString &path);
+
+    // Load the summaries of the given directories, the ones loaded first take precedence
+    static void loadLibraries(const QStringList &directories);
+    // Declare a package or an entity of a library in the design, along with the packages it uses.
+    // Returns true if the unit is declared in the design, whether it was already or not.
+    static bool importUnit(Design *design, const QString &library, const QString &unit);
+};
+
+/******************************************************************************/
+
+#endif // LIBRARYSUMMARY_H
@@ -0,0 +1,239 @@
+/* Lambila | Lint.cpp
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#include "Elaboration.h"
+#include "Lint.h"
+
+#include <QThreadPool>
+#include <algorithm>
+
+/******************************************************************************/
+
+// Declared spelling of a name, empty if it is not declared
+static QString findName(const QStringList &names, const QString &name)
+{
+    for (const QString &declared : names)
+        if (declared.compare(name.trimmed(), Qt::CaseInsensitive) == 0)
+            return declared;
+    return QString();
+}
+
+// Ports that drive the actual they are connected to
+static bool isOutput(const QString &direction)
+{
+    const QString lower = direction.toLower();
+    return lower == "out" || lower == "output" || lower == "buffer" || lower == "inout";
+}
+
+// Statements of Verilog modules are not modelled, so only their declarations can be checked
+static bool isVerilog(Design *design, FileId file)
+{
+    return design->getFiles().value(file).path.endsWith(".v", Qt::CaseInsensitive);
+}
+
+static void addPackageFiles(Entity *entity, QSet<FileId> &files)
+{
+    for (Package *package : entity->visiblePackages())
+        files.insert(package->file());
+    for (Package *package : entity->visibleNames())
+        files.insert(package->file());
+}
+
+/******************************************************************************/
+
+QString Lint::ruleName(Rule rule)
+{
+    switch (rule)
+    {
+    case Rule::UnusedSignal:         return "unused-signal";
+    case Rule::UndrivenPort:         return "undriven-port";
+    case Rule::WidthMismatch:        return "width-mismatch";
+    case Rule::UnresolvedEntity:     return "unresolved-entity";
+    case Rule::DuplicateDeclaration: return "duplicate-declaration";
+    }
+    return QString();
+}
+
+// Only reads the design, the use clauses are resolved beforehand
+Lint::UnitResult Lint::check(Design *design, Entity *entity)
+{
+    UnitResult result;
+    const auto addIssue = [&](Rule rule, const QString &message, const Location &location) {
+        result.issues.append(Issue { rule, entity->name(), message, location });
+    };
+    result.files.insert(entity->file());
+    addPackageFiles(entity, result.files);
+    const bool verilog = isVerilog(design, entity->file());
+
+    for (const Redeclaration &redeclaration : entity->getRedeclarations())
+        addIssue(Rule::DuplicateDeclaration, QString("“%1” is already declared in %2").arg(redeclaration.name).arg(entity->name()), redeclaration.location);
+
+    // The elaboration memoizes its values, each check has its own
+    Elaboration elaboration;
+    elaboration.reset(design);
+    const Elaboration::GenericBinding defaults;
+
+    QSet<QString> drivenPorts;
+    bool summarized = false;
+    for (auto architecture : entity->getArchitectures())
+    {
+        // The statements of summarized architectures are not known, only their redeclarations can be checked
+        summarized |= architecture->summarized();
+        result.files.insert(architecture->file());
+        const QString scope = QString("%1(%2)").arg(entity->name()).arg(architecture->name());
+        for (const Redeclaration &redeclaration : architecture->getRedeclarations())
+            addIssue(Rule::DuplicateDeclaration, QString("“%1” is already declared in %2").arg(redeclaration.name).arg(scope), redeclaration.location);
+
+        // Names read and written by the statements, in lower case
+        QSet<QString> read;
+        QSet<QString> written;
+        for (const Assignment &assignment : architecture->getAssignments())
+        {
+            read.unite(QSet<QString>(assignment.sources.cbegin(), assignment.sources.cend()));
+            written.unite(QSet<QString>(assignment.targets.cbegin(), assignment.targets.cend()));
+        }
+        for (const Process &process : architecture->getProcesses())
+        {
+            read.unite(QSet<QString>(process.sensitivity.cbegin(), process.sensitivity.cend()));
+            for (const Clock &clock : process.clocks)
+                read.insert(clock.signal);
+        }
+
+        const QStringList signalNames = architecture->getSignals().keys();
+        for (auto it = architecture->getInstances().cbegin(); it != architecture->getInstances().cend(); ++it)
+        {
+            const Instance *instance = it.value();
+            for (const Association &association : instance->genericMap)
+                read.unite(QSet<QString>(association.names.cbegin(), association.names.cend()));
+
+            Entity *instantiated = design->entity(instance->unit);
+            if (instantiated == nullptr)
+            {
+                // Without the ports, every actual may be read or written
+                addIssue(Rule::UnresolvedEntity, QString("Instance %1 of unknown unit %2").arg(it.key()).arg(instance->unit), instance->location);
+                result.unresolved.append(instance->unit);
+                for (const Association &association : instance->portMap)
+                {
+                    read.unite(QSet<QString>(association.names.cbegin(), association.names.cend()));
+                    written.unite(QSet<QString>(association.names.cbegin(), association.names.cend()));
+                }
+                continue;
+            }
+            result.files.insert(instantiated->file());
+            addPackageFiles(instantiated, result.files);
+
+            // The widths are only compared when the generics of the instance are known
+            const Elaboration::GenericBinding binding = elaboration.instanceBinding(entity, architecture, defaults, it.key());
+            const bool bound = (binding.count() == instance->genericMap.count());
+            for (int i = 0; i < instance->portMap.count(); ++i)
+            {
+                // Positional associations follow the declaration order of the ports
+                const Association &association = instance->portMap.at(i);
+                const QString formal = association.formal.isEmpty() ? instantiated->portNames().value(i) : association.formal.section('(', 0, 0);
+                const QString port = findName(instantiated->portNames(), formal);
+                const QString direction = port.isEmpty() ? QString() : instantiated->port(port)->direction.toLower();
+                if (!isOutput(direction) || direction == "inout")
+                    read.unite(QSet<QString>(association.names.cbegin(), association.names.cend()));
+                if (port.isEmpty())
+                    continue;
+                if (isOutput(direction))
+                    written.unite(QSet<QString>(association.names.cbegin(), association.names.cend()));
+
+                // Whole ports connected to whole signals or ports
+                if (!bound || association.formal.contains('(') || association.names.count() != 1 || association.actual.trimmed().compare(association.names.first(), Qt::CaseInsensitive) != 0)
+                    continue;
+                const int formalWidth = elaboration.portWidth(instantiated, binding, port);
+                const QString signal = findName(signalNames, association.actual);
+                const QString actualPort = findName(entity->portNames(), association.actual);
+                int actualWidth = Elaboration::UNKNOWN_WIDTH;
+                if (!signal.isEmpty())
+                    actualWidth = elaboration.signalWidth(entity, architecture, defaults, signal);
+                else if (!actualPort.isEmpty())
+                    actualWidth = elaboration.portWidth(entity, defaults, actualPort);
+                if (formalWidth != Elaboration::UNKNOWN_WIDTH && actualWidth != Elaboration::UNKNOWN_WIDTH && formalWidth != actualWidth)
+                    addIssue(Rule::WidthMismatch, QString("Port %1 of instance %2 is %3 bit(s) wide, %4 is %5 bit(s) wide").arg(port).arg(it.key()).arg(formalWidth).arg(association.actual.trimmed()).arg(actualWidth), instance->location);
+            }
+        }
+        drivenPorts.unite(written);
+
+        if (verilog || architecture->summarized())
+            continue;
+        for (auto it = architecture->getSignals().cbegin(); it != architecture->getSignals().cend(); ++it)
+            if (!read.contains(it.key().toLower()))
+                addIssue(Rule::UnusedSignal, QString("Signal %1 is never read in %2").arg(it.key()).arg(scope), it.value()->location);
+    }
+
+    // Ports are only driven by the architectures of the entity
+    if (!verilog && !summarized && !entity->getArchitectures().isEmpty())
+        for (const QString &name : entity->portNames())
+        {
+            const Port *port = entity->port(name);
+            if (isOutput(port->direction) && port->direction.toLower() != "inout" && !drivenPorts.contains(name.toLower()))
+                addIssue(Rule::UndrivenPort, QString("Output port %1 of %2 is never driven").arg(name).arg(entity->name()), port->location);
+        }
+    return result;
+}
+
+/******************************************************************************/
+
+void Lint::update(Design *design, const QSet<FileId> &files)
+{
+    QList<Entity *> pending;
+    for (auto it = _results.begin(); it != _results.end();)
+    {
+        if (design->entity(it.key()) == nullptr)
+            it = _results.erase(it);
+        else
+            ++it;
+    }
+    for (auto entity : design->getEntities())
+    {
+        // The use clauses are resolved on the first lookup, which must not happen in the threads
+        if (!entity->usesResolved())
+            design->resolveUses(entity);
+        const auto cached = _results.constFind(entity->name());
+        if (cached == _results.cend() || cached->files.intersects(files)
+            || std::any_of(cached->unresolved.cbegin(), cached->unresolved.cend(), [=](const QString &unit) { return design->entity(unit) != nullptr; }))
+            pending.append(entity);
+    }
+
+    QList<UnitResult> results(pending.count());
+    UnitResult *data = results.data();
+    QThreadPool pool;
+    for (int i = 0; i < pending.count(); ++i)
+    {
+        Entity *entity = pending.at(i);
+        pool.start([=] { data[i] = check(design, entity); });
+    }
+    pool.waitForDone();
+
+    for (int i = 0; i < pending.count(); ++i)
+        _results.insert(pending.at(i)->name(), results.at(i));
+    Logger::debug(QString("lint: %1 of %2 entities checked").arg(pending.count()).arg(design->getEntities().count()));
+}
+
+void Lint::clear()
+{
+    _results.clear();
+}
+
+/******************************************************************************/
+
+QList<Lint::Issue> Lint::issues() const
+{
+    QList<Issue> issues;
+    QStringList units = _results.keys();
+    units.sort(Qt::CaseInsensitive);
+    for (const QString &unit : units)
+        issues.append(_results.value(unit).issues);
+    return issues;
+}
+
+QList<Lint::Issue> Lint::issues(const QString &unit) const
+{
+    return _results.value(unit).issues;
+}
@@ -0,0 +1,67 @@
+/* Lambila | Lint.h
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#ifndef LINT_H
+#define LINT_H
+
+/******************************************************************************/
+
+#include "Design.h"
+
+/******************************************************************************/
+
+// Checks run over the parsed design, without parsing the sources again.
+// Each entity is checked along with its architectures, in parallel with the other entities. The issues of an entity
+// are kept until one of the files they were found from is parsed again, so that a refresh only checks the entities
+// that changed or that depend on the files that changed.
+class Lint
+{
+public:
+    enum class Rule {
+        UnusedSignal,
+        UndrivenPort,
+        WidthMismatch,
+        UnresolvedEntity,
+        DuplicateDeclaration
+    };
+
+    struct Issue {
+        Rule rule;
+        QString unit;
+        QString message;
+        Location location;
+    };
+
+protected:
+    struct UnitResult {
+        QList<Issue> issues;
+        // Files read by the checks: the entity, its architectures, the instantiated entities and the used packages
+        QSet<FileId> files;
+        // Instantiated units that were not found, the entity is checked again when one of them appears
+        QStringList unresolved;
+    };
+
+    // Results by entity name
+    QHash<QString, UnitResult> _results;
+
+    static UnitResult check(Design *design, Entity *entity);
+
+public:
+    static QString ruleName(Rule rule);
+
+    // Check again the entities declared in the given files or depending on them
+    void update(Design *design, const QSet<FileId> &files);
+    void clear();
+
+    // Issues of all the entities, sorted by entity name
+    QList<Issue> issues() const;
+    QList<Issue> issues(const QString &unit) const;
+};
+
+/******************************************************************************/
+
+#endif // LINT_H
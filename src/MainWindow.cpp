@@ -12,11 +12,17 @@
 #include <QCloseEvent>
 #include <QDirIterator>
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QMessageBox>
 #include <QSettings>
 
 /******************************************************************************/
 
+// Number of search results displayed
+static constexpr int SEARCH_RESULT_COUNT = 50;
+
+/******************************************************************************/
+
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), _ui(new Ui::MainWindow)
 {
     _project = nullptr;
@@ -86,11 +92,14 @@ void MainWindow::projectNew()
     connect(_project, &Project::modifiedChanged, this, &MainWindow::projectModifiedChanged);
     connect(_project, &Project::fileAdded,       this, &MainWindow::projectFileAdded);
     connect(_project, &Project::fileRemoved,     this, &MainWindow::projectFileRemoved);
+    connect(_project, &Project::refreshed,       this, &MainWindow::projectRefreshed);
+    connect(_project, &Project::symbolsParsed,   this, &MainWindow::projectSymbolsParsed);
 
     // Reset the UI
     _ui->actionSave->setEnabled(false);
     _ui->fileTreeWidget->clear();
     _ui->fileRemoveButton->setEnabled(false);
+    _ui->searchLineEdit->clear();
     setWindowTitle(tr("Lambila"));
 }
 
@@ -172,6 +181,15 @@ static QTreeWidgetItem *createTreeNode(QTreeWidget *tree, const QString &path)
     return item;
 }
 
+// Files under a node, or the node itself if it is a file
+static void addTreeFiles(QTreeWidgetItem *item, QStringList &filePaths)
+{
+    if (item->childCount() == 0)
+        filePaths.append(item->data(0, Qt::UserRole).toString());
+    for (int i = 0; i < item->childCount(); ++i)
+        addTreeFiles(item->child(i), filePaths);
+}
+
 static QTreeWidgetItem *findOrCreateTreeNode(QTreeWidget *tree, const QString &path)
 {
     // Check if a node already exists
@@ -233,7 +251,13 @@ void MainWindow::projectFileRemoved(QFileInfo fi)
 
 void MainWindow::on_fileTreeWidget_itemSelectionChanged()
 {
-    _ui->fileRemoveButton->setEnabled(_ui->fileTreeWidget->selectedItems().count() != 0);
+    _ui->fileRemoveButton->setEnabled(!_project->refreshing() && _ui->fileTreeWidget->selectedItems().count() != 0);
+
+    // The selected files, or the files of the selected folders, are parsed first
+    QStringList filePaths;
+    for (const auto item : _ui->fileTreeWidget->selectedItems())
+        addTreeFiles(item, filePaths);
+    _project->prioritize(filePaths);
 }
 
 void MainWindow::on_fileAddButton_clicked()
@@ -272,6 +296,55 @@ void MainWindow::on_refreshButton_clicked()
     if (!_project)
         return;
     _project->refresh();
+    setRefreshing(_project->refreshing());
+}
+
+void MainWindow::projectRefreshed()
+{
+    setRefreshing(false);
+    // Search again, since the results may have changed
+    on_searchLineEdit_textChanged(_ui->searchLineEdit->text());
+}
+
+void MainWindow::projectSymbolsParsed()
+{
+    // The results fill in while the files are parsed
+    on_searchLineEdit_textChanged(_ui->searchLineEdit->text());
+}
+
+// The design is written by the parser thread while refreshing, only the search stays available
+void MainWindow::setRefreshing(bool refreshing)
+{
+    _ui->actionNew->setEnabled(!refreshing);
+    _ui->actionOpen->setEnabled(!refreshing);
+    _ui->actionExit->setEnabled(!refreshing);
+    _ui->actionSetTopEntity->setEnabled(!refreshing);
+    _ui->actionExportCompileOrder->setEnabled(!refreshing);
+    _ui->actionExportDesign->setEnabled(!refreshing);
+    _ui->fileAddButton->setEnabled(!refreshing);
+    _ui->folderAddButton->setEnabled(!refreshing);
+    _ui->fileRemoveButton->setEnabled(!refreshing && _ui->fileTreeWidget->selectedItems().count() != 0);
+    _ui->refreshButton->setEnabled(!refreshing && _ui->fileTreeWidget->topLevelItemCount() != 0);
+}
+
+/******************************************************************************/
+
+void MainWindow::on_searchLineEdit_textChanged(const QString &text)
+{
+    _ui->searchTreeWidget->clear();
+    _ui->searchTreeWidget->setVisible(!text.trimmed().isEmpty());
+    if (!_project || !_project->design())
+        return;
+
+    // Results are already sorted by relevance
+    for (const auto &entry : _project->symbolIndex().search(text, SEARCH_RESULT_COUNT))
+    {
+        QTreeWidgetItem *item = new QTreeWidgetItem(_ui->searchTreeWidget);
+        item->setText(0, entry.name);
+        item->setText(1, SymbolIndex::kindName(entry.kind));
+        item->setText(2, entry.scope);
+        item->setText(3, _project->locationString(entry.location));
+    }
 }
 
 /******************************************************************************/
@@ -299,6 +372,53 @@ void MainWindow::on_actionSaveAs_triggered()
     projectSaveAs();
 }
 
+void MainWindow::on_actionSetTopEntity_triggered()
+{
+    if (!_project->design())
+    {
+        Logger::error(tr("The project has to be refreshed first"));
+        return;
+    }
+
+    // The first item keeps all the files
+    QStringList entities = _project->design()->getEntities().keys();
+    entities.sort();
+    entities.prepend(tr("(none)"));
+    bool ok = false;
+    const int current = qMax(0, int(entities.indexOf(_project->topEntity())));
+    const QString entity = QInputDialog::getItem(this, tr("Set top entity"), tr("Top entity:"), entities, current, false, &ok);
+    if (!ok)
+        return;
+    _project->setTopEntity((entity == entities.first()) ? QString() : entity);
+    Logger::info(tr("%1 file(s) needed").arg(_project->reachableFiles().count()));
+}
+
+void MainWindow::on_actionExportCompileOrder_triggered()
+{
+    QString selectedFilter;
+    QString filePath = QFileDialog::getSaveFileName(this, tr("Export compile order"), lastPath(), tr("File lists (*.txt);;Makefile fragments (*.mk);;Ninja fragments (*.ninja)"), &selectedFilter);
+    if (filePath.isEmpty())
+        return;
+    // Use the extension of the selected filter if none was given
+    if (QFileInfo(filePath).suffix().isEmpty() && QFileInfo(filePath).fileName() != "Makefile")
+        filePath += selectedFilter.section("*", 1).section(")", 0, 0);
+    setLastPath(filePath);
+    _project->exportCompileOrder(filePath);
+}
+
+void MainWindow::on_actionExportDesign_triggered()
+{
+    QString selectedFilter;
+    QString filePath = QFileDialog::getSaveFileName(this, tr("Export design"), lastPath(), tr("JSON files (*.json);;Binary design files (*.lbd);;GraphViz files (*.dot)"), &selectedFilter);
+    if (filePath.isEmpty())
+        return;
+    // Use the extension of the selected filter if none was given
+    if (QFileInfo(filePath).suffix().isEmpty())
+        filePath += selectedFilter.section("*", 1).section(")", 0, 0);
+    setLastPath(filePath);
+    _project->exportDesign(filePath);
+}
+
 void MainWindow::on_actionExit_triggered()
 {
     close();
@@ -326,6 +446,9 @@ void MainWindow::logReceived(Logger::LogLevel logLevel, const QString &message)
 void MainWindow::closeEvent(QCloseEvent *event)
 {
     event->ignore();
+    // The design cannot be released while the parser thread writes to it
+    if (_project->refreshing())
+        return;
     if (projectPromptSave())
         event->accept();
 
@@ -40,6 +40,7 @@ protected:
     void projectOpen(QString filePath = QString());
     bool projectSaveAs();
     bool projectPromptSave();
+    void setRefreshing(bool refreshing);
 
     virtual void closeEvent(QCloseEvent *event);
 
@@ -47,6 +48,8 @@ private slots:
     void projectModifiedChanged(bool modified);
     void projectFileAdded(QFileInfo fi);
     void projectFileRemoved(QFileInfo fi);
+    void projectRefreshed();
+    void projectSymbolsParsed();
 
     void on_fileTreeWidget_itemSelectionChanged();
 
@@ -56,10 +59,15 @@ private slots:
 
     void on_refreshButton_clicked();
 
+    void on_searchLineEdit_textChanged(const QString &text);
+
     void on_actionNew_triggered();
     void on_actionOpen_triggered();
     void on_actionSave_triggered();
     void on_actionSaveAs_triggered();
+    void on_actionSetTopEntity_triggered();
+    void on_actionExportCompileOrder_triggered();
+    void on_actionExportDesign_triggered();
     void on_actionExit_triggered();
 
     void logReceived(Logger::LogLevel logLevel, const QString &message);
@@ -0,0 +1,148 @@
+/* Lambila | NetlistSpill.cpp
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#include "NetlistSpill.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+/******************************************************************************/
+
+// Spill files from another version are ignored
+static const quint32 SPILL_MAGIC = 0x4c4e5331;
+
+/******************************************************************************/
+
+NetlistSpill::~NetlistSpill()
+{
+    close();
+}
+
+bool NetlistSpill::open(const QString &path)
+{
+    close();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    _file.setFileName(path);
+    if (!_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        Logger::warning(QString("Failed to open spill file %1: %2").arg(path).arg(_file.errorString()));
+        return false;
+    }
+    _stream.setDevice(&_file);
+    _stream << SPILL_MAGIC;
+    return true;
+}
+
+bool NetlistSpill::isOpen() const
+{
+    return _file.isOpen();
+}
+
+void NetlistSpill::write(const Record &record)
+{
+    if (!_file.isOpen())
+        return;
+    _stream << static_cast<quint8>(record.kind) << record.scope << record.name << record.detail << record.location.offset;
+}
+
+bool NetlistSpill::close()
+{
+    if (!_file.isOpen())
+        return true;
+    const bool success = (_stream.status() == QDataStream::Ok);
+    _stream.setDevice(nullptr);
+    _file.close();
+    return success;
+}
+
+/******************************************************************************/
+
+bool NetlistSpill::openForReading(QFile &file, QDataStream &stream)
+{
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    stream.setDevice(&file);
+    quint32 magic = 0;
+    stream >> magic;
+    return (magic == SPILL_MAGIC);
+}
+
+// The file ID is not stored, it is the ID of the netlist the spill file belongs to
+bool NetlistSpill::readRecord(QDataStream &stream, Record &record)
+{
+    quint8 kind;
+    stream >> kind >> record.scope >> record.name >> record.detail >> record.location.offset;
+    record.kind = static_cast<Kind>(kind);
+    return (stream.status() == QDataStream::Ok);
+}
+
+bool NetlistSpill::read(const QString &path, const Visitor &visitor)
+{
+    QFile file(path);
+    QDataStream stream;
+    if (!openForReading(file, stream))
+        return false;
+    while (!stream.atEnd())
+    {
+        Record record;
+        if (!readRecord(stream, record))
+            return false;
+        if (!visitor(record))
+            break;
+    }
+    return true;
+}
+
+bool NetlistSpill::index(const QString &path, Index *index)
+{
+    QFile file(path);
+    QDataStream stream;
+    if (!openForReading(file, stream))
+        return false;
+    QString previousScope;
+    while (!stream.atEnd())
+    {
+        const qint64 position = file.pos();
+        Record record;
+        if (!readRecord(stream, record))
+            return false;
+        const QString scope = record.scope.toLower();
+        if (scope != previousScope)
+            (*index)[scope].append(position);
+        previousScope = scope;
+    }
+    return true;
+}
+
+bool NetlistSpill::read(const QString &path, const QList<qint64> &runs, const Visitor &visitor)
+{
+    QFile file(path);
+    QDataStream stream;
+    if (!openForReading(file, stream))
+        return false;
+    for (qint64 position : runs)
+    {
+        if (!file.seek(position))
+            return false;
+        stream.resetStatus();
+        QString scope;
+        while (!stream.atEnd())
+        {
+            Record record;
+            if (!readRecord(stream, record))
+                return false;
+            // The run ends where the records of another scope start
+            if (scope.isNull())
+                scope = record.scope;
+            else if (record.scope != scope)
+                break;
+            if (!visitor(record))
+                return true;
+        }
+    }
+    return true;
+}
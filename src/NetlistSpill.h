@@ -0,0 +1,76 @@
+/* Lambila | NetlistSpill.h
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#ifndef NETLISTSPILL_H
+#define NETLISTSPILL_H
+
+/******************************************************************************/
+
+#include "Design.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <functional>
+
+/******************************************************************************/
+
+// Detail of a netlist parsed in netlist mode, written to a file instead of being kept in the design.
+// The records are appended in the order of the source and read back one by one, so that neither writing nor reading
+// them needs more memory than a single record.
+class NetlistSpill
+{
+public:
+    enum class Kind : quint8 {
+        Signal,
+        Instance,
+        GenericMap,
+        PortMap
+    };
+
+    struct Record {
+        Kind kind;
+        // Architecture scope, as in “work.top.rtl”
+        QString scope;
+        // Name of the signal or path of the instance
+        QString name;
+        // Type of the signal, unit of the instance or text of the association list
+        QString detail;
+        Location location;
+    };
+
+    typedef std::function<bool(const Record &record)> Visitor;
+    // Positions of the runs of consecutive records of each scope, the scopes in lower case
+    typedef QHash<QString, QList<qint64>> Index;
+
+protected:
+    QFile _file;
+    QDataStream _stream;
+
+    static bool openForReading(QFile &file, QDataStream &stream);
+    static bool readRecord(QDataStream &stream, Record &record);
+
+public:
+    ~NetlistSpill();
+
+    // Replace the contents of the spill file
+    bool open(const QString &path);
+    bool isOpen() const;
+    void write(const Record &record);
+    bool close();
+
+    // Give the records of a spill file to the visitor until it returns false
+    static bool read(const QString &path, const Visitor &visitor);
+    // Index the runs of a spill file in a single pass, so that the records of a scope can be read without going
+    // through the whole file again
+    static bool index(const QString &path, Index *index);
+    // Give the records of a scope, from the positions of its runs, to the visitor until it returns false
+    static bool read(const QString &path, const QList<qint64> &runs, const Visitor &visitor);
+};
+
+/******************************************************************************/
+
+#endif // NETLISTSPILL_H
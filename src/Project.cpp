@@ -5,21 +5,34 @@
 
 /******************************************************************************/
 
+#include "CompileOrder.h"
+#include "DesignExporter.h"
 #include "Logger.h"
 #include "Project.h"
+#include "VerilogParser.h"
 #include "VhdlParser.h"
 
 #include <QApplication>
+#include <QCryptographicHash>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <QSaveFile>
+#include <QStandardPaths>
 
 /******************************************************************************/
 
 const QString Project::_lambilaVersion = "1.0";
 
+// VHDL files from this size on are parsed in netlist mode
+static const qint64 NETLIST_FILE_SIZE = 64 * 1024 * 1024;
+// Shortest time between two batches of parsed files published to the UI, in milliseconds
+static const qint64 BATCH_INTERVAL = 100;
+// Number of files edited lately that are parsed first
+static const int RECENT_FILE_COUNT = 16;
+
 /******************************************************************************/
 
 Project::Project(QObject *parent) : QObject(parent)
@@ -33,10 +46,11 @@ Project::Project(QObject *parent) : QObject(parent)
 
 Project::~Project()
 {
-    delete _design;
+    // The parser thread writes to the design until it is done
     if (_thread)
         _thread->wait();
     delete _thread;
+    delete _design;
     delete _progressDialog;
 }
 
@@ -95,6 +109,7 @@ bool Project::open(const QString &filePath)
         Logger::warning(tr("This file was created by a different Lambila version. Current version: %1, file version: %2").arg(_lambilaVersion).arg(jobj["_lambilaVersion"].toString()));
     for (const auto &item : jobj["fileList"].toArray())
         addFile(targetDir.filePath(item.toString()));
+    _topEntity = jobj["topEntity"].toString();
 
     // Mark the project as not modified
     setModified(false);
@@ -116,6 +131,8 @@ bool Project::saveAs(const QString &filePath)
     for (const QFileInfo &file : _files)
         files.append(targetDir.relativeFilePath(file.canonicalFilePath()));
     jobj["fileList"] = QJsonArray::fromStringList(files);
+    if (!_topEntity.isEmpty())
+        jobj["topEntity"] = _topEntity;
 
     // Save the file
     QSaveFile file(_projectFile.absoluteFilePath());
@@ -187,50 +204,455 @@ bool Project::removeFile(const QString &filePath)
 
 /******************************************************************************/
 
-ProjectParserThread::ProjectParserThread(QList<QFileInfo> files, Design *design, QObject *parent) : QThread(parent)
+QString Project::topEntity()
+{
+    return _topEntity;
+}
+
+void Project::setTopEntity(const QString &topEntity)
+{
+    if (topEntity == _topEntity)
+        return;
+    _topEntity = topEntity;
+    setModified(true);
+}
+
+// Files needed by the top entity, or all files if there is none, in the project order
+QList<FileId> Project::reachableFiles()
+{
+    QList<FileId> files;
+    if (_design == nullptr)
+        return files;
+    const QSet<FileId> reachable = _unitGraph.reachableFiles(_topEntity);
+    if (!_topEntity.isEmpty() && reachable.isEmpty())
+        Logger::warning(tr("Unknown top entity “%1”, using all files").arg(_topEntity));
+    for (const QFileInfo &file : _files)
+    {
+        const FileId id = _design->fileId(file.canonicalFilePath());
+        if (id != INVALID_FILE_ID && (reachable.isEmpty() || reachable.contains(id)))
+            files.append(id);
+    }
+    return files;
+}
+
+/******************************************************************************/
+
+ProjectParserThread::ProjectParserThread(QList<QFileInfo> files, Design *design, const QHash<QString, QByteArray> &buffers, QObject *parent) : QThread(parent)
 {
     _files = files;
     _design = design;
+    _buffers = buffers;
+    for (int i = 0; i < _files.count(); ++i)
+        _fileIndexes.insert(_files.at(i).canonicalFilePath(), i);
+    _taken.resize(_files.count());
+    _early.resize(_files.count());
+    _nextFile = 0;
+}
+
+const QList<QFileInfo> &ProjectParserThread::files() const
+{
+    return _files;
+}
+
+void ProjectParserThread::prioritize(const QStringList &filePaths)
+{
+    QMutexLocker locker(&_queueLock);
+    _urgentFiles = filePaths + _urgentFiles;
+}
+
+// Index of the next file to parse, -1 once they are all taken. A file taken ahead of the project order is taken again
+// when its turn comes, to be parsed once the units it depends on are.
+int ProjectParserThread::takeNext(bool *again)
+{
+    QMutexLocker locker(&_queueLock);
+    while (_nextFile < _files.count() && _taken.testBit(_nextFile) && !_early.testBit(_nextFile))
+        _nextFile += 1;
+    while (!_urgentFiles.isEmpty())
+    {
+        const int index = _fileIndexes.value(_urgentFiles.takeFirst(), -1);
+        if (index < 0 || _taken.testBit(index))
+            continue;
+        _taken.setBit(index);
+        _early.setBit(index, index > _nextFile);
+        *again = false;
+        return index;
+    }
+    if (_nextFile == _files.count())
+        return -1;
+    *again = _early.testBit(_nextFile);
+    _early.clearBit(_nextFile);
+    _taken.setBit(_nextFile);
+    return _nextFile++;
+}
+
+// Files removed from the design along with a file parsed again are parsed again too, the ones that were not to be
+// parsed are added at the end. Returns the number of files that were already parsed.
+int ProjectParserThread::requeue(const QSet<FileId> &files)
+{
+    QMutexLocker locker(&_queueLock);
+    int parsed = 0;
+    for (FileId file : files)
+    {
+        const QString &path = _design->getFiles().at(file).path;
+        const int index = _fileIndexes.value(path, -1);
+        if (index < 0)
+        {
+            _fileIndexes.insert(path, _files.count());
+            _files.append(QFileInfo(path));
+            _taken.resize(_files.count());
+            _early.resize(_files.count());
+            continue;
+        }
+        if (!_taken.testBit(index))
+            continue;
+        _taken.clearBit(index);
+        _early.clearBit(index);
+        _nextFile = qMin(_nextFile, index);
+        parsed += 1;
+    }
+    return parsed;
+}
+
+static bool parseFile(const QFileInfo &file, Design *design, const QByteArray &contents)
+{
+    // Select the parser depending on the file extension
+    if (file.suffix().compare("v", Qt::CaseInsensitive) == 0)
+    {
+        VerilogParser parser(file, design);
+        parser.setContents(contents);
+        return parser.parse();
+    }
+    VhdlParser parser(file, design);
+    parser.setContents(contents);
+    // Netlists are summarized in the design, their detail is spilled to the cache, one file per netlist
+    if (contents.isNull() && file.size() >= NETLIST_FILE_SIZE)
+    {
+        const QByteArray hash = QCryptographicHash::hash(file.canonicalFilePath().toUtf8(), QCryptographicHash::Sha1).toHex();
+        parser.setNetlistMode(true, QString("%1/netlists/%2.spill").arg(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).arg(QString::fromLatin1(hash)));
+    }
+    return parser.parse();
+}
+
+// Collecting the symbols walks the whole design, so files are published in batches rather than one by one
+void ProjectParserThread::publish(const QSet<FileId> &files)
+{
+    ParsedBatch batch;
+    for (FileId file : files)
+        batch.files.insert(file, _design->getFiles().at(file));
+    batch.symbols = SymbolIndex::collect(_design, files);
+    emit batchParsed(batch);
 }
 
 void ProjectParserThread::run()
 {
     // Parse all files sequentially
     int progress = 0;
-    for (auto file : _files)
+    QSet<FileId> parsedFiles;
+    QElapsedTimer timer;
+    timer.start();
+    bool again = false;
+    for (int index = takeNext(&again); index >= 0; index = takeNext(&again))
     {
-        if (!VhdlParser(file, _design).parse())
+        // Not a reference, files can be added while parsing
+        const QFileInfo file = _files.at(index);
+        // What was parsed ahead of the project order is dropped, as well as what was parsed from it since
+        if (again)
+        {
+            QSet<FileId> removedFiles = _design->removeFiles({ _design->fileId(file.canonicalFilePath()) });
+            removedFiles.remove(_design->fileId(file.canonicalFilePath()));
+            progress -= requeue(removedFiles);
+            // Their symbols are dropped with the next batch
+            parsedFiles.unite(removedFiles);
+        }
+        if (!parseFile(file, _design, _buffers.value(file.canonicalFilePath())))
+        {
+            // Drop whatever was parsed, so that the file is parsed again on the next refresh. Files parsed ahead may
+            // only miss the units they depend on, they are parsed again in the project order.
+            _design->removeFiles({ _design->fileId(file.canonicalFilePath()) });
+            if (_early.testBit(index))
+                continue;
             break;
-        emit progressChanged(++progress);
+        }
+        if (!again)
+            emit progressChanged(++progress);
+
+        // The last batch is not needed, the whole refresh is indexed once done
+        parsedFiles.insert(_design->fileId(file.canonicalFilePath()));
+        if (timer.elapsed() >= BATCH_INTERVAL && progress < _files.count())
+        {
+            publish(parsedFiles);
+            parsedFiles.clear();
+            timer.restart();
+        }
     }
 }
 
 void Project::refresh()
 {
-    // Create a new design
-    delete _design;
-    _design = new Design;
+    // Keep the current design, only the files that changed are parsed again
+    if (_design == nullptr)
+        _design = new Design;
 
-    // Create a progress dialog to block the UI while refreshing
-    _progressDialog = new QProgressDialog(tr("Refreshing..."), "", 0, _files.count());
-    _progressDialog->setCancelButton(nullptr);
-    _progressDialog->setModal(true);
-    _progressDialog->show();
+    // Remove the contents of the files that changed or that are not part of the project anymore
+    QSet<QString> projectFiles;
+    for (const QFileInfo &file : _files)
+        projectFiles.insert(file.canonicalFilePath());
+    QSet<FileId> outdatedFiles;
+    const QList<SourceFile> &sourceFiles = _design->getFiles();
+    for (FileId id = 0; id < sourceFiles.count(); ++id)
+    {
+        const QFileInfo file(sourceFiles.at(id).path);
+        if (!projectFiles.contains(sourceFiles.at(id).path) || file.lastModified() != sourceFiles.at(id).lastModified || _changedBuffers.contains(sourceFiles.at(id).path))
+            outdatedFiles.insert(id);
+    }
+    _changedBuffers.clear();
+    const QSet<FileId> removedFiles = _design->removeFiles(outdatedFiles);
+    _symbolIndex.update(_design, removedFiles);
+    _elaboration.reset(_design);
+
+    // Parse the new files and the removed ones, in the project order
+    QList<QFileInfo> files;
+    for (QFileInfo file : _files)
+    {
+        file.refresh();
+        const FileId id = _design->fileId(file.canonicalFilePath());
+        if (id == INVALID_FILE_ID || removedFiles.contains(id))
+            files.append(file);
+    }
+    Logger::info(tr("%1 file(s) to parse").arg(files.count()));
 
     // Use a thread to parse all files
-    _thread = new ProjectParserThread(_files, _design, this);
-    connect(_thread, &ProjectParserThread::progressChanged, _progressDialog, &QProgressDialog::setValue);
-    connect(_thread, &QThread::finished, [=] {
+    _previousFiles = _design->getFiles();
+    _thread = new ProjectParserThread(files, _design, _buffers, this);
+
+    // Create a progress dialog to block the UI while refreshing, there is no UI in the language server
+    if (qobject_cast<QApplication *>(QCoreApplication::instance()) != nullptr)
+    {
+        // Not modal, the symbols parsed so far can be searched meanwhile
+        _progressDialog = new QProgressDialog(tr("Refreshing..."), "", 0, files.count());
+        _progressDialog->setCancelButton(nullptr);
+        _progressDialog->setModal(false);
+        _progressDialog->show();
+        connect(_thread, &ProjectParserThread::progressChanged, _progressDialog, &QProgressDialog::setValue);
+    }
+    _thread->prioritize(_focusFiles + _recentFiles);
+    connect(_thread, &ProjectParserThread::batchParsed, this, &Project::batchParsed);
+    connect(_thread, &QThread::finished, this, [=] {
         // Clean up
+        const QList<QFileInfo> parsedFileInfos = _thread->files();
         _thread->deleteLater();
         _thread = nullptr;
-        _progressDialog->deleteLater();
+        _parsedFiles.clear();
+        _previousFiles.clear();
+        if (_progressDialog != nullptr)
+            _progressDialog->deleteLater();
         _progressDialog = nullptr;
 
-        // TODO: build hierarchy
-        Logger::debug("Found entities:");
-        for (auto entity : _design->getEntities())
-            Logger::debug(entity->name());
+        // Index the names declared in the files that were parsed
+        QSet<FileId> parsedFiles;
+        for (const QFileInfo &file : parsedFileInfos)
+            parsedFiles.insert(_design->fileId(file.canonicalFilePath()));
+        _symbolIndex.update(_design, parsedFiles);
+        _unitGraph.build(_design);
+        _elaboration.reset(_design);
+        _connectivity.build(_design);
+        _clockDomains.build(_design, _connectivity);
+        _lint.update(_design, QSet<FileId>(removedFiles).unite(parsedFiles));
+        for (const Lint::Issue &issue : _lint.issues())
+            Logger::warning(QString("%1: %2 [%3]").arg(_design->locationString(issue.location)).arg(issue.message).arg(Lint::ruleName(issue.rule)));
+
+        // Views only have to update what changed
+        const DesignDiff::ChangeSet changes = _designDiff.update(_design, QSet<FileId>(removedFiles).unite(parsedFiles));
+        for (const DesignDiff::Change &change : changes)
+        {
+            QString scope = change.entity;
+            if (!change.architecture.isEmpty())
+                scope += QString("(%1)").arg(change.architecture);
+            if (!change.name.isEmpty())
+                scope += QString(".%1").arg(change.name);
+            Logger::debug(QString("%1 %2: %3").arg(DesignDiff::elementName(change.element)).arg(DesignDiff::kindName(change.kind)).arg(scope));
+        }
+        emit designChanged(changes);
+        emit refreshed();
     });
     _thread->start();
 }
+
+bool Project::refreshing()
+{
+    return _thread != nullptr;
+}
+
+// Runs in the main thread, the batches are queued before the end of the thread
+void Project::batchParsed(const ParsedBatch &batch)
+{
+    if (_thread == nullptr)
+        return;
+    _parsedFiles.insert(batch.files);
+    _symbolIndex.add(QSet<FileId>(batch.files.keyBegin(), batch.files.keyEnd()), batch.symbols);
+    emit symbolsParsed();
+}
+
+// Files the user is looking at, parsed first on the next refresh, or right away if one is running
+void Project::prioritize(const QStringList &filePaths)
+{
+    _focusFiles = filePaths;
+    if (_thread != nullptr)
+        _thread->prioritize(filePaths);
+}
+
+// The file is parsed again on the next refresh
+void Project::setBuffer(const QString &filePath, const QByteArray &contents)
+{
+    _buffers.insert(filePath, contents);
+    _changedBuffers.insert(filePath);
+    _recentFiles.removeAll(filePath);
+    _recentFiles.prepend(filePath);
+    if (_recentFiles.count() > RECENT_FILE_COUNT)
+        _recentFiles.removeLast();
+}
+
+void Project::removeBuffer(const QString &filePath)
+{
+    if (_buffers.remove(filePath) != 0)
+        _changedBuffers.insert(filePath);
+}
+
+bool Project::exportCompileOrder(const QString &filePath)
+{
+    if (_design == nullptr)
+    {
+        Logger::error(tr("Export failed - The project has to be refreshed first"));
+        return false;
+    }
+
+    // Sort the files needed by the top entity, keeping their order when they do not depend on each other
+    const QList<FileId> files = reachableFiles();
+    const CompileOrder compileOrder(_design, _unitGraph, files);
+    for (const auto &cycle : compileOrder.cycles())
+    {
+        QStringList paths;
+        for (FileId file : cycle)
+            paths.append(_design->getFiles().at(file).path);
+        Logger::warning(tr("Circular dependency between: %1").arg(paths.join(", ")));
+    }
+    Logger::info(tr("%1 file(s) in %2 compile level(s)").arg(files.count()).arg(compileOrder.levels().count()));
+
+    // The format depends on the file extension
+    const QFileInfo fi(filePath);
+    QString text;
+    if (fi.suffix() == "mk" || fi.fileName() == "Makefile")
+        text = compileOrder.makefile();
+    else if (fi.suffix() == "ninja")
+        text = compileOrder.ninja();
+    else
+        text = compileOrder.fileList();
+
+    // Save the file
+    QSaveFile file(fi.absoluteFilePath());
+    file.setDirectWriteFallback(true);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        Logger::error(tr("Export failed - Open file: %1").arg(file.errorString()));
+        return false;
+    }
+    if (file.write(text.toUtf8()) == -1)
+    {
+        Logger::error(tr("Export failed - Write: %1").arg(file.errorString()));
+        return false;
+    }
+    if (!file.commit())
+    {
+        Logger::error(tr("Export failed - Commit: %1").arg(file.errorString()));
+        return false;
+    }
+    return true;
+}
+
+bool Project::exportDesign(const QString &filePath)
+{
+    if (_design == nullptr || refreshing())
+    {
+        Logger::error(tr("Export failed - The project has to be refreshed first"));
+        return false;
+    }
+    DesignExporter::Format format;
+    if (!DesignExporter::formatFor(filePath, &format))
+    {
+        Logger::error(tr("Export failed - Unknown format: %1").arg(QFileInfo(filePath).suffix()));
+        return false;
+    }
+
+    // Written as the design is walked, without building the whole document first
+    QSaveFile file(QFileInfo(filePath).absoluteFilePath());
+    file.setDirectWriteFallback(true);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        Logger::error(tr("Export failed - Open file: %1").arg(file.errorString()));
+        return false;
+    }
+    DesignExporter exporter(_design, &file);
+    if (!exporter.write(format))
+    {
+        Logger::error(tr("Export failed - Write: %1").arg(file.errorString()));
+        file.cancelWriting();
+        return false;
+    }
+    if (!file.commit())
+    {
+        Logger::error(tr("Export failed - Commit: %1").arg(file.errorString()));
+        return false;
+    }
+    Logger::info(tr("Design exported to %1").arg(filePath));
+    return true;
+}
+
+Design *Project::design()
+{
+    return _design;
+}
+
+QString Project::locationString(const Location &location)
+{
+    if (!refreshing())
+        return (_design == nullptr) ? QString() : _design->locationString(location);
+
+    // Same as the design, from the copies of the files published so far, or of the files as they were before
+    const SourceFile *file = nullptr;
+    const auto parsedFile = _parsedFiles.constFind(location.file);
+    if (parsedFile != _parsedFiles.cend())
+        file = &parsedFile.value();
+    else if (location.file >= 0 && location.file < _previousFiles.count() && !_previousFiles.at(location.file).lineOffsets.isEmpty())
+        file = &_previousFiles.at(location.file);
+    if (file == nullptr)
+        return QString();
+    const QList<quint32> &lineOffsets = file->lineOffsets;
+    const int line = std::upper_bound(lineOffsets.cbegin(), lineOffsets.cend(), location.offset) - lineOffsets.cbegin();
+    const int column = (line == 0) ? 0 : location.offset - lineOffsets.at(line - 1) + 1;
+    return QString("%1:%2:%3").arg(file->path).arg(line).arg(column);
+}
+
+SymbolIndex &Project::symbolIndex()
+{
+    return _symbolIndex;
+}
+
+Elaboration &Project::elaboration()
+{
+    return _elaboration;
+}
+
+Connectivity &Project::connectivity()
+{
+    return _connectivity;
+}
+
+ClockDomains &Project::clockDomains()
+{
+    return _clockDomains;
+}
+
+Lint &Project::lint()
+{
+    return _lint;
+}
@@ -10,14 +10,29 @@
 
 /******************************************************************************/
 
+#include "ClockDomains.h"
+#include "Connectivity.h"
 #include "Design.h"
+#include "DesignDiff.h"
+#include "Elaboration.h"
+#include "Lint.h"
+#include "SymbolIndex.h"
+#include "UnitGraph.h"
 
+#include <QBitArray>
 #include <QFileInfo>
+#include <QMutex>
 #include <QProgressDialog>
 #include <QThread>
 
 /******************************************************************************/
 
+// Files parsed since the previous batch, copied out of the design while the parser thread goes on writing it
+struct ParsedBatch {
+    QHash<FileId, SourceFile> files;
+    QList<SymbolIndex::Entry> symbols;
+};
+
 class ProjectParserThread : public QThread
 {
     Q_OBJECT
@@ -25,15 +40,36 @@ class ProjectParserThread : public QThread
 protected:
     QList<QFileInfo> _files;
     Design *_design;
+    QHash<QString, QByteArray> _buffers;
+
+    // Files are parsed in the project order, except for the urgent ones which jump ahead. The units they depend on
+    // may not be parsed yet, so they are parsed again once their turn comes.
+    QMutex _queueLock;
+    QHash<QString, int> _fileIndexes;
+    QBitArray _taken;
+    QBitArray _early;
+    int _nextFile;
+    QStringList _urgentFiles;
+
+    int takeNext(bool *again);
+    int requeue(const QSet<FileId> &files);
+    void publish(const QSet<FileId> &files);
 
 public:
-    ProjectParserThread(QList<QFileInfo> files, Design *design, QObject *parent = nullptr);
+    ProjectParserThread(QList<QFileInfo> files, Design *design, const QHash<QString, QByteArray> &buffers, QObject *parent = nullptr);
+
+    // Files to parse, including the ones added while running since they depend on a file parsed again
+    const QList<QFileInfo> &files() const;
+
+    // Parse the given files next, the first one first. Can be called while running.
+    void prioritize(const QStringList &filePaths);
 
 protected:
     void run() override;
 
 signals:
     void progressChanged(int progress);
+    void batchParsed(const ParsedBatch &batch);
 };
 
 /******************************************************************************/
@@ -47,9 +83,27 @@ private:
     QFileInfo _projectFile;
     bool _modified;
     QList<QFileInfo> _files;
+    QString _topEntity;
     Design *_design;
+    SymbolIndex _symbolIndex;
+    UnitGraph _unitGraph;
+    Elaboration _elaboration;
+    Connectivity _connectivity;
+    ClockDomains _clockDomains;
+    Lint _lint;
+    DesignDiff _designDiff;
+    // Unsaved contents of files open in an editor, by canonical path, parsed instead of the files on disk
+    QHash<QString, QByteArray> _buffers;
+    QSet<QString> _changedBuffers;
     ProjectParserThread *_thread;
     QProgressDialog *_progressDialog;
+    // Files published by the parser thread during the refresh, the design cannot be read until it is done
+    QHash<FileId, SourceFile> _parsedFiles;
+    // Files of the design when the refresh started, for the locations of the files that are not parsed again
+    QList<SourceFile> _previousFiles;
+    // Files parsed first: the ones the user is looking at, then the ones edited lately, most recent first
+    QStringList _focusFiles;
+    QStringList _recentFiles;
 
 public:
     Project(QObject *parent = nullptr);
@@ -59,6 +113,7 @@ public:
 
 protected:
     void setModified(bool);
+    void batchParsed(const ParsedBatch &batch);
 
 public:
     QFileInfo projectFile();
@@ -71,10 +126,34 @@ public:
     bool addFile(const QString &filePath);
     bool removeFile(const QString &filePath);
 
+    QString topEntity();
+    void setTopEntity(const QString &topEntity);
+    QList<FileId> reachableFiles();
+
     void refresh();
+    bool refreshing();
+    void prioritize(const QStringList &filePaths);
+    void setBuffer(const QString &filePath, const QByteArray &contents);
+    void removeBuffer(const QString &filePath);
+    bool exportCompileOrder(const QString &filePath);
+    // JSON, binary or DOT depending on the file extension
+    bool exportDesign(const QString &filePath);
+    Design *design();
+    // Location of a symbol, even while refreshing
+    QString locationString(const Location &location);
+    SymbolIndex &symbolIndex();
+    Elaboration &elaboration();
+    Connectivity &connectivity();
+    ClockDomains &clockDomains();
+    Lint &lint();
 
 signals:
     void modifiedChanged(bool modified);
+    void refreshed();
+    // Symbols of the files parsed so far have been added to the index, the refresh goes on
+    void symbolsParsed();
+    // Sent once per refresh, before refreshed(), with every change of the refresh
+    void designChanged(const DesignDiff::ChangeSet &changes);
     void fileAdded(QFileInfo fi);
     void fileRemoved(QFileInfo fi);
 };
@@ -0,0 +1,228 @@
+/* Lambila | SymbolIndex.cpp
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#include "SymbolIndex.h"
+
+#include <algorithm>
+
+/******************************************************************************/
+
+// Marks the beginning of a name, so that prefixes get their own trigrams
+static const QChar BOUNDARY = QChar(0x0001);
+
+static quint64 trigram(const QString &key, int position)
+{
+    return (quint64(key.at(position).unicode()) << 32) | (quint64(key.at(position + 1).unicode()) << 16) | quint64(key.at(position + 2).unicode());
+}
+
+/******************************************************************************/
+
+SymbolIndex::SymbolIndex()
+{
+    _removedCount = 0;
+}
+
+QString SymbolIndex::kindName(Kind kind)
+{
+    switch (kind)
+    {
+    case Kind::Entity:       return "entity";
+    case Kind::Architecture: return "architecture";
+    case Kind::Port:         return "port";
+    case Kind::Signal:       return "signal";
+    case Kind::Constant:     return "constant";
+    }
+    return QString();
+}
+
+/******************************************************************************/
+
+void SymbolIndex::addEntry(const QString &name, const QString &scope, Kind kind, const Location &location)
+{
+    const int id = _entries.count();
+    const QString key = BOUNDARY + name.trimmed().toLower();
+    _entries.append(Entry { name.trimmed(), scope, kind, location });
+    _keys.append(key);
+    _fileEntries[location.file].append(id);
+
+    // Each entry appears once per trigram, posting lists stay sorted since IDs only grow
+    QSet<quint64> trigrams;
+    for (int i = 0; i + 3 <= key.length(); ++i)
+    {
+        const quint64 t = trigram(key, i);
+        if (trigrams.contains(t))
+            continue;
+        trigrams.insert(t);
+        _postings[t].append(id);
+    }
+}
+
+void SymbolIndex::removeFiles(const QSet<FileId> &files)
+{
+    // Removed entries only lose their key, posting lists are cleaned up when compacting
+    for (FileId file : files)
+    {
+        const QList<int> entries = _fileEntries.take(file);
+        for (int id : entries)
+            _keys[id].clear();
+        _removedCount += entries.count();
+    }
+    if (_removedCount > _entries.count() / 2)
+        compact();
+}
+
+void SymbolIndex::compact()
+{
+    const QList<Entry> entries = _entries;
+    const QStringList keys = _keys;
+    clear();
+    for (int i = 0; i < entries.count(); ++i)
+        if (!keys.at(i).isEmpty())
+            addEntry(entries.at(i).name, entries.at(i).scope, entries.at(i).kind, entries.at(i).location);
+}
+
+void SymbolIndex::clear()
+{
+    _entries.clear();
+    _keys.clear();
+    _removedCount = 0;
+    _fileEntries.clear();
+    _postings.clear();
+    _hits.clear();
+}
+
+/******************************************************************************/
+
+QList<SymbolIndex::Entry> SymbolIndex::collect(Design *design, const QSet<FileId> &files)
+{
+    QList<Entry> entries;
+    const auto addEntry = [&](const QString &name, const QString &scope, Kind kind, const Location &location) {
+        entries.append(Entry { name.trimmed(), scope, kind, location });
+    };
+
+    // Architectures can be declared in another file than their entity
+    for (auto entity : design->getEntities())
+    {
+        const QString entityName = entity->name().section('.', -1);
+        if (files.contains(entity->file()))
+        {
+            addEntry(entityName, QString(), Kind::Entity, entity->location());
+            // Ports are indexed in lower case, their names are listed as declared
+            for (const QString &name : entity->portNames())
+                addEntry(name, entityName, Kind::Port, entity->port(name)->location);
+        }
+        for (auto architecture : entity->getArchitectures())
+        {
+            if (!files.contains(architecture->file()))
+                continue;
+            addEntry(architecture->name(), entityName, Kind::Architecture, architecture->location());
+            const QString scope = QString("%1(%2)").arg(entityName).arg(architecture->name());
+            for (auto it = architecture->getSignals().cbegin(); it != architecture->getSignals().cend(); ++it)
+                addEntry(it.key(), scope, Kind::Signal, it.value()->location);
+            for (auto it = architecture->getConstants().cbegin(); it != architecture->getConstants().cend(); ++it)
+                addEntry(it.key(), scope, Kind::Constant, it.value()->location);
+        }
+    }
+
+    // Deferred constants are completed in the package body, hence the location of each constant
+    for (auto package : design->getPackages())
+    {
+        const QString packageName = package->name().section('.', -1);
+        for (auto it = package->getConstants().cbegin(); it != package->getConstants().cend(); ++it)
+            if (files.contains(it.value()->location.file))
+                addEntry(it.key(), packageName, Kind::Constant, it.value()->location);
+    }
+    return entries;
+}
+
+void SymbolIndex::update(Design *design, const QSet<FileId> &files)
+{
+    add(files, collect(design, files));
+}
+
+void SymbolIndex::add(const QSet<FileId> &files, const QList<Entry> &entries)
+{
+    removeFiles(files);
+    for (const Entry &entry : entries)
+        addEntry(entry.name, entry.scope, entry.kind, entry.location);
+}
+
+/******************************************************************************/
+
+int SymbolIndex::score(int entry, const QString &query, int hits, int trigramCount) const
+{
+    // Share of the query trigrams found in the name
+    const QString &key = _keys.at(entry);
+    int score = (trigramCount != 0) ? hits * 100 / trigramCount : 0;
+
+    // Favor exact matches, then prefixes, then substrings, then short names
+    const int position = key.indexOf(query, 1);
+    if (position == 1)
+        score += (key.length() - 1 == query.length()) ? 200 : 100;
+    else if (position > 1)
+        score += 50;
+    score -= qMin(qAbs(key.length() - 1 - query.length()), 50);
+    return score;
+}
+
+QList<SymbolIndex::Entry> SymbolIndex::search(const QString &query, int count)
+{
+    QList<Entry> results;
+    const QString needle = query.trimmed().toLower();
+    if (needle.isEmpty() || count <= 0)
+        return results;
+
+    // Candidates with their score
+    QList<QPair<int, int>> ranked;
+    const QString key = BOUNDARY + needle;
+    if (key.length() < 3)
+    {
+        // Too short to have a trigram, compare with every name
+        for (int id = 0; id < _keys.count(); ++id)
+            if (!_keys.at(id).isEmpty() && _keys.at(id).contains(needle))
+                ranked.append({ score(id, needle, 0, 0), id });
+    }
+    else
+    {
+        QSet<quint64> trigrams;
+        for (int i = 0; i + 3 <= key.length(); ++i)
+            trigrams.insert(trigram(key, i));
+
+        // Count the trigrams shared with each name
+        _hits.resize(_entries.count());
+        QList<int> candidates;
+        for (quint64 t : trigrams)
+        {
+            const auto posting = _postings.constFind(t);
+            if (posting == _postings.cend())
+                continue;
+            for (int id : *posting)
+                if (_hits[id]++ == 0)
+                    candidates.append(id);
+        }
+
+        // Typos are tolerated as long as half of the trigrams match
+        const int threshold = (trigrams.count() + 1) / 2;
+        for (int id : candidates)
+        {
+            if (_hits.at(id) >= threshold && !_keys.at(id).isEmpty())
+                ranked.append({ score(id, needle, _hits.at(id), trigrams.count()), id });
+            _hits[id] = 0;
+        }
+    }
+
+    // Only the best ones have to be sorted
+    count = qMin(count, int(ranked.count()));
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(), [this](const QPair<int, int> &a, const QPair<int, int> &b) {
+        if (a.first != b.first)
+            return a.first > b.first;
+        return _keys.at(a.second) < _keys.at(b.second);
+    });
+    for (int i = 0; i < count; ++i)
+        results.append(_entries.at(ranked.at(i).second));
+    return results;
+}
@@ -0,0 +1,75 @@
+/* Lambila | SymbolIndex.h
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#ifndef SYMBOLINDEX_H
+#define SYMBOLINDEX_H
+
+/******************************************************************************/
+
+#include "Design.h"
+
+/******************************************************************************/
+
+// Trigram index over the names declared in the design, for fuzzy searches.
+// Entries are kept per file, so that only the files parsed again have to be indexed again.
+class SymbolIndex
+{
+public:
+    enum class Kind {
+        Entity,
+        Architecture,
+        Port,
+        Signal,
+        Constant
+    };
+
+    struct Entry {
+        QString name;
+        QString scope;
+        Kind kind;
+        Location location;
+    };
+
+protected:
+    // Names are stored in lower case, after a marker that gives a trigram to their beginning
+    QList<Entry> _entries;
+    QStringList _keys;
+    int _removedCount;
+
+    QHash<FileId, QList<int>> _fileEntries;
+    QHash<quint64, QList<int>> _postings;
+
+    // Trigram hits per entry, kept between searches to avoid reallocating it
+    QList<quint16> _hits;
+
+    void addEntry(const QString &name, const QString &scope, Kind kind, const Location &location);
+    void removeFiles(const QSet<FileId> &files);
+    void compact();
+    int score(int entry, const QString &query, int hits, int trigramCount) const;
+
+public:
+    SymbolIndex();
+
+    static QString kindName(Kind kind);
+
+    // Entries of everything declared in the given files, without indexing them
+    static QList<Entry> collect(Design *design, const QSet<FileId> &files);
+
+    // Index again everything declared in the given files
+    void update(Design *design, const QSet<FileId> &files);
+    // Index entries collected beforehand, while their files are still being parsed. They replace the entries of the
+    // files they were collected from, which can be parsed more than once.
+    void add(const QSet<FileId> &files, const QList<Entry> &entries);
+    void clear();
+
+    // Best matches first
+    QList<Entry> search(const QString &query, int count);
+};
+
+/******************************************************************************/
+
+#endif // SYMBOLINDEX_H
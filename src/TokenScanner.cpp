@@ -0,0 +1,196 @@
+/* Lambila | TokenScanner.cpp
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#include "TokenScanner.h"
+
+#if defined(Q_PROCESSOR_X86_64) || (defined(Q_PROCESSOR_X86) && defined(__SSE2__))
+#define TOKENSCANNER_SSE2
+#include <immintrin.h>
+#endif
+
+// The AVX2 kernels are compiled for that target only, and used when the processor supports it
+#if defined(TOKENSCANNER_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define TOKENSCANNER_AVX2
+#endif
+
+/******************************************************************************/
+
+typedef qsizetype (*SeparatorKernel)(const char16_t *data, qsizetype from, qsizetype size);
+typedef qsizetype (*EitherKernel)(const char16_t *data, qsizetype from, qsizetype size, char16_t first, char16_t second);
+
+static qsizetype findSeparatorScalar(const char16_t *data, qsizetype from, qsizetype size)
+{
+    for (; from < size; ++from)
+        if (TokenScanner::isSeparator(data[from]))
+            return from;
+    return size;
+}
+
+static qsizetype findEitherScalar(const char16_t *data, qsizetype from, qsizetype size, char16_t first, char16_t second)
+{
+    for (; from < size; ++from)
+        if (data[from] == first || data[from] == second)
+            return from;
+    return size;
+}
+
+/******************************************************************************/
+
+#ifdef TOKENSCANNER_SSE2
+
+// Each character gives two bits in the mask of the comparison
+static qsizetype firstMatch(qsizetype position, unsigned int mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return position + __builtin_ctz(mask) / 2;
+#else
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return position + index / 2;
+#endif
+}
+
+// Whitespaces from “\t” to “\r” are found with a single unsigned comparison, parentheses and “:;” differ in their last bit
+static qsizetype findSeparatorSse2(const char16_t *data, qsizetype from, qsizetype size)
+{
+    const __m128i space = _mm_set1_epi16(' ');
+    const __m128i tab = _mm_set1_epi16('\t');
+    const __m128i controls = _mm_set1_epi16('\r' - '\t');
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i parenthesis = _mm_set1_epi16(')');
+    const __m128i semicolon = _mm_set1_epi16(';');
+    const __m128i zero = _mm_setzero_si128();
+    for (; from + 8 <= size; from += 8)
+    {
+        const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + from));
+        const __m128i odd = _mm_or_si128(chars, one);
+        __m128i matches = _mm_cmpeq_epi16(chars, space);
+        matches = _mm_or_si128(matches, _mm_cmpeq_epi16(_mm_subs_epu16(_mm_sub_epi16(chars, tab), controls), zero));
+        matches = _mm_or_si128(matches, _mm_cmpeq_epi16(odd, parenthesis));
+        matches = _mm_or_si128(matches, _mm_cmpeq_epi16(odd, semicolon));
+        const unsigned int mask = _mm_movemask_epi8(matches);
+        if (mask != 0)
+            return firstMatch(from, mask);
+    }
+    return findSeparatorScalar(data, from, size);
+}
+
+static qsizetype findEitherSse2(const char16_t *data, qsizetype from, qsizetype size, char16_t first, char16_t second)
+{
+    const __m128i firstChars = _mm_set1_epi16(first);
+    const __m128i secondChars = _mm_set1_epi16(second);
+    for (; from + 8 <= size; from += 8)
+    {
+        const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + from));
+        const __m128i matches = _mm_or_si128(_mm_cmpeq_epi16(chars, firstChars), _mm_cmpeq_epi16(chars, secondChars));
+        const unsigned int mask = _mm_movemask_epi8(matches);
+        if (mask != 0)
+            return firstMatch(from, mask);
+    }
+    return findEitherScalar(data, from, size, first, second);
+}
+
+#endif
+
+/******************************************************************************/
+
+#ifdef TOKENSCANNER_AVX2
+
+__attribute__((target("avx2")))
+static qsizetype findSeparatorAvx2(const char16_t *data, qsizetype from, qsizetype size)
+{
+    const __m256i space = _mm256_set1_epi16(' ');
+    const __m256i tab = _mm256_set1_epi16('\t');
+    const __m256i controls = _mm256_set1_epi16('\r' - '\t');
+    const __m256i one = _mm256_set1_epi16(1);
+    const __m256i parenthesis = _mm256_set1_epi16(')');
+    const __m256i semicolon = _mm256_set1_epi16(';');
+    const __m256i zero = _mm256_setzero_si256();
+    for (; from + 16 <= size; from += 16)
+    {
+        const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + from));
+        const __m256i odd = _mm256_or_si256(chars, one);
+        __m256i matches = _mm256_cmpeq_epi16(chars, space);
+        matches = _mm256_or_si256(matches, _mm256_cmpeq_epi16(_mm256_subs_epu16(_mm256_sub_epi16(chars, tab), controls), zero));
+        matches = _mm256_or_si256(matches, _mm256_cmpeq_epi16(odd, parenthesis));
+        matches = _mm256_or_si256(matches, _mm256_cmpeq_epi16(odd, semicolon));
+        const unsigned int mask = _mm256_movemask_epi8(matches);
+        if (mask != 0)
+            return firstMatch(from, mask);
+    }
+    return findSeparatorSse2(data, from, size);
+}
+
+__attribute__((target("avx2")))
+static qsizetype findEitherAvx2(const char16_t *data, qsizetype from, qsizetype size, char16_t first, char16_t second)
+{
+    const __m256i firstChars = _mm256_set1_epi16(first);
+    const __m256i secondChars = _mm256_set1_epi16(second);
+    for (; from + 16 <= size; from += 16)
+    {
+        const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + from));
+        const __m256i matches = _mm256_or_si256(_mm256_cmpeq_epi16(chars, firstChars), _mm256_cmpeq_epi16(chars, secondChars));
+        const unsigned int mask = _mm256_movemask_epi8(matches);
+        if (mask != 0)
+            return firstMatch(from, mask);
+    }
+    return findEitherSse2(data, from, size, first, second);
+}
+
+#endif
+
+/******************************************************************************/
+
+static bool hasAvx2()
+{
+#ifdef TOKENSCANNER_AVX2
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+static SeparatorKernel separatorKernel()
+{
+#ifdef TOKENSCANNER_AVX2
+    if (hasAvx2())
+        return findSeparatorAvx2;
+#endif
+#ifdef TOKENSCANNER_SSE2
+    return findSeparatorSse2;
+#else
+    return findSeparatorScalar;
+#endif
+}
+
+static EitherKernel eitherKernel()
+{
+#ifdef TOKENSCANNER_AVX2
+    if (hasAvx2())
+        return findEitherAvx2;
+#endif
+#ifdef TOKENSCANNER_SSE2
+    return findEitherSse2;
+#else
+    return findEitherScalar;
+#endif
+}
+
+/******************************************************************************/
+
+qsizetype TokenScanner::findSeparator(const QString &line, qsizetype from)
+{
+    static const SeparatorKernel kernel = separatorKernel();
+    return kernel(reinterpret_cast<const char16_t *>(line.constData()), from, line.size());
+}
+
+qsizetype TokenScanner::findEither(const QString &line, qsizetype from, char16_t first, char16_t second)
+{
+    static const EitherKernel kernel = eitherKernel();
+    return kernel(reinterpret_cast<const char16_t *>(line.constData()), from, line.size(), first, second);
+}
@@ -0,0 +1,36 @@
+/* Lambila | TokenScanner.h
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#ifndef TOKENSCANNER_H
+#define TOKENSCANNER_H
+
+/******************************************************************************/
+
+#include <QString>
+
+/******************************************************************************/
+
+// Search for the characters that end the tokens of a line, several characters at a time.
+// The characters are compared 16 at a time with AVX2, or 8 at a time with SSE2, the kernel being selected once from the
+// features of the processor. Other processors use a plain loop.
+class TokenScanner
+{
+public:
+    // Index of the next separator from a position: “(”, “)”, “:”, “;” or an ASCII whitespace, the size if there is none
+    static qsizetype findSeparator(const QString &line, qsizetype from);
+    // Index of the next occurrence of either character from a position, the size if there is none
+    static qsizetype findEither(const QString &line, qsizetype from, char16_t first, char16_t second);
+
+    static bool isSeparator(char16_t c)
+    {
+        return c == ' ' || (c >= '\t' && c <= '\r') || c == '(' || c == ')' || c == ':' || c == ';';
+    }
+};
+
+/******************************************************************************/
+
+#endif // TOKENSCANNER_H
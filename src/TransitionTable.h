@@ -0,0 +1,81 @@
+/* Lambila | TransitionTable.h
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#ifndef TRANSITIONTABLE_H
+#define TRANSITIONTABLE_H
+
+/******************************************************************************/
+
+// (state, token class) → transition table for the parser state machines.
+// Derived classes fill the table from a constexpr constructor, so that it is fully computed at compile time.
+// State and TokenClass must end with a Count value, Action must provide an Unexpected value.
+template <typename State, typename TokenClass, typename Action>
+class TransitionTable {
+public:
+    // A transition pops some states, then pushes up to three new ones (the last one ends up on top)
+    struct Transition {
+        Action action = Action();
+        int popCount = 0;
+        int pushCount = 0;
+        State pushed[3] = { };
+    };
+
+protected:
+    static constexpr int STATE_COUNT = static_cast<int>(State::Count);
+    static constexpr int TOKEN_CLASS_COUNT = static_cast<int>(TokenClass::Count);
+
+    Transition _transitions[STATE_COUNT][TOKEN_CLASS_COUNT] = { };
+
+    template <typename... States>
+    static constexpr Transition to(Action action, int popCount, States... pushed)
+    {
+        return Transition { action, popCount, sizeof...(pushed), { pushed... } };
+    }
+    static constexpr Transition stay(Action action = Action())
+    {
+        return to(action, 0);
+    }
+    static constexpr Transition pop(int count = 1, Action action = Action())
+    {
+        return to(action, count);
+    }
+    template <typename... States>
+    static constexpr Transition push(Action action, States... pushed)
+    {
+        return to(action, 0, pushed...);
+    }
+    template <typename... States>
+    static constexpr Transition replace(Action action, States... pushed)
+    {
+        return to(action, 1, pushed...);
+    }
+
+    constexpr void otherwise(State state, const Transition &transition)
+    {
+        for (int c = 0; c < TOKEN_CLASS_COUNT; ++c)
+            _transitions[static_cast<int>(state)][c] = transition;
+    }
+    constexpr void on(State state, TokenClass tokenClass, const Transition &transition)
+    {
+        _transitions[static_cast<int>(state)][static_cast<int>(tokenClass)] = transition;
+    }
+    constexpr void expect(State state, TokenClass tokenClass)
+    {
+        otherwise(state, stay(Action::Unexpected));
+        on(state, tokenClass, pop());
+    }
+
+public:
+    constexpr const Transition &at(State state, TokenClass tokenClass) const
+    {
+        return _transitions[static_cast<int>(state)][static_cast<int>(tokenClass)];
+    }
+};
+
+/******************************************************************************/
+
+#endif // TRANSITIONTABLE_H
@@ -0,0 +1,138 @@
+/* Lambila | UnitGraph.cpp
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#include "UnitGraph.h"
+
+/******************************************************************************/
+
+int UnitGraph::addUnit(Kind kind, const QString &name, FileId file)
+{
+    _units.append(Unit { kind, name, file });
+    _dependencies.append(QList<int>());
+    _secondaryUnits.append(QList<int>());
+    return _units.count() - 1;
+}
+
+void UnitGraph::addUses(Design *design, int unit, const QMultiHash<QString, Use> &uses)
+{
+    for (auto it = uses.cbegin(); it != uses.cend(); ++it)
+    {
+        Package *package = design->package(QString("%1.%2").arg(it.key()).arg(it.value().section('.', 0, 0)));
+        if (package == nullptr)
+            continue;
+        const int dependency = _packageUnits.value(package->name().toLower(), -1);
+        if (dependency != -1 && !_dependencies.at(unit).contains(dependency))
+            _dependencies[unit].append(dependency);
+    }
+}
+
+void UnitGraph::build(Design *design)
+{
+    clear();
+
+    // Create the primary units first, so that any of them can be referred to
+    for (auto entity : design->getEntities())
+        _entityUnits.insert(entity->name(), addUnit(Kind::Entity, entity->name(), entity->file()));
+    for (auto package : design->getPackages())
+        _packageUnits.insert(package->name().toLower(), addUnit(Kind::Package, package->name(), package->file()));
+
+    for (auto entity : design->getEntities())
+    {
+        const int entityUnit = _entityUnits.value(entity->name());
+        addUses(design, entityUnit, entity->getUses());
+        for (auto architecture : entity->getArchitectures())
+        {
+            // The context clause of the entity applies to its architectures
+            const int architectureUnit = addUnit(Kind::Architecture, QString("%1(%2)").arg(entity->name()).arg(architecture->name()), architecture->file());
+            _dependencies[architectureUnit].append(entityUnit);
+            _secondaryUnits[entityUnit].append(architectureUnit);
+            addUses(design, architectureUnit, entity->getUses());
+            // Summarized architectures only have the instance counts
+            const QHash<QString, qint64> instanceCounts = architecture->instanceCounts();
+            for (auto it = instanceCounts.cbegin(); it != instanceCounts.cend(); ++it)
+            {
+                const int instantiated = _entityUnits.value(it.key(), -1);
+                if (instantiated != -1 && !_dependencies.at(architectureUnit).contains(instantiated))
+                    _dependencies[architectureUnit].append(instantiated);
+            }
+        }
+    }
+
+    for (auto package : design->getPackages())
+    {
+        const int packageUnit = _packageUnits.value(package->name().toLower());
+        addUses(design, packageUnit, package->getUses());
+        if (package->bodyFile() == INVALID_FILE_ID)
+            continue;
+        const int bodyUnit = addUnit(Kind::PackageBody, package->name(), package->bodyFile());
+        _dependencies[bodyUnit].append(packageUnit);
+        _secondaryUnits[packageUnit].append(bodyUnit);
+        addUses(design, bodyUnit, package->getBodyUses());
+    }
+}
+
+void UnitGraph::clear()
+{
+    _units.clear();
+    _entityUnits.clear();
+    _packageUnits.clear();
+    _dependencies.clear();
+    _secondaryUnits.clear();
+}
+
+/******************************************************************************/
+
+const QList<UnitGraph::Unit> &UnitGraph::getUnits() const
+{
+    return _units;
+}
+
+const QList<int> &UnitGraph::dependencies(int unit) const
+{
+    return _dependencies.at(unit);
+}
+
+int UnitGraph::entityUnit(const QString &name) const
+{
+    return _entityUnits.value(name, -1);
+}
+
+/******************************************************************************/
+
+QList<int> UnitGraph::reachableUnits(const QString &topEntity) const
+{
+    QList<int> reachable;
+    const int top = entityUnit(topEntity);
+    if (top == -1)
+        return reachable;
+
+    // Breadth-first walk, each unit and each edge is visited once
+    QList<bool> visited(_units.count(), false);
+    visited[top] = true;
+    reachable.append(top);
+    for (int i = 0; i < reachable.count(); ++i)
+    {
+        const int unit = reachable.at(i);
+        for (const QList<int> *edges : { &_dependencies.at(unit), &_secondaryUnits.at(unit) })
+            for (int next : *edges)
+            {
+                if (visited.at(next))
+                    continue;
+                visited[next] = true;
+                reachable.append(next);
+            }
+    }
+    return reachable;
+}
+
+QSet<FileId> UnitGraph::reachableFiles(const QString &topEntity) const
+{
+    QSet<FileId> files;
+    for (int unit : reachableUnits(topEntity))
+        files.insert(_units.at(unit).file);
+    return files;
+}
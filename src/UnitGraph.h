@@ -0,0 +1,63 @@
+/* Lambila | UnitGraph.h
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#ifndef UNITGRAPH_H
+#define UNITGRAPH_H
+
+/******************************************************************************/
+
+#include "Design.h"
+
+/******************************************************************************/
+
+// Dependencies between the design units, built once after each refresh
+class UnitGraph
+{
+public:
+    enum class Kind {
+        Entity,
+        Architecture,
+        Package,
+        PackageBody
+    };
+
+    struct Unit {
+        Kind kind;
+        QString name;
+        FileId file;
+    };
+
+protected:
+    QList<Unit> _units;
+    QHash<QString, int> _entityUnits;
+    QHash<QString, int> _packageUnits;
+
+    // Units that have to be analyzed first: used packages, the entity of an architecture,
+    // instantiated entities, the declaration of a package body
+    QList<QList<int>> _dependencies;
+    // Units that are analyzed afterwards but needed to elaborate: architectures of an entity, package bodies
+    QList<QList<int>> _secondaryUnits;
+
+    int addUnit(Kind kind, const QString &name, FileId file);
+    void addUses(Design *design, int unit, const QMultiHash<QString, Use> &uses);
+
+public:
+    void build(Design *design);
+    void clear();
+
+    const QList<Unit> &getUnits() const;
+    const QList<int> &dependencies(int unit) const;
+    int entityUnit(const QString &name) const;
+
+    // Units needed to elaborate the given entity, in a single walk over the graph
+    QList<int> reachableUnits(const QString &topEntity) const;
+    QSet<FileId> reachableFiles(const QString &topEntity) const;
+};
+
+/******************************************************************************/
+
+#endif // UNITGRAPH_H
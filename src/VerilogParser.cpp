@@ -0,0 +1,799 @@
+/* Lambila | VerilogParser.cpp
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#include "InlineStack.h"
+#include "Logger.h"
+#include "TransitionTable.h"
+#include "VerilogParser.h"
+
+#include <QApplication>
+#include <QBuffer>
+#include <QRegularExpression>
+
+/******************************************************************************/
+
+static const char WORKSPACE_NAME[] = "work";
+static const char ARCHITECTURE_NAME[] = "verilog";
+static const int MAX_NESTING_DEPTH = 256;
+
+/******************************************************************************/
+
+VerilogParser::VerilogParser(const QFileInfo &sourceFile, Design *design, QObject *parent) : QObject(parent)
+{
+    _sourceFile = sourceFile;
+    _design = design;
+}
+
+void VerilogParser::setContents(const QByteArray &contents)
+{
+    _contents = contents;
+}
+
+/******************************************************************************/
+
+enum class VerilogParser::State {
+    Base,
+
+    ModuleName,
+    ModuleHeader,
+    PortList,
+    ModuleBody,
+    Declaration,
+    ParameterList,
+    ParameterValue,
+    Instance,
+
+    ExpectOpeningParenthesis,
+
+    SkipToSemicolon,
+    SkipInitializer,
+    SkipDelay,
+    SkipStatement,
+    SkipBlock,
+    SkipParentheses,
+    SkipBrackets,
+    SkipBraces,
+    SkipFunction,
+    SkipSpecify,
+    SkipPrimitive,
+
+    Count
+};
+
+enum class VerilogParser::Target {
+    Port,
+    Signal
+};
+
+/******************************************************************************/
+
+enum class VerilogParser::TokenClass {
+    // Handled before the transition table lookup
+    Whitespace,
+
+    // Generic tokens
+    Other,
+    Identifier,
+
+    // Delimiters
+    OpeningParenthesis,
+    ClosingParenthesis,
+    OpeningBracket,
+    ClosingBracket,
+    OpeningBrace,
+    ClosingBrace,
+    Colon,
+    Semicolon,
+    Comma,
+    Equal,
+    Hash,
+
+    // Keywords, several of them share the same class
+    Always,
+    Assign,
+    Begin,
+    Case,
+    Else,
+    End,
+    Endcase,
+    Endfunction,
+    Endgenerate,
+    Endmodule,
+    Endprimitive,
+    Endspecify,
+    Function,
+    Generate,
+    If,
+    Inout,
+    Input,
+    Loop,
+    Module,
+    Net,
+    Output,
+    Parameter,
+    Primitive,
+    Signed,
+    SkippedItem,
+    Specify,
+    Variable,
+
+    Count
+};
+
+/******************************************************************************/
+
+class VerilogParser::Token : public QString {
+protected:
+    struct Keyword {
+        const char *word;
+        TokenClass tokenClass;
+    };
+
+    // Sorted list of the keywords, Verilog is case sensitive
+    static constexpr Keyword KEYWORDS[] = {
+        { "always",       TokenClass::Always },
+        { "assign",       TokenClass::Assign },
+        { "begin",        TokenClass::Begin },
+        { "case",         TokenClass::Case },
+        { "casex",        TokenClass::Case },
+        { "casez",        TokenClass::Case },
+        { "defparam",     TokenClass::SkippedItem },
+        { "else",         TokenClass::Else },
+        { "end",          TokenClass::End },
+        { "endcase",      TokenClass::Endcase },
+        { "endfunction",  TokenClass::Endfunction },
+        { "endgenerate",  TokenClass::Endgenerate },
+        { "endmodule",    TokenClass::Endmodule },
+        { "endprimitive", TokenClass::Endprimitive },
+        { "endspecify",   TokenClass::Endspecify },
+        { "endtask",      TokenClass::Endfunction },
+        { "event",        TokenClass::SkippedItem },
+        { "for",          TokenClass::Loop },
+        { "forever",      TokenClass::Loop },
+        { "fork",         TokenClass::Begin },
+        { "function",     TokenClass::Function },
+        { "generate",     TokenClass::Generate },
+        { "genvar",       TokenClass::Variable },
+        { "if",           TokenClass::If },
+        { "initial",      TokenClass::Always },
+        { "inout",        TokenClass::Inout },
+        { "input",        TokenClass::Input },
+        { "integer",      TokenClass::Variable },
+        { "join",         TokenClass::End },
+        { "localparam",   TokenClass::Parameter },
+        { "macromodule",  TokenClass::Module },
+        { "module",       TokenClass::Module },
+        { "output",       TokenClass::Output },
+        { "parameter",    TokenClass::Parameter },
+        { "primitive",    TokenClass::Primitive },
+        { "real",         TokenClass::Variable },
+        { "realtime",     TokenClass::Variable },
+        { "reg",          TokenClass::Variable },
+        { "repeat",       TokenClass::Loop },
+        { "signed",       TokenClass::Signed },
+        { "specify",      TokenClass::Specify },
+        { "specparam",    TokenClass::SkippedItem },
+        { "supply0",      TokenClass::Net },
+        { "supply1",      TokenClass::Net },
+        { "task",         TokenClass::Function },
+        { "time",         TokenClass::Variable },
+        { "tri",          TokenClass::Net },
+        { "tri0",         TokenClass::Net },
+        { "tri1",         TokenClass::Net },
+        { "triand",       TokenClass::Net },
+        { "trior",        TokenClass::Net },
+        { "trireg",       TokenClass::Net },
+        { "unsigned",     TokenClass::Signed },
+        { "uwire",        TokenClass::Net },
+        { "wand",         TokenClass::Net },
+        { "while",        TokenClass::Loop },
+        { "wire",         TokenClass::Net },
+        { "wor",          TokenClass::Net }
+    };
+
+public:
+    Token(const QString &str) : QString(str) { }
+
+    TokenClass tokenClass() const
+    {
+        const QChar first = at(0);
+        if (first.isSpace())
+            return TokenClass::Whitespace;
+        if (length() == 1)
+        {
+            switch (first.unicode())
+            {
+            case '(': return TokenClass::OpeningParenthesis;
+            case ')': return TokenClass::ClosingParenthesis;
+            case '[': return TokenClass::OpeningBracket;
+            case ']': return TokenClass::ClosingBracket;
+            case '{': return TokenClass::OpeningBrace;
+            case '}': return TokenClass::ClosingBrace;
+            case ':': return TokenClass::Colon;
+            case ';': return TokenClass::Semicolon;
+            case ',': return TokenClass::Comma;
+            case '=': return TokenClass::Equal;
+            case '#': return TokenClass::Hash;
+            default: break;
+            }
+        }
+
+        // Escaped identifiers run up to the next whitespace
+        if (first == '\\')
+            return TokenClass::Identifier;
+        if (!first.isLetter() && first != '_')
+            return TokenClass::Other;
+        for (int i = 1; i < length(); ++i)
+            if (!at(i).isLetterOrNumber() && at(i) != '_' && at(i) != '$')
+                return TokenClass::Other;
+
+        // Look for a keyword using a binary search
+        int low = 0;
+        int high = sizeof(KEYWORDS) / sizeof(KEYWORDS[0]) - 1;
+        while (low <= high)
+        {
+            const int middle = (low + high) / 2;
+            const int c = compare(QLatin1String(KEYWORDS[middle].word));
+            if (c == 0)
+                return KEYWORDS[middle].tokenClass;
+            if (c < 0)
+                high = middle - 1;
+            else
+                low = middle + 1;
+        }
+        return TokenClass::Identifier;
+    }
+};
+
+/******************************************************************************/
+
+// Semantic actions, executed before the stack operation of a transition
+enum class VerilogParser::Action {
+    None,
+    Unexpected,
+
+    AddModule,
+    EndModule,
+
+    SelectPortList,
+    SelectPort,
+    SelectSignal,
+    SetDirection,
+    DeclareName,
+    AddDeclaration,
+    AppendType,
+    OpenRange,
+    CloseRange,
+
+    BeginParameter,
+    BeginValue,
+    AppendValue,
+    OpenValue,
+    CloseValue,
+    AddParameter,
+    NextParameter,
+    CloseParameterList,
+
+    BeginInstance,
+    AddInstance
+};
+
+// (state, token class) → transition table, fully computed at compile time
+class VerilogParser::TransitionTable : public ::TransitionTable<State, TokenClass, Action> {
+public:
+    constexpr TransitionTable()
+    {
+        using S = State;
+        using T = TokenClass;
+        using A = Action;
+
+        otherwise(S::Base, stay(A::Unexpected));
+        on(S::Base, T::Module,    push(A::None, S::ModuleName));
+        on(S::Base, T::Primitive, push(A::None, S::SkipPrimitive));
+        on(S::Base, T::Semicolon, stay());
+
+        /******************************************************************************/
+
+        otherwise(S::ModuleName, stay(A::Unexpected));
+        on(S::ModuleName, T::Identifier, replace(A::AddModule, S::ModuleHeader));
+
+        otherwise(S::ModuleHeader, stay(A::Unexpected));
+        on(S::ModuleHeader, T::Hash,               push(A::None, S::ParameterList, S::ExpectOpeningParenthesis));
+        on(S::ModuleHeader, T::OpeningParenthesis, push(A::SelectPortList, S::PortList));
+        on(S::ModuleHeader, T::Semicolon,          replace(A::None, S::ModuleBody));
+
+        // Both ANSI style declarations and plain port names are accepted
+        otherwise(S::PortList, stay(A::AppendType));
+        on(S::PortList, T::Input,              stay(A::SetDirection));
+        on(S::PortList, T::Output,             stay(A::SetDirection));
+        on(S::PortList, T::Inout,              stay(A::SetDirection));
+        on(S::PortList, T::Identifier,         stay(A::DeclareName));
+        on(S::PortList, T::OpeningBracket,     stay(A::OpenRange));
+        on(S::PortList, T::ClosingBracket,     stay(A::CloseRange));
+        on(S::PortList, T::Comma,              stay(A::AddDeclaration));
+        on(S::PortList, T::ClosingParenthesis, pop(1, A::AddDeclaration));
+
+        otherwise(S::ModuleBody, stay(A::Unexpected));
+        on(S::ModuleBody, T::Input,       push(A::SelectPort, S::Declaration));
+        on(S::ModuleBody, T::Output,      push(A::SelectPort, S::Declaration));
+        on(S::ModuleBody, T::Inout,       push(A::SelectPort, S::Declaration));
+        on(S::ModuleBody, T::Net,         push(A::SelectSignal, S::Declaration));
+        on(S::ModuleBody, T::Variable,    push(A::SelectSignal, S::Declaration));
+        on(S::ModuleBody, T::Parameter,   push(A::BeginParameter, S::ParameterList));
+        on(S::ModuleBody, T::Identifier,  push(A::BeginInstance, S::Instance));
+        on(S::ModuleBody, T::Assign,      push(A::None, S::SkipToSemicolon));
+        on(S::ModuleBody, T::SkippedItem, push(A::None, S::SkipToSemicolon));
+        on(S::ModuleBody, T::Always,      push(A::None, S::SkipStatement));
+        on(S::ModuleBody, T::If,          push(A::None, S::SkipStatement));
+        on(S::ModuleBody, T::Else,        push(A::None, S::SkipStatement));
+        on(S::ModuleBody, T::Loop,        push(A::None, S::SkipStatement));
+        on(S::ModuleBody, T::Begin,       push(A::None, S::SkipBlock));
+        on(S::ModuleBody, T::Case,        push(A::None, S::SkipBlock));
+        on(S::ModuleBody, T::Function,    push(A::None, S::SkipFunction));
+        on(S::ModuleBody, T::Specify,     push(A::None, S::SkipSpecify));
+        on(S::ModuleBody, T::Generate,    stay());
+        on(S::ModuleBody, T::Endgenerate, stay());
+        on(S::ModuleBody, T::Semicolon,   stay());
+        on(S::ModuleBody, T::Endmodule,   pop(1, A::EndModule));
+
+        otherwise(S::Declaration, stay(A::AppendType));
+        on(S::Declaration, T::Identifier,     stay(A::DeclareName));
+        on(S::Declaration, T::OpeningBracket, stay(A::OpenRange));
+        on(S::Declaration, T::ClosingBracket, stay(A::CloseRange));
+        on(S::Declaration, T::Equal,          push(A::None, S::SkipInitializer));
+        on(S::Declaration, T::Comma,          stay(A::AddDeclaration));
+        on(S::Declaration, T::Semicolon,      pop(1, A::AddDeclaration));
+
+        // Used for the module parameter port list as well as for parameter declarations
+        otherwise(S::ParameterList, stay(A::AppendType));
+        on(S::ParameterList, T::Parameter,          stay(A::BeginParameter));
+        on(S::ParameterList, T::Identifier,         stay(A::DeclareName));
+        on(S::ParameterList, T::OpeningBracket,     stay(A::OpenRange));
+        on(S::ParameterList, T::ClosingBracket,     stay(A::CloseRange));
+        on(S::ParameterList, T::Equal,              push(A::BeginValue, S::ParameterValue));
+        on(S::ParameterList, T::Comma,              stay());
+        on(S::ParameterList, T::Semicolon,          pop());
+        on(S::ParameterList, T::ClosingParenthesis, pop());
+
+        otherwise(S::ParameterValue, stay(A::AppendValue));
+        on(S::ParameterValue, T::OpeningParenthesis, stay(A::OpenValue));
+        on(S::ParameterValue, T::OpeningBracket,     stay(A::OpenValue));
+        on(S::ParameterValue, T::OpeningBrace,       stay(A::OpenValue));
+        on(S::ParameterValue, T::ClosingBracket,     stay(A::CloseValue));
+        on(S::ParameterValue, T::ClosingBrace,       stay(A::CloseValue));
+        on(S::ParameterValue, T::Comma,              pop(1, A::NextParameter));
+        on(S::ParameterValue, T::ClosingParenthesis, pop(2, A::CloseParameterList));
+        on(S::ParameterValue, T::Semicolon,          pop(2, A::AddParameter));
+
+        // Module instances and gate primitives
+        otherwise(S::Instance, stay(A::Unexpected));
+        on(S::Instance, T::Identifier,         stay(A::AddInstance));
+        on(S::Instance, T::Hash,               push(A::None, S::SkipDelay));
+        on(S::Instance, T::OpeningBracket,     push(A::None, S::SkipBrackets));
+        on(S::Instance, T::OpeningParenthesis, push(A::None, S::SkipParentheses));
+        on(S::Instance, T::Comma,              stay());
+        on(S::Instance, T::Semicolon,          pop());
+
+        /******************************************************************************/
+
+        expect(S::ExpectOpeningParenthesis, T::OpeningParenthesis);
+
+        /******************************************************************************/
+
+        otherwise(S::SkipToSemicolon, stay());
+        on(S::SkipToSemicolon, T::Semicolon, pop());
+
+        otherwise(S::SkipInitializer, stay());
+        on(S::SkipInitializer, T::OpeningParenthesis, push(A::None, S::SkipParentheses));
+        on(S::SkipInitializer, T::OpeningBrace,       push(A::None, S::SkipBraces));
+        on(S::SkipInitializer, T::Comma,              pop(1, A::AddDeclaration));
+        on(S::SkipInitializer, T::Semicolon,          pop(2, A::AddDeclaration));
+
+        // Either a parameter value assignment or a delay
+        otherwise(S::SkipDelay, pop());
+        on(S::SkipDelay, T::OpeningParenthesis, replace(A::None, S::SkipParentheses));
+
+        // A statement ends with a semicolon, unless it is a block
+        otherwise(S::SkipStatement, stay());
+        on(S::SkipStatement, T::Semicolon,          pop());
+        on(S::SkipStatement, T::OpeningParenthesis, push(A::None, S::SkipParentheses));
+        on(S::SkipStatement, T::OpeningBrace,       push(A::None, S::SkipBraces));
+        on(S::SkipStatement, T::Begin,              replace(A::None, S::SkipBlock));
+        on(S::SkipStatement, T::Case,               replace(A::None, S::SkipBlock));
+
+        otherwise(S::SkipBlock, stay());
+        on(S::SkipBlock, T::Begin,   push(A::None, S::SkipBlock));
+        on(S::SkipBlock, T::Case,    push(A::None, S::SkipBlock));
+        on(S::SkipBlock, T::End,     pop());
+        on(S::SkipBlock, T::Endcase, pop());
+
+        otherwise(S::SkipParentheses, stay());
+        on(S::SkipParentheses, T::OpeningParenthesis, push(A::None, S::SkipParentheses));
+        on(S::SkipParentheses, T::ClosingParenthesis, pop());
+
+        otherwise(S::SkipBrackets, stay());
+        on(S::SkipBrackets, T::OpeningBracket, push(A::None, S::SkipBrackets));
+        on(S::SkipBrackets, T::ClosingBracket, pop());
+
+        otherwise(S::SkipBraces, stay());
+        on(S::SkipBraces, T::OpeningBrace, push(A::None, S::SkipBraces));
+        on(S::SkipBraces, T::ClosingBrace, pop());
+
+        otherwise(S::SkipFunction, stay());
+        on(S::SkipFunction, T::Endfunction, pop());
+
+        otherwise(S::SkipSpecify, stay());
+        on(S::SkipSpecify, T::Endspecify, pop());
+
+        otherwise(S::SkipPrimitive, stay());
+        on(S::SkipPrimitive, T::Endprimitive, pop());
+    }
+};
+
+/******************************************************************************/
+
+// Blank comments and the contents of string literals, block comments can span several lines.
+// The other characters keep their position, so that columns can still be reported.
+static QString stripComments(const QString &line, bool &inBlockComment)
+{
+    QString result = line;
+    bool inString = false;
+    for (int i = 0; i < result.length(); ++i)
+    {
+        const QChar c = result.at(i);
+        const QChar next = (i + 1 < result.length()) ? result.at(i + 1) : QChar();
+        if (inBlockComment)
+        {
+            if (c == '*' && next == '/')
+            {
+                inBlockComment = false;
+                result[i + 1] = ' ';
+            }
+            result[i] = ' ';
+            continue;
+        }
+        if (inString)
+        {
+            // String contents become a single token
+            if (c == '"')
+                inString = false;
+            else if (c == '\\' && i + 1 < result.length())
+            {
+                result[i] = '_';
+                result[++i] = '_';
+            }
+            else if (c != '\n')
+                result[i] = '_';
+            continue;
+        }
+        if (c == '/' && next == '/')
+        {
+            result.replace(i, result.length() - i, QString(result.length() - i, ' '));
+            break;
+        }
+        if (c == '/' && next == '*')
+        {
+            inBlockComment = true;
+            result[i] = ' ';
+            result[++i] = ' ';
+            continue;
+        }
+        if (c == '"')
+            inString = true;
+    }
+    return result;
+}
+
+// Use the same port directions as VHDL
+static QString portDirection(const QString &keyword)
+{
+    if (keyword == "input")
+        return "in";
+    if (keyword == "output")
+        return "out";
+    return keyword;
+}
+
+/******************************************************************************/
+
+bool VerilogParser::parse()
+{
+    static constexpr TransitionTable transitions;
+
+    QString errorString;
+    InlineStack<State, MAX_NESTING_DEPTH> state;
+    state.push(State::Base);
+    int rangeDepth = 0;
+    int parenCount = 0;
+
+    Entity *currentEntity = nullptr;
+    Architecture *currentArchitecture = nullptr;
+    Target target = Target::Signal;
+
+    QString name;
+    QString direction;
+    QString type;
+    QString dimensions;
+    QString value;
+    QString unit;
+
+    // Ranges after the name belong to that name only
+    const auto appendType = [&](const QString &token) {
+        QString &text = name.isEmpty() ? type : dimensions;
+        if (!text.isEmpty() && !text.endsWith('[') && !text.endsWith(':') && token != "]" && token != ":")
+            text += ' ';
+        text += token;
+    };
+
+    // Open the source file
+    const QString filePath = _sourceFile.canonicalFilePath();
+    Logger::info(tr("Parsing %1").arg(filePath));
+    QFile sourceFile(filePath);
+    QBuffer buffer(&_contents);
+    QIODevice &file = _contents.isNull() ? static_cast<QIODevice &>(sourceFile) : buffer;
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        Logger::error(tr("Failed to open file: %1").arg(file.errorString()));
+        return false;
+    }
+    const FileId fileId = _design->addFile(filePath, _sourceFile.lastModified());
+
+    // Parse the file
+    const bool tracing = Logger::verbosity() >= Logger::LogLevel::Trace;
+    const QRegularExpression separator("(?=[\\(\\)\\[\\]\\{\\};,#@:\\s])|(?<=[\\(\\)\\[\\]\\{\\};,#@:\\s])|(?<![=!<>])(?==(?!=))|(?<=^=|[^=!<>]=)(?!=)");
+    bool inBlockComment = false;
+    bool inDirective = false;
+    unsigned int lineNumber = 0;
+
+    // Locations are character offsets in the file, lines are found from the line offset table
+    QList<quint32> lineOffsets;
+    quint32 lineOffset = 0;
+    Location tokenLocation { fileId, 0 };
+    Location nameLocation;
+    Location unitLocation;
+
+    // Only declarations and instances are recorded for now
+    CrossReferenceIndex &references = _design->references();
+    const auto addReference = [&](const QString &identifier, const Location &location, Reference::Kind kind) {
+        const QString scope = (currentEntity != nullptr) ? currentEntity->name() : QString(WORKSPACE_NAME);
+        references.addReference(Reference { references.identifier(identifier), references.identifier(scope), location, kind });
+    };
+
+    while (!file.atEnd())
+    {
+        lineNumber += 1;
+        const QString line = stripComments(QString(file.readLine()), inBlockComment);
+        lineOffsets.append(lineOffset);
+        const quint32 nextLineOffset = lineOffset + line.length();
+
+        // Skip compiler directives, including continued macro definitions
+        const QString trimmedLine = line.trimmed();
+        if (inDirective || trimmedLine.startsWith('`'))
+        {
+            inDirective = trimmedLine.endsWith('\\');
+            lineOffset = nextLineOffset;
+            continue;
+        }
+
+        quint32 column = 0;
+        for (const Token token : line.split(separator, Qt::SkipEmptyParts))
+        {
+            // Tokens and separators cover the whole line, so the column is the length of the previous ones
+            tokenLocation.offset = lineOffset + column;
+            column += token.length();
+
+            const TokenClass tokenClass = token.tokenClass();
+            // Skip whitespaces
+            if (tokenClass == TokenClass::Whitespace)
+                continue;
+
+            // Display all tokens and stack length, for debugging
+            if (tracing)
+                Logger::trace(tr("state = 0x%1 | %2; token = %3").arg(static_cast<unsigned int>(state.top()), 4, 16, QChar('0')).arg(state.length()).arg(token));
+
+            // Look up the transition for the current state, then run its action
+            const auto &transition = transitions.at(state.top(), tokenClass);
+            switch (transition.action) {
+
+            case Action::None:
+                break;
+            case Action::Unexpected:
+                goto unexpected;
+
+            case Action::AddModule:
+                // A module is both an entity and its only architecture
+                currentEntity = new Entity;
+                currentEntity->setName(QString("%1.%2").arg(WORKSPACE_NAME).arg(token));
+                currentEntity->setLocation(tokenLocation);
+                _design->addEntity(currentEntity);
+                currentArchitecture = new Architecture;
+                currentArchitecture->setName(ARCHITECTURE_NAME);
+                currentArchitecture->setLocation(tokenLocation);
+                currentEntity->addArchitecture(currentArchitecture);
+                addReference(token, tokenLocation, Reference::Kind::Declaration);
+                break;
+            case Action::EndModule:
+                currentEntity = nullptr;
+                currentArchitecture = nullptr;
+                break;
+
+            /******************************************************************************/
+
+            case Action::SelectPortList:
+                target = Target::Port;
+                direction = "";
+                type = "";
+                name = "";
+                dimensions = "";
+                rangeDepth = 0;
+                break;
+            case Action::SelectPort:
+                target = Target::Port;
+                direction = portDirection(token);
+                type = "";
+                name = "";
+                dimensions = "";
+                rangeDepth = 0;
+                break;
+            case Action::SelectSignal:
+                target = Target::Signal;
+                direction = "";
+                type = token;
+                name = "";
+                dimensions = "";
+                rangeDepth = 0;
+                break;
+            case Action::SetDirection:
+                direction = portDirection(token);
+                type = "";
+                break;
+            case Action::DeclareName:
+                if (rangeDepth > 0)
+                    appendType(token);
+                else
+                {
+                    name = token;
+                    nameLocation = tokenLocation;
+                }
+                break;
+            case Action::AddDeclaration:
+            {
+                // Modules without ports have an empty list
+                if (name.isEmpty() && tokenClass == TokenClass::ClosingParenthesis && rangeDepth == 0)
+                    break;
+                if (name.isEmpty() || rangeDepth != 0)
+                    goto unexpected;
+                const QString fullType = QString("%1 %2").arg(type.isEmpty() ? QString("wire") : type).arg(dimensions).trimmed();
+                const TypeId typeId = _design->internType(fullType.section(' ', 0, 0));
+                if (target == Target::Signal)
+                    currentArchitecture->addSignal(name, fullType, typeId, nameLocation);
+                else if (Port *port = currentEntity->port(name))
+                {
+                    // Complete a port that was only named in the module header
+                    port->direction = direction;
+                    port->type = fullType;
+                    port->typeId = typeId;
+                }
+                else
+                    currentEntity->addPort(name, direction, fullType, typeId, nameLocation);
+                addReference(name, nameLocation, Reference::Kind::Declaration);
+                name = "";
+                dimensions = "";
+                break;
+            }
+            case Action::AppendType:
+                appendType(token);
+                break;
+            case Action::OpenRange:
+                rangeDepth += 1;
+                appendType(token);
+                break;
+            case Action::CloseRange:
+                if (rangeDepth == 0)
+                    goto unexpected;
+                rangeDepth -= 1;
+                appendType(token);
+                break;
+
+            /******************************************************************************/
+
+            case Action::BeginParameter:
+                name = "";
+                type = token;
+                rangeDepth = 0;
+                break;
+            case Action::BeginValue:
+                if (name.isEmpty())
+                    goto unexpected;
+                value = "";
+                parenCount = 0;
+                break;
+            case Action::AppendValue:
+                if (!value.isEmpty() && !value.endsWith('(') && !value.endsWith('[') && !value.endsWith('{'))
+                    value += ' ';
+                value += token;
+                break;
+            case Action::OpenValue:
+                parenCount += 1;
+                value += token;
+                break;
+            case Action::CloseValue:
+                if (parenCount == 0)
+                    goto unexpected;
+                parenCount -= 1;
+                value += token;
+                break;
+            case Action::NextParameter:
+            case Action::CloseParameterList:
+                // Separators and closing parentheses may belong to the value itself
+                if (parenCount != 0)
+                {
+                    parenCount -= (tokenClass == TokenClass::ClosingParenthesis) ? 1 : 0;
+                    value += token;
+                    continue;
+                }
+                [[fallthrough]];
+            case Action::AddParameter:
+                if (parenCount != 0)
+                    goto unexpected;
+                if (currentArchitecture != nullptr)
+                {
+                    // Parameters can be overridden by the instances, local parameters cannot
+                    const QString parameterType = type.isEmpty() ? QString("parameter") : type;
+                    const TypeId typeId = _design->internType(parameterType.section(' ', 0, 0));
+                    if (parameterType.startsWith("localparam"))
+                        currentArchitecture->addConstant(name, parameterType, typeId, value, nameLocation);
+                    else
+                        currentEntity->addGeneric(name, parameterType, typeId, value, nameLocation);
+                }
+                name = "";
+                break;
+
+            /******************************************************************************/
+
+            case Action::BeginInstance:
+                unit = token;
+                unitLocation = tokenLocation;
+                break;
+            case Action::AddInstance:
+                currentArchitecture->addInstance(token, QString("%1.%2").arg(WORKSPACE_NAME).arg(unit), unitLocation);
+                addReference(token, tokenLocation, Reference::Kind::Declaration);
+                addReference(unit, unitLocation, Reference::Kind::Instantiation);
+                break;
+            }
+
+            // Apply the stack operation
+            for (int i = 0; i < transition.popCount; ++i)
+                state.pop();
+            for (int i = 0; i < transition.pushCount; ++i)
+            {
+                if (!state.push(transition.pushed[i]))
+                {
+                    errorString = QString("Maximum nesting depth (%1) exceeded").arg(MAX_NESTING_DEPTH);
+                    goto error;
+                }
+            }
+            continue;
+
+unexpected:
+            errorString = QString("“%1” unexpected (state = 0x%2)").arg(token).arg(static_cast<unsigned int>(state.top()), 4, 16, QChar('0'));
+error:
+            Logger::error(tr("%1:%2:%3 %4").arg(filePath).arg(lineNumber).arg(tokenLocation.offset - lineOffset + 1).arg(errorString));
+            return false;
+        }
+        lineOffset = nextLineOffset;
+    }
+    _design->setLineOffsets(fileId, lineOffsets);
+
+    if (state.top() != State::Base)
+    {
+        Logger::error(tr("%1 Unexpected end of file (state = 0x%2)").arg(filePath).arg(static_cast<unsigned int>(state.top()), 4, 16, QChar('0')));
+        return false;
+    }
+
+    return true;
+}
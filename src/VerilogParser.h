@@ -0,0 +1,45 @@
+/* Lambila | VerilogParser.h
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+#ifndef VERILOGPARSER_H
+#define VERILOGPARSER_H
+
+/******************************************************************************/
+
+#include "Design.h"
+
+#include <QFileInfo>
+
+/******************************************************************************/
+
+class VerilogParser : public QObject
+{
+    Q_OBJECT
+
+protected:
+    enum class State;
+    enum class Target;
+    enum class TokenClass;
+    enum class Action;
+    class TransitionTable;
+    class Token;
+
+    QFileInfo _sourceFile;
+    Design *_design;
+    // Parsed instead of the file when it is not null
+    QByteArray _contents;
+
+public:
+    VerilogParser(const QFileInfo &sourceFile, Design *design, QObject *parent = nullptr);
+
+    void setContents(const QByteArray &contents);
+    bool parse();
+};
+
+/******************************************************************************/
+
+#endif // VERILOGPARSER_H
@@ -5,16 +5,34 @@
 
 /******************************************************************************/
 
+#include "InlineStack.h"
+#include "LibrarySummary.h"
 #include "Logger.h"
+#include "NetlistSpill.h"
+#include "TokenScanner.h"
+#include "TransitionTable.h"
 #include "VhdlParser.h"
+#include "_VhdlGrammar.h"
 
 #include <QApplication>
+#include <QBuffer>
+#include <QMutex>
 #include <QRegularExpression>
-#include <QStack>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
 
 /******************************************************************************/
 
 static const char WORKSPACE_NAME[] = "work";
+static const int MAX_NESTING_DEPTH = 256;
+// Size of the chunks read from a file
+static const int CHUNK_SIZE = 64 * 1024;
+// Lines longer than this are parsed in pieces
+static const int MAX_LINE_LENGTH = 1024 * 1024;
+// Files from this size on are split at their design units, which are parsed in parallel
+static const qint64 PARALLEL_FILE_SIZE = 1024 * 1024;
 
 /******************************************************************************/
 
@@ -22,31 +40,77 @@ VhdlParser::VhdlParser(const QFileInfo &sourceFile, Design *design, QObject *par
 {
     _sourceFile = sourceFile;
     _design = design;
+    _netlist = false;
+    _session = nullptr;
+}
+
+VhdlParser::~VhdlParser()
+{
+    delete _session;
+}
+
+void VhdlParser::setContents(const QByteArray &contents)
+{
+    _contents = contents;
+}
+
+void VhdlParser::setNetlistMode(bool enabled, const QString &spillPath)
+{
+    _netlist = enabled;
+    _spillPath = spillPath;
 }
 
 /******************************************************************************/
 
 enum class VhdlParser::State {
-    Base = 0x1000,
+    Base,
     Library,
     Use,
 
-    Entity = 0x2000,
+    Entity,
     EntityBody,
     EntityGeneric,
+    EntityGenericType,
+    EntityGenericDefault,
     EntityPort,
     EntityPortDirection,
     EntityPortType,
     EntityPortAssignment,
 
-    Architecture = 0x3000,
+    Architecture,
     ArchitectureOf,
     ArchitectureHeader,
     ArchitectureSignal,
     ArchitectureSignalType,
     ArchitectureSignalAssignment,
+    ArchitectureBody,
+    ProcessDeclarations,
+    Condition,
+    AssociationList,
+    ProcessSensitivity,
+    SensitivityList,
+
+    TypeDeclaration,
+    TypeIs,
+    TypeDefinition,
+    TypeEnumeration,
+    TypeRange,
+    TypeUnits,
+    TypeArrayIndex,
+    TypeArrayElement,
+    TypeRecord,
+    TypeRecordField,
+    TypeDesignated,
+    SubtypeDeclaration,
+    SubtypeIndication,
+
+    Package,
+    PackageHeader,
+    PackageSubprogram,
+    Component,
+    ComponentBody,
 
-    ExpectIs = 0xA000,
+    ExpectIs,
     ExpectOf,
     ExpectBegin,
     ExpectEnd,
@@ -56,11 +120,16 @@ enum class VhdlParser::State {
     ExpectColon,
     ExpectEqual,
 
-    SkipToBegin = 0xB000,
+    SkipToBegin,
     SkipToEnd,
     SkipToStringEnd,
     SkipToClosingParenthesis,
-    SkipToSemicolon
+    SkipToSemicolon,
+    SkipDeclaration,
+    SkipSubprogram,
+    SkipConfiguration,
+
+    Count
 };
 
 enum class VhdlParser::Target {
@@ -70,511 +139,2020 @@ enum class VhdlParser::Target {
 
 /******************************************************************************/
 
+enum class VhdlParser::TokenClass {
+    // Handled before the transition table lookup
+    Whitespace,
+    Comment,
+
+    // Generic tokens
+    Other,
+    Identifier,
+    SelectedName,
+    Quote,
+
+    // Delimiters
+    OpeningParenthesis,
+    ClosingParenthesis,
+    Colon,
+    Semicolon,
+    Equal,
+
+    // Reserved words, as listed in the grammar
+#define KEYWORD(name, word) name,
+    VHDL_KEYWORDS(KEYWORD)
+#undef KEYWORD
+
+    Count
+};
+
+/******************************************************************************/
+
 class VhdlParser::Token : public QString {
+protected:
+    struct Keyword {
+        const char *word;
+        TokenClass tokenClass;
+    };
+
+    // Reserved words, sorted by the grammar generator
+    static constexpr Keyword KEYWORDS[] = {
+#define KEYWORD(name, word) { word, TokenClass::name },
+        VHDL_KEYWORDS(KEYWORD)
+#undef KEYWORD
+    };
+
 public:
     Token(const QString &str) : QString(str) { }
 
-    bool is(const QString &str) const
+    TokenClass tokenClass() const
     {
-        return compare(str, Qt::CaseInsensitive) == 0;
+        const QChar first = at(0);
+        if (first.isSpace())
+            return TokenClass::Whitespace;
+        if (length() == 1)
+        {
+            switch (first.unicode())
+            {
+            case '(': return TokenClass::OpeningParenthesis;
+            case ')': return TokenClass::ClosingParenthesis;
+            case ':': return TokenClass::Colon;
+            case ';': return TokenClass::Semicolon;
+            case '=': return TokenClass::Equal;
+            default: break;
+            }
+        }
+        if (startsWith("--"))
+            return TokenClass::Comment;
+        if ((count('"') & 1) != 0)
+            return TokenClass::Quote;
+
+        // Find the end of the leading word
+        int wordLength = 0;
+        while (wordLength < length() && isWordCharacter(at(wordLength)))
+            wordLength += 1;
+        if (wordLength == 0)
+            return TokenClass::Other;
+        if (wordLength < length())
+            return at(wordLength) == '.' ? TokenClass::SelectedName : TokenClass::Other;
+
+        // Look for a reserved word using a binary search
+        int low = 0;
+        int high = sizeof(KEYWORDS) / sizeof(KEYWORDS[0]) - 1;
+        while (low <= high)
+        {
+            const int middle = (low + high) / 2;
+            const int c = compare(QLatin1String(KEYWORDS[middle].word), Qt::CaseInsensitive);
+            if (c == 0)
+                return KEYWORDS[middle].tokenClass;
+            if (c < 0)
+                high = middle - 1;
+            else
+                low = middle + 1;
+        }
+        return TokenClass::Identifier;
     }
-    bool is(const char *str) const
+
+protected:
+    static bool isWordCharacter(const QChar c)
     {
-        return compare(str, Qt::CaseInsensitive) == 0;
+        return c.isLetterOrNumber() || c == '_';
     }
-    bool is(const char c) const
+};
+
+/******************************************************************************/
+
+// Semantic actions, executed before the stack operation of a transition
+enum class VhdlParser::Action {
+    None,
+    Unexpected,
+
+    ResetContext,
+    SkipUnit,
+    AddUse,
+
+    AddEntity,
+    AddGenericNames,
+    BeginGenericType,
+    BeginGenericDefault,
+    AddGeneric,
+    CloseGenericType,
+    CloseGenericDefault,
+    BeginPort,
+    SetPortDirection,
+    AddPort,
+    ClosePortList,
+
+    AddPackage,
+    SelectPackageBody,
+    EndPackage,
+    BeginSubprogram,
+    AddSubprogram,
+    AddComponent,
+    EndComponent,
+
+    SetArchitectureName,
+    AddArchitecture,
+    SelectSignal,
+    SelectConstant,
+    BeginObject,
+    BeginStatement,
+    EndBlock,
+    BeginCondition,
+    BeginScheme,
+    EndCondition,
+    AppendExpression,
+    AppendExpressionReferences,
+    AddGenerate,
+    BeginInstance,
+    MarkInstance,
+    BeginAssociations,
+    CloseAssociationList,
+    BeginProcess,
+    AddSensitivity,
+    AddLabel,
+    AssignVariable,
+    AddReferences,
+    DeclareReference,
+    DeclareObject,
+    DeclareSignal,
+    DeclareConstant,
+
+    BeginType,
+    BeginSubtype,
+    BeginEnumerationType,
+    BeginScalarType,
+    BeginPhysicalType,
+    BeginArrayType,
+    BeginRecordType,
+    BeginAccessType,
+    BeginFileType,
+    AddLiteral,
+    AddFieldNames,
+    BeginFieldType,
+    AddFields,
+    CloseArrayIndex,
+    DeclareIncompleteType,
+    DeclareType,
+
+    AppendType,
+    OpenTypeParenthesis,
+    CloseTypeParenthesis,
+    AppendConstraint,
+    OpenConstraintParenthesis,
+    CloseConstraintParenthesis,
+    AppendValue,
+    OpenValueParenthesis,
+    CloseValueParenthesis,
+    OpenParenthesis,
+    CloseParenthesis
+};
+
+// (state, token class) → transition table, fully computed at compile time
+class VhdlParser::TransitionTable : public ::TransitionTable<State, TokenClass, Action> {
+protected:
+    // Reserved words that can start a declaration, according to the grammar
+    constexpr void onBlockDeclarativeItem(State state, const Transition &transition)
+    {
+#define ON_KEYWORD(keyword) on(state, TokenClass::keyword, transition);
+        VHDL_FIRST_BLOCK_DECLARATIVE_ITEM(ON_KEYWORD)
+#undef ON_KEYWORD
+    }
+    constexpr void onEntityDeclarativeItem(State state, const Transition &transition)
+    {
+#define ON_KEYWORD(keyword) on(state, TokenClass::keyword, transition);
+        VHDL_FIRST_ENTITY_DECLARATIVE_ITEM(ON_KEYWORD)
+#undef ON_KEYWORD
+    }
+    constexpr void onPackageDeclarativeItem(State state, const Transition &transition)
     {
-        return compare(c, Qt::CaseInsensitive) == 0;
+#define ON_KEYWORD(keyword) on(state, TokenClass::keyword, transition);
+        VHDL_FIRST_PACKAGE_DECLARATIVE_ITEM(ON_KEYWORD)
+        VHDL_FIRST_PACKAGE_BODY_DECLARATIVE_ITEM(ON_KEYWORD)
+#undef ON_KEYWORD
     }
-    bool matches(const QString &re) const
+    constexpr void onSubprogram(State state)
     {
-        return contains(QRegularExpression(QString("^%1$").arg(re)));
+        on(state, TokenClass::Function,  push(Action::None, State::SkipSubprogram));
+        on(state, TokenClass::Procedure, push(Action::None, State::SkipSubprogram));
+        on(state, TokenClass::Pure,      push(Action::None, State::SkipSubprogram));
+        on(state, TokenClass::Impure,    push(Action::None, State::SkipSubprogram));
     }
 
-    bool isIdentifier() const
+public:
+    constexpr TransitionTable()
     {
-        return matches("\\w+");
+        using S = State;
+        using T = TokenClass;
+        using A = Action;
+
+        otherwise(S::Base, stay(A::Unexpected));
+        on(S::Base, T::Library,      push(A::None, S::Library));
+        on(S::Base, T::Use,          push(A::None, S::Use));
+        on(S::Base, T::Entity,       push(A::None, S::Entity));
+        on(S::Base, T::Architecture, push(A::None, S::Architecture));
+        on(S::Base, T::Package,      push(A::None, S::Package, S::PackageHeader));
+        on(S::Base, T::Configuration, push(A::SkipUnit, S::SkipConfiguration));
+
+        // We probably don't really need to track libraries
+        otherwise(S::Library, replace(A::ResetContext, S::SkipToSemicolon));
+        on(S::Library, T::Semicolon, stay(A::Unexpected));
+
+        // We accept pretty much anything for now
+        otherwise(S::Use, stay(A::Unexpected));
+        on(S::Use, T::SelectedName, replace(A::AddUse, S::ExpectSemicolon));
+
+        /******************************************************************************/
+
+        otherwise(S::Entity, stay(A::Unexpected));
+        on(S::Entity, T::Identifier, replace(A::AddEntity, S::EntityBody, S::ExpectIs));
+
+        otherwise(S::EntityBody, stay(A::Unexpected));
+        onEntityDeclarativeItem(S::EntityBody, push(A::None, S::SkipDeclaration));
+        onSubprogram(S::EntityBody);
+        on(S::EntityBody, T::Generic,   push(A::None, S::ExpectSemicolon, S::EntityGeneric, S::ExpectOpeningParenthesis));
+        on(S::EntityBody, T::Port,      push(A::None, S::ExpectSemicolon, S::EntityPort, S::ExpectOpeningParenthesis));
+        on(S::EntityBody, T::Attribute, push(A::None, S::SkipToSemicolon));
+        on(S::EntityBody, T::Type,      push(A::None, S::TypeDeclaration));
+        on(S::EntityBody, T::Subtype,   push(A::None, S::SubtypeDeclaration));
+        on(S::EntityBody, T::Begin,     replace(A::None, S::SkipToEnd));
+        on(S::EntityBody, T::End,       replace(A::None, S::SkipToSemicolon));
+
+        // Several generics can be declared at once, the names are separated by commas
+        otherwise(S::EntityGeneric, stay(A::Unexpected));
+        on(S::EntityGeneric, T::Identifier, stay(A::AddGenericNames));
+        on(S::EntityGeneric, T::Other,      stay(A::AddGenericNames));
+        on(S::EntityGeneric, T::Constant,   stay());
+        on(S::EntityGeneric, T::Colon,      push(A::BeginGenericType, S::EntityGenericType));
+
+        otherwise(S::EntityGenericType, stay(A::AppendType));
+        on(S::EntityGenericType, T::Colon,              replace(A::BeginGenericDefault, S::EntityGenericDefault, S::ExpectEqual));
+        on(S::EntityGenericType, T::Semicolon,          pop(1, A::AddGeneric));
+        on(S::EntityGenericType, T::OpeningParenthesis, stay(A::OpenTypeParenthesis));
+        on(S::EntityGenericType, T::ClosingParenthesis, pop(2, A::CloseGenericType));
+
+        // Default values are kept, so that generics can be evaluated when they are not mapped
+        otherwise(S::EntityGenericDefault, stay(A::AppendValue));
+        on(S::EntityGenericDefault, T::Semicolon,          pop(1, A::AddGeneric));
+        on(S::EntityGenericDefault, T::OpeningParenthesis, stay(A::OpenValueParenthesis));
+        on(S::EntityGenericDefault, T::ClosingParenthesis, pop(2, A::CloseGenericDefault));
+
+        otherwise(S::EntityPort, stay(A::Unexpected));
+        on(S::EntityPort, T::Identifier, push(A::BeginPort, S::EntityPortDirection, S::ExpectColon));
+
+        otherwise(S::EntityPortDirection, stay(A::Unexpected));
+        on(S::EntityPortDirection, T::In,         replace(A::SetPortDirection, S::EntityPortType));
+        on(S::EntityPortDirection, T::Out,        replace(A::SetPortDirection, S::EntityPortType));
+        on(S::EntityPortDirection, T::Inout,      replace(A::SetPortDirection, S::EntityPortType));
+        on(S::EntityPortDirection, T::Buffer,     replace(A::SetPortDirection, S::EntityPortType));
+        on(S::EntityPortDirection, T::Linkage,    replace(A::SetPortDirection, S::EntityPortType));
+        on(S::EntityPortDirection, T::Identifier, replace(A::SetPortDirection, S::EntityPortType));
+
+        otherwise(S::EntityPortType, stay(A::AppendType));
+        on(S::EntityPortType, T::Colon,              replace(A::AddPort, S::EntityPortAssignment, S::ExpectEqual));
+        on(S::EntityPortType, T::Semicolon,          pop(1, A::AddPort));
+        on(S::EntityPortType, T::OpeningParenthesis, stay(A::OpenTypeParenthesis));
+        on(S::EntityPortType, T::ClosingParenthesis, pop(2, A::ClosePortList));
+
+        // Default assignments are ignored
+        otherwise(S::EntityPortAssignment, stay());
+        on(S::EntityPortAssignment, T::Semicolon,          pop());
+        on(S::EntityPortAssignment, T::OpeningParenthesis, stay(A::OpenParenthesis));
+        on(S::EntityPortAssignment, T::ClosingParenthesis, pop(2, A::CloseParenthesis));
+
+        /******************************************************************************/
+
+        otherwise(S::Architecture, stay(A::Unexpected));
+        on(S::Architecture, T::Identifier, replace(A::SetArchitectureName, S::ArchitectureOf, S::ExpectOf));
+
+        otherwise(S::ArchitectureOf, stay(A::Unexpected));
+        on(S::ArchitectureOf, T::Identifier, replace(A::AddArchitecture, S::ArchitectureHeader, S::ExpectIs));
+
+        // Declarations that are not modelled yet are skipped
+        otherwise(S::ArchitectureHeader, stay(A::Unexpected));
+        onBlockDeclarativeItem(S::ArchitectureHeader, push(A::None, S::SkipDeclaration));
+        onSubprogram(S::ArchitectureHeader);
+        on(S::ArchitectureHeader, T::Signal,    push(A::SelectSignal, S::ArchitectureSignal));
+        on(S::ArchitectureHeader, T::Constant,  push(A::SelectConstant, S::ArchitectureSignal));
+        on(S::ArchitectureHeader, T::Type,      push(A::None, S::TypeDeclaration));
+        on(S::ArchitectureHeader, T::Subtype,   push(A::None, S::SubtypeDeclaration));
+        on(S::ArchitectureHeader, T::Component, push(A::None, S::SkipToEnd));
+        on(S::ArchitectureHeader, T::Begin,     replace(A::BeginStatement, S::ArchitectureBody));
+
+        otherwise(S::ArchitectureSignal, stay(A::Unexpected));
+        on(S::ArchitectureSignal, T::Identifier, replace(A::BeginObject, S::ArchitectureSignalType, S::ExpectColon));
+
+        otherwise(S::ArchitectureSignalType, stay(A::AppendType));
+        on(S::ArchitectureSignalType, T::Colon,              replace(A::DeclareObject, S::ArchitectureSignalAssignment, S::ExpectEqual));
+        on(S::ArchitectureSignalType, T::Semicolon,          pop(1, A::DeclareSignal));
+        on(S::ArchitectureSignalType, T::OpeningParenthesis, stay(A::OpenTypeParenthesis));
+        on(S::ArchitectureSignalType, T::ClosingParenthesis, stay(A::CloseTypeParenthesis));
+
+        // Default assignments are ignored
+        otherwise(S::ArchitectureSignalAssignment, stay(A::AppendValue));
+        on(S::ArchitectureSignalAssignment, T::Semicolon,          pop(1, A::DeclareConstant));
+        on(S::ArchitectureSignalAssignment, T::OpeningParenthesis, stay(A::OpenValueParenthesis));
+        on(S::ArchitectureSignalAssignment, T::ClosingParenthesis, stay(A::CloseValueParenthesis));
+
+        // Statements are not modelled yet, only the references they contain are recorded
+        otherwise(S::ArchitectureBody, stay());
+        on(S::ArchitectureBody, T::Identifier,   stay(A::AddReferences));
+        on(S::ArchitectureBody, T::SelectedName, stay(A::AddReferences));
+        on(S::ArchitectureBody, T::Other,        stay(A::AddReferences));
+        on(S::ArchitectureBody, T::Quote,        push(A::None, S::SkipToStringEnd));
+        on(S::ArchitectureBody, T::Colon,        stay(A::AddLabel));
+        on(S::ArchitectureBody, T::Equal,        stay(A::AssignVariable));
+        on(S::ArchitectureBody, T::Semicolon,    stay(A::BeginStatement));
+        on(S::ArchitectureBody, T::Begin,        stay(A::BeginStatement));
+        on(S::ArchitectureBody, T::Else,         stay(A::BeginStatement));
+        on(S::ArchitectureBody, T::Select,       stay(A::BeginStatement));
+        on(S::ArchitectureBody, T::If,           push(A::BeginScheme, S::Condition));
+        on(S::ArchitectureBody, T::While,        stay(A::BeginCondition));
+        on(S::ArchitectureBody, T::For,          push(A::BeginScheme, S::Condition));
+        on(S::ArchitectureBody, T::When,         stay(A::BeginCondition));
+        on(S::ArchitectureBody, T::With,         stay(A::BeginCondition));
+        on(S::ArchitectureBody, T::Wait,         push(A::BeginScheme, S::Condition));
+        on(S::ArchitectureBody, T::Assert,       stay(A::BeginCondition));
+        on(S::ArchitectureBody, T::Report,       stay(A::BeginCondition));
+        on(S::ArchitectureBody, T::Entity,       stay(A::BeginInstance));
+        on(S::ArchitectureBody, T::Component,    stay(A::BeginInstance));
+        on(S::ArchitectureBody, T::Generic,      stay(A::MarkInstance));
+        on(S::ArchitectureBody, T::Port,         stay(A::MarkInstance));
+        on(S::ArchitectureBody, T::Map,          push(A::BeginAssociations, S::AssociationList, S::ExpectOpeningParenthesis));
+        // Same nesting as SkipToEnd
+        on(S::ArchitectureBody, T::End,          replace(A::EndBlock, S::SkipToSemicolon));
+        on(S::ArchitectureBody, T::Elsif,        replace(A::BeginScheme, S::Condition));
+        on(S::ArchitectureBody, T::Then,         push(A::BeginStatement, S::ArchitectureBody));
+        on(S::ArchitectureBody, T::Loop,         push(A::BeginStatement, S::ArchitectureBody));
+        on(S::ArchitectureBody, T::Generate,     push(A::BeginStatement, S::ArchitectureBody));
+        on(S::ArchitectureBody, T::Case,         push(A::BeginCondition, S::ArchitectureBody));
+        on(S::ArchitectureBody, T::Process,      push(A::BeginProcess, S::ArchitectureBody, S::ProcessDeclarations, S::ProcessSensitivity));
+        on(S::ArchitectureBody, T::Block,        push(A::BeginStatement, S::ArchitectureBody, S::ProcessDeclarations));
+
+        // Conditions of if and wait statements, loop schemes, and schemes of generate statements, which look like
+        // if statements and loops until the “generate” reserved word. “for” also appears in wait statements.
+        otherwise(S::Condition, stay(A::AppendExpression));
+        on(S::Condition, T::Identifier,   stay(A::AppendExpressionReferences));
+        on(S::Condition, T::SelectedName, stay(A::AppendExpressionReferences));
+        on(S::Condition, T::Other,        stay(A::AppendExpressionReferences));
+        on(S::Condition, T::Quote,        push(A::None, S::SkipToStringEnd));
+        on(S::Condition, T::Generate,     replace(A::AddGenerate, S::ArchitectureBody));
+        on(S::Condition, T::Then,         replace(A::EndCondition, S::ArchitectureBody));
+        on(S::Condition, T::Loop,         replace(A::BeginStatement, S::ArchitectureBody));
+        on(S::Condition, T::Semicolon,    pop(1, A::EndCondition));
+
+        // Generic maps and port maps are split into associations once the closing parenthesis is reached
+        otherwise(S::AssociationList, stay(A::AppendExpression));
+        on(S::AssociationList, T::Identifier,         stay(A::AppendExpressionReferences));
+        on(S::AssociationList, T::SelectedName,       stay(A::AppendExpressionReferences));
+        on(S::AssociationList, T::Other,              stay(A::AppendExpressionReferences));
+        on(S::AssociationList, T::Quote,              push(A::None, S::SkipToStringEnd));
+        on(S::AssociationList, T::OpeningParenthesis, stay(A::OpenValueParenthesis));
+        on(S::AssociationList, T::ClosingParenthesis, pop(1, A::CloseAssociationList));
+
+        // Only reserved words can follow “process” when there is no sensitivity list
+        otherwise(S::ProcessSensitivity, pop());
+        on(S::ProcessSensitivity, T::OpeningParenthesis, replace(A::None, S::SensitivityList));
+        on(S::ProcessSensitivity, T::Begin,              pop(2, A::BeginStatement));
+
+        otherwise(S::SensitivityList, stay());
+        on(S::SensitivityList, T::Identifier,         stay(A::AddSensitivity));
+        on(S::SensitivityList, T::SelectedName,       stay(A::AddSensitivity));
+        on(S::SensitivityList, T::Other,              stay(A::AddSensitivity));
+        on(S::SensitivityList, T::All,                stay(A::AddSensitivity));
+        on(S::SensitivityList, T::OpeningParenthesis, push(A::None, S::SkipToClosingParenthesis));
+        on(S::SensitivityList, T::ClosingParenthesis, pop());
+
+        otherwise(S::ProcessDeclarations, stay());
+        onSubprogram(S::ProcessDeclarations);
+        on(S::ProcessDeclarations, T::Identifier,   stay(A::AddReferences));
+        on(S::ProcessDeclarations, T::SelectedName, stay(A::AddReferences));
+        on(S::ProcessDeclarations, T::Other,        stay(A::AddReferences));
+        on(S::ProcessDeclarations, T::Quote,        push(A::None, S::SkipToStringEnd));
+        on(S::ProcessDeclarations, T::Colon,        stay(A::DeclareReference));
+        on(S::ProcessDeclarations, T::Semicolon,    stay(A::BeginStatement));
+        on(S::ProcessDeclarations, T::Begin,        pop(1, A::BeginStatement));
+
+        /******************************************************************************/
+
+        otherwise(S::TypeDeclaration, stay(A::Unexpected));
+        on(S::TypeDeclaration, T::Identifier, replace(A::BeginType, S::TypeIs));
+
+        otherwise(S::TypeIs, stay(A::Unexpected));
+        on(S::TypeIs, T::Is,        replace(A::None, S::TypeDefinition));
+        on(S::TypeIs, T::Semicolon, pop(1, A::DeclareIncompleteType));
+
+        // Type definitions that are not part of VHDL-93 are skipped
+        otherwise(S::TypeDefinition, replace(A::None, S::SkipDeclaration));
+        on(S::TypeDefinition, T::OpeningParenthesis, replace(A::BeginEnumerationType, S::ExpectSemicolon, S::TypeEnumeration));
+        on(S::TypeDefinition, T::Range,              replace(A::BeginScalarType, S::TypeRange));
+        on(S::TypeDefinition, T::Array,              replace(A::BeginArrayType, S::TypeArrayElement, S::TypeArrayIndex, S::ExpectOpeningParenthesis));
+        on(S::TypeDefinition, T::Record,             replace(A::BeginRecordType, S::TypeRecord));
+        on(S::TypeDefinition, T::Access,             replace(A::BeginAccessType, S::TypeDesignated));
+        on(S::TypeDefinition, T::File,               replace(A::BeginFileType, S::TypeDesignated, S::ExpectOf));
+
+        otherwise(S::TypeEnumeration, stay(A::AddLiteral));
+        on(S::TypeEnumeration, T::ClosingParenthesis, pop());
+
+        otherwise(S::TypeRange, stay(A::AppendConstraint));
+        on(S::TypeRange, T::Semicolon,          pop(1, A::DeclareType));
+        on(S::TypeRange, T::Units,              replace(A::BeginPhysicalType, S::TypeUnits));
+        on(S::TypeRange, T::OpeningParenthesis, stay(A::OpenConstraintParenthesis));
+        on(S::TypeRange, T::ClosingParenthesis, stay(A::CloseConstraintParenthesis));
+
+        // Only the unit names are kept
+        otherwise(S::TypeUnits, stay(A::Unexpected));
+        on(S::TypeUnits, T::Identifier, push(A::AddLiteral, S::SkipToSemicolon));
+        on(S::TypeUnits, T::End,        replace(A::DeclareType, S::SkipToSemicolon));
+
+        otherwise(S::TypeArrayIndex, stay(A::AppendConstraint));
+        on(S::TypeArrayIndex, T::OpeningParenthesis, stay(A::OpenConstraintParenthesis));
+        on(S::TypeArrayIndex, T::ClosingParenthesis, replace(A::CloseArrayIndex, S::ExpectOf));
+
+        otherwise(S::TypeArrayElement, stay(A::AppendType));
+        on(S::TypeArrayElement, T::Semicolon,          pop(1, A::DeclareType));
+        on(S::TypeArrayElement, T::OpeningParenthesis, stay(A::OpenTypeParenthesis));
+        on(S::TypeArrayElement, T::ClosingParenthesis, stay(A::CloseTypeParenthesis));
+
+        otherwise(S::TypeRecord, stay(A::AddFieldNames));
+        on(S::TypeRecord, T::Colon, push(A::BeginFieldType, S::TypeRecordField));
+        on(S::TypeRecord, T::End,   replace(A::DeclareType, S::SkipToSemicolon));
+
+        otherwise(S::TypeRecordField, stay(A::AppendType));
+        on(S::TypeRecordField, T::Semicolon,          pop(1, A::AddFields));
+        on(S::TypeRecordField, T::OpeningParenthesis, stay(A::OpenTypeParenthesis));
+        on(S::TypeRecordField, T::ClosingParenthesis, stay(A::CloseTypeParenthesis));
+
+        // Designated type of access types and file types
+        otherwise(S::TypeDesignated, stay(A::AppendType));
+        on(S::TypeDesignated, T::Semicolon, pop(1, A::DeclareType));
+
+        otherwise(S::SubtypeDeclaration, stay(A::Unexpected));
+        on(S::SubtypeDeclaration, T::Identifier, replace(A::BeginSubtype, S::SubtypeIndication, S::ExpectIs));
+
+        otherwise(S::SubtypeIndication, stay(A::AppendType));
+        on(S::SubtypeIndication, T::Semicolon,          pop(1, A::DeclareType));
+        on(S::SubtypeIndication, T::OpeningParenthesis, stay(A::OpenTypeParenthesis));
+        on(S::SubtypeIndication, T::ClosingParenthesis, stay(A::CloseTypeParenthesis));
+
+        /******************************************************************************/
+
+        // Package declarations and package bodies fill the same package
+        otherwise(S::PackageHeader, stay(A::Unexpected));
+        on(S::PackageHeader, T::Body,       stay(A::SelectPackageBody));
+        on(S::PackageHeader, T::Identifier, replace(A::AddPackage, S::ExpectIs));
+
+        otherwise(S::Package, stay(A::Unexpected));
+        onPackageDeclarativeItem(S::Package, push(A::None, S::SkipDeclaration));
+        on(S::Package, T::Constant,  push(A::SelectConstant, S::ArchitectureSignal));
+        on(S::Package, T::Type,      push(A::None, S::TypeDeclaration));
+        on(S::Package, T::Subtype,   push(A::None, S::SubtypeDeclaration));
+        on(S::Package, T::Component, push(A::None, S::Component));
+        on(S::Package, T::Function,  push(A::BeginSubprogram, S::PackageSubprogram));
+        on(S::Package, T::Procedure, push(A::BeginSubprogram, S::PackageSubprogram));
+        on(S::Package, T::Pure,      push(A::BeginSubprogram, S::PackageSubprogram));
+        on(S::Package, T::Impure,    push(A::BeginSubprogram, S::PackageSubprogram));
+        on(S::Package, T::End,       replace(A::EndPackage, S::SkipToSemicolon));
+
+        // Only the specification is kept, subprogram bodies are skipped
+        otherwise(S::PackageSubprogram, stay(A::AppendValue));
+        on(S::PackageSubprogram, T::Semicolon,          pop(1, A::AddSubprogram));
+        on(S::PackageSubprogram, T::OpeningParenthesis, stay(A::OpenValueParenthesis));
+        on(S::PackageSubprogram, T::ClosingParenthesis, stay(A::CloseValueParenthesis));
+        on(S::PackageSubprogram, T::Is,                 replace(A::None, S::SkipToEnd, S::SkipToBegin));
+
+        otherwise(S::Component, stay(A::Unexpected));
+        on(S::Component, T::Identifier, replace(A::AddComponent, S::ComponentBody));
+
+        // Component ports are parsed like entity ports
+        otherwise(S::ComponentBody, stay(A::Unexpected));
+        on(S::ComponentBody, T::Is,      stay());
+        on(S::ComponentBody, T::Generic, push(A::None, S::ExpectSemicolon, S::EntityGeneric, S::ExpectOpeningParenthesis));
+        on(S::ComponentBody, T::Port,    push(A::None, S::ExpectSemicolon, S::EntityPort, S::ExpectOpeningParenthesis));
+        on(S::ComponentBody, T::End,     replace(A::EndComponent, S::SkipToSemicolon));
+
+        /******************************************************************************/
+
+        expect(S::ExpectIs,                 T::Is);
+        expect(S::ExpectOf,                 T::Of);
+        expect(S::ExpectBegin,              T::Begin);
+        expect(S::ExpectEnd,                T::End);
+        expect(S::ExpectOpeningParenthesis, T::OpeningParenthesis);
+        expect(S::ExpectClosingParenthesis, T::ClosingParenthesis);
+        expect(S::ExpectSemicolon,          T::Semicolon);
+        expect(S::ExpectColon,              T::Colon);
+        expect(S::ExpectEqual,              T::Equal);
+
+        /******************************************************************************/
+
+        // Subprogram bodies declared before “begin” have their own, specifications end with a semicolon
+        otherwise(S::SkipToBegin, stay());
+        onSubprogram(S::SkipToBegin);
+        on(S::SkipToBegin, T::Begin, pop());
+
+        // Every construct closed by “end” is opened by exactly one of these reserved words
+        otherwise(S::SkipToEnd, stay());
+        onSubprogram(S::SkipToEnd);
+        on(S::SkipToEnd, T::End,      replace(A::None, S::SkipToSemicolon));
+        on(S::SkipToEnd, T::Elsif,    pop());
+        on(S::SkipToEnd, T::Then,     push(A::None, S::SkipToEnd));
+        on(S::SkipToEnd, T::Case,     push(A::None, S::SkipToEnd));
+        on(S::SkipToEnd, T::Loop,     push(A::None, S::SkipToEnd));
+        on(S::SkipToEnd, T::Generate, push(A::None, S::SkipToEnd));
+        on(S::SkipToEnd, T::Record,   push(A::None, S::SkipToEnd));
+        on(S::SkipToEnd, T::Units,    push(A::None, S::SkipToEnd));
+        on(S::SkipToEnd, T::Process,  push(A::None, S::SkipToEnd, S::SkipToBegin));
+        on(S::SkipToEnd, T::Block,    push(A::None, S::SkipToEnd, S::SkipToBegin));
+        on(S::SkipToEnd, T::Quote,    push(A::None, S::SkipToStringEnd));
+
+        otherwise(S::SkipToStringEnd, stay());
+        on(S::SkipToStringEnd, T::Quote, pop());
+
+        otherwise(S::SkipToClosingParenthesis, stay());
+        on(S::SkipToClosingParenthesis, T::ClosingParenthesis, pop());
+        on(S::SkipToClosingParenthesis, T::OpeningParenthesis, push(A::None, S::SkipToClosingParenthesis));
+
+        otherwise(S::SkipToSemicolon, stay());
+        on(S::SkipToSemicolon, T::Semicolon, pop());
+
+        otherwise(S::SkipDeclaration, stay());
+        on(S::SkipDeclaration, T::Semicolon,          pop());
+        on(S::SkipDeclaration, T::OpeningParenthesis, push(A::None, S::SkipToClosingParenthesis));
+        on(S::SkipDeclaration, T::Record,             replace(A::None, S::SkipToEnd));
+        on(S::SkipDeclaration, T::Units,              replace(A::None, S::SkipToEnd));
+        on(S::SkipDeclaration, T::Quote,              push(A::None, S::SkipToStringEnd));
+
+        // A subprogram specification ends with a semicolon, unless a body follows
+        otherwise(S::SkipSubprogram, stay());
+        on(S::SkipSubprogram, T::Semicolon,          pop());
+        on(S::SkipSubprogram, T::OpeningParenthesis, push(A::None, S::SkipToClosingParenthesis));
+        on(S::SkipSubprogram, T::Is,                 replace(A::None, S::SkipToEnd, S::SkipToBegin));
+
+        // Block and component configurations are all closed by “end for”
+        otherwise(S::SkipConfiguration, stay());
+        on(S::SkipConfiguration, T::End,   replace(A::None, S::SkipToSemicolon));
+        on(S::SkipConfiguration, T::For,   push(A::None, S::SkipConfiguration));
+        on(S::SkipConfiguration, T::Quote, push(A::None, S::SkipToStringEnd));
     }
+};
+
+/******************************************************************************/
+
+// Split a subtype indication into its type mark and its constraint
+static QString typeMark(const QString &subtypeIndication, QString *constraint = nullptr)
+{
+    static const QRegularExpression constraintStart("\\(|\\brange\\b", QRegularExpression::CaseInsensitiveOption);
+    const int end = subtypeIndication.indexOf(constraintStart);
+    if (constraint != nullptr)
+        *constraint = (end < 0) ? QString() : subtypeIndication.mid(end);
 
-    bool isCommentStart() const
+    // A resolution function name may come before the type mark
+    return subtypeIndication.left(end).trimmed().section(' ', -1);
+}
+
+// Find the identifiers in a token, as (offset, length) pairs, skipping literals, attribute names and
+// selected name suffixes. The “<=”, “:=” and “=>” delimiters are reported as well, with a zero length.
+static QList<QPair<int, int>> scanIdentifiers(const QString &token)
+{
+    QList<QPair<int, int>> parts;
+    const int length = token.length();
+    int i = 0;
+    while (i < length)
     {
-        return startsWith("--");
+        const QChar c = token.at(i);
+        const QChar next = (i + 1 < length) ? token.at(i + 1) : QChar();
+        if (c == '\'' && i + 2 < length && token.at(i + 2) == '\'')
+        {
+            // Character literal
+            i += 3;
+        }
+        else if (c == '"' || c == '#')
+        {
+            // String, bit string or based literal
+            const int end = token.indexOf(c, i + 1);
+            i = (end < 0) ? length : end + 1;
+        }
+        else if (c.isDigit())
+        {
+            // Abstract literal, possibly followed by a unit
+            while (i < length && (token.at(i).isLetterOrNumber() || token.at(i) == '_' || token.at(i) == '.'))
+                i += 1;
+        }
+        else if (c.isLetter())
+        {
+            const int start = i;
+            while (i < length && (token.at(i).isLetterOrNumber() || token.at(i) == '_'))
+                i += 1;
+            const QChar before = (start > 0) ? token.at(start - 1) : QChar();
+            const QChar after = (i < length) ? token.at(i) : QChar();
+            if (before != '\'' && before != '.' && after != '"')
+                parts.append(qMakePair(start, i - start));
+        }
+        else if ((c == '<' || c == ':' || c == '=') && (next == '=' || (c == '=' && next == '>')))
+        {
+            parts.append(qMakePair(i, 0));
+            i += 2;
+        }
+        else
+            i += 1;
     }
+    return parts;
+}
 
-    bool isWhitespace() const
+// Clocks of a condition: “rising_edge(clk)”, “falling_edge(clk)” or “clk'event and clk = '1'”
+static void findClocks(const QString &condition, QList<Clock> &clocks)
+{
+    static const QRegularExpression edgeFunction("\\b(rising|falling)_edge\\s*\\(\\s*(\\w+)", QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression eventAttribute("\\b(\\w+)\\s*'\\s*event\\b", QRegularExpression::CaseInsensitiveOption);
+
+    QList<Clock> found;
+    for (const QRegularExpressionMatch &match : edgeFunction.globalMatch(condition))
+        found.append(Clock { match.captured(2).toLower(), (match.captured(1).toLower() == "rising") ? Clock::Edge::Rising : Clock::Edge::Falling });
+    for (const QRegularExpressionMatch &match : eventAttribute.globalMatch(condition))
     {
-        return trimmed().isEmpty();
+        // The edge is given by the level compared after the event
+        const QString signal = match.captured(1).toLower();
+        const QRegularExpression level(QString("\\b%1\\s*=\\s*'([01])'").arg(QRegularExpression::escape(signal)), QRegularExpression::CaseInsensitiveOption);
+        const QRegularExpressionMatch levelMatch = level.match(condition);
+        Clock::Edge edge = Clock::Edge::Any;
+        if (levelMatch.hasMatch())
+            edge = (levelMatch.captured(1) == "1") ? Clock::Edge::Rising : Clock::Edge::Falling;
+        found.append(Clock { signal, edge });
     }
-};
+
+    for (const Clock &clock : found)
+        if (std::none_of(clocks.cbegin(), clocks.cend(), [&](const Clock &known) { return known.signal == clock.signal; }))
+            clocks.append(clock);
+}
+
+// Split an association list at its top level commas, into “formal => actual” or positional elements
+static QList<Association> splitAssociations(const QString &list)
+{
+    QList<Association> associations;
+    int depth = 0;
+    bool quoted = false;
+    int start = 0;
+    int arrow = -1;
+    for (int i = 0; i <= list.length(); ++i)
+    {
+        const QChar c = (i < list.length()) ? list.at(i) : QChar(',');
+        if (c == '"')
+            quoted = !quoted;
+        if (quoted)
+            continue;
+        if (c == '(')
+            depth += 1;
+        else if (c == ')')
+            depth -= 1;
+        else if (depth == 0 && c == '=' && i + 1 < list.length() && list.at(i + 1) == '>' && arrow < 0)
+            arrow = i;
+        else if (depth == 0 && c == ',')
+        {
+            if (arrow < 0)
+                associations.append(Association { QString(), list.mid(start, i - start).trimmed(), { } });
+            else
+                associations.append(Association { list.mid(start, arrow - start).trimmed(), list.mid(arrow + 2, i - arrow - 2).trimmed(), { } });
+            start = i + 1;
+            arrow = -1;
+        }
+    }
+    return associations;
+}
+
+// Get the name of a subprogram from its specification
+static QString subprogramName(const QString &specification)
+{
+    QStringList words = specification.section('(', 0, 0).simplified().split(' ');
+    if (words.value(0).compare("pure", Qt::CaseInsensitive) == 0 || words.value(0).compare("impure", Qt::CaseInsensitive) == 0)
+        words.removeFirst();
+    return words.value(1);
+}
 
 /******************************************************************************/
 
-bool VhdlParser::parse()
+// State of a parse, kept from one line to the next so that the source can be given in chunks
+class VhdlParser::Session
 {
-    QString errorString;
-    QStack<State> state;
-    state.push(State::Base);
+public:
+    Design *design;
+    QString filePath;
+    FileId fileId;
+    const bool tracing;
+    // Netlist mode, see VhdlParser::setNetlistMode()
+    const bool netlist;
+    NetlistSpill spill;
+    // Held while accessing the design when several sessions parse the units of the same file
+    QMutex *designLock;
+
+    InlineStack<State, MAX_NESTING_DEPTH> state;
     int parenCount = 0;
 
     Entity dummyEntity;
     Entity *currentEntity = &dummyEntity;
+    Entity *parentEntity = nullptr;
     Architecture *currentArchitecture = nullptr;
+    Package *currentPackage = nullptr;
+    bool packageBody = false;
+    Type *currentType = nullptr;
     Target target = Target::Signal;
 
     QString name;
     QString direction;
     QString type;
+    QString constraint;
     QString value;
+    QStringList fieldNames;
+    QStringList genericNames;
+    QList<Location> genericLocations;
+    Location nameLocation;
 
-    // Open the source file
-    const QString filePath = _sourceFile.canonicalFilePath();
-    Logger::info(tr("Parsing %1").arg(filePath));
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    // Types are declared in the innermost scope, and looked up from the innermost scope outwards
+    QStringList scopes;
+
+    // Locations are character offsets in the file, lines are found from the line offset table
+    unsigned int lineNumber = 0;
+    QList<quint32> lineOffsets;
+    quint32 lineOffset = 0;
+    Location tokenLocation;
+    // End of the source given to the push interface, up to the next line break
+    QByteArray pendingLine;
+    // Long lines are parsed in pieces, the next piece continues the line and maybe a comment
+    bool lineContinued = false;
+    bool inComment = false;
+
+    // References found in a statement are recorded once its end is reached, since the rest of
+    // the statement tells whether a name is read, assigned or instantiated.
+    // In netlist mode they are only needed until the end of the statement, so they are not kept in the design.
+    // When the units of a file are parsed in parallel, they are merged into the design once all of them are parsed.
+    CrossReferenceIndex localIndex;
+    CrossReferenceIndex &references;
+    QList<Reference> statementReferences;
+    int statementStart = 0;
+    bool assignmentAllowed = false;
+    bool labelled = false;
+    bool instancePending = false;
+    QString label;
+
+    // Generate statements being parsed, with the stack length of their body
+    QList<QPair<int, int>> generates;
+    Generate::Kind schemeKind = Generate::Kind::If;
+    QString schemeLabel;
+    Location schemeLocation;
+
+    // Instance whose generic map or port map is being parsed, not created in netlist mode
+    Instance *currentInstance = nullptr;
+    bool instanceAdded = false;
+    QString instancePath;
+    TokenClass mapClass = TokenClass::Port;
+
+    // Names assigned and read by the statements of the current process, its body is at processDepth
+    int processDepth = 0;
+    Process process;
+    QStringList processSources;
+
+    Session(Design *design, const QString &filePath, FileId fileId, bool netlist, QMutex *designLock = nullptr);
+
+    Type *declareType(Type::Kind kind);
+    static QStringList useScopes(Entity *entity);
+    TypeId resolveType(const QString &subtypeIndication);
+    int currentGenerate();
+
+    Reference reference(const QString &identifier, Reference::Kind kind);
+    void addDeclaration(const QString &identifier);
+    void flushReferences();
+    void beginStatement();
+    void addSignal();
+    void addInstance(const QString &unit, const Location &location);
+
+    bool parseLine(const QString &line);
+    bool write(const QByteArray &chunk);
+    void seek(quint32 offset, unsigned int line);
+    bool finish();
+};
+
+VhdlParser::Session::Session(Design *design, const QString &filePath, FileId fileId, bool netlist, QMutex *designLock) :
+    tracing(Logger::verbosity() >= Logger::LogLevel::Trace),
+    netlist(netlist),
+    designLock(designLock),
+    references((netlist || designLock != nullptr) ? localIndex : design->references())
+{
+    this->design = design;
+    this->filePath = filePath;
+    this->fileId = fileId;
+    tokenLocation = Location { fileId, 0 };
+    state.push(State::Base);
+}
+
+Type *VhdlParser::Session::declareType(Type::Kind kind)
+{
+    QMutexLocker locker(designLock);
+    Type *declared = design->declareType(QString("%1.%2").arg(scopes.value(0, WORKSPACE_NAME)).arg(name), kind);
+    declared->setLocation(nameLocation);
+    // Types of the package body are local to it
+    if (currentPackage != nullptr && !packageBody)
+        currentPackage->addType(name, declared->id());
+    return declared;
+}
+
+// Packages made visible by use clauses are the outermost scopes
+QStringList VhdlParser::Session::useScopes(Entity *entity)
+{
+    QStringList packages;
+    for (auto it = entity->getUses().cbegin(); it != entity->getUses().cend(); ++it)
+        packages.append(QString("%1.%2").arg(it.key()).arg(it.value().section('.', 0, 0)));
+    return packages;
+}
+
+TypeId VhdlParser::Session::resolveType(const QString &subtypeIndication)
+{
+    QMutexLocker locker(designLock);
+    return design->resolveType(scopes, typeMark(subtypeIndication));
+}
+
+int VhdlParser::Session::currentGenerate()
+{
+    return generates.isEmpty() ? NO_GENERATE : generates.last().first;
+}
+
+Reference VhdlParser::Session::reference(const QString &identifier, Reference::Kind kind)
+{
+    return Reference { references.identifier(identifier), references.identifier(scopes.value(0, WORKSPACE_NAME)), tokenLocation, kind };
+}
+
+void VhdlParser::Session::addDeclaration(const QString &identifier)
+{
+    if (netlist)
+        return;
+    references.addReference(reference(identifier, Reference::Kind::Declaration));
+}
+
+void VhdlParser::Session::flushReferences()
+{
+    // Netlists have no cross-references, assignments or processes
+    if (netlist)
     {
-        Logger::error(tr("Failed to open file: %1").arg(file.errorString()));
-        return false;
+        statementReferences.clear();
+        statementStart = 0;
+        localIndex = CrossReferenceIndex();
+        return;
     }
 
-    // Parse the file
-    unsigned int lineNumber = 0;
-    while (!file.atEnd())
+    QStringList targets;
+    QStringList sources;
+    for (const Reference &pending : statementReferences)
+    {
+        references.addReference(pending);
+        if (pending.kind == Reference::Kind::Write)
+            targets.append(references.identifierName(pending.identifier));
+        else if (pending.kind == Reference::Kind::Read)
+            sources.append(references.identifierName(pending.identifier));
+    }
+
+    // Processes are recorded as a whole, conditions are sources of all the assignments of a process
+    if (currentArchitecture != nullptr && processDepth != 0)
+    {
+        process.targets.append(targets);
+        processSources.append(sources);
+    }
+    else if (currentArchitecture != nullptr && !targets.isEmpty())
+        currentArchitecture->addAssignment(targets, sources, statementReferences.first().location);
+    statementReferences.clear();
+    statementStart = 0;
+}
+
+void VhdlParser::Session::beginStatement()
+{
+    flushReferences();
+    assignmentAllowed = true;
+    labelled = false;
+    instancePending = false;
+    currentInstance = nullptr;
+    instanceAdded = false;
+}
+
+void VhdlParser::Session::addSignal()
+{
+    if (!netlist)
+    {
+        currentArchitecture->addSignal(name, type, resolveType(type), nameLocation);
+        return;
+    }
+    currentArchitecture->countSignal();
+    spill.write(NetlistSpill::Record { NetlistSpill::Kind::Signal, scopes.value(0), name.trimmed(), type.trimmed(), nameLocation });
+}
+
+void VhdlParser::Session::addInstance(const QString &unit, const Location &location)
+{
+    instanceAdded = true;
+    if (unit.section('.', 0, 0).compare(WORKSPACE_NAME, Qt::CaseInsensitive) != 0)
+    {
+        QMutexLocker locker(designLock);
+        LibrarySummary::importUnit(design, unit.section('.', 0, 0), unit.section('.', 1, 1));
+    }
+    if (!netlist)
+    {
+        currentInstance = currentArchitecture->addInstance(label, unit, location, currentGenerate());
+        return;
+    }
+    instancePath = currentArchitecture->generatePath(currentGenerate(), label.trimmed());
+    currentArchitecture->countInstance(unit);
+    spill.write(NetlistSpill::Record { NetlistSpill::Kind::Instance, scopes.value(0), instancePath, unit.trimmed(), location });
+}
+
+bool VhdlParser::Session::parseLine(const QString &line)
+{
+    static constexpr TransitionTable transitions;
+
+    QString errorString;
+    if (!lineContinued)
     {
         lineNumber += 1;
-        const QString line = QString(file.readLine());
-        for (const Token token : line.split(QRegularExpression("(?=[\\(\\):;\\s])|(?<=[\\(\\):;\\s])"), Qt::SkipEmptyParts))
+        lineOffsets.append(lineOffset);
+        inComment = false;
+    }
+    lineContinued = !line.endsWith('\n');
+    // The rest of a comment split between two pieces
+    if (inComment)
+    {
+        lineOffset += line.length();
+        return true;
+    }
+    qsizetype column = 0;
+    while (column < line.size())
+    {
+        // ASCII whitespaces are tokens by themselves, they are skipped without making a token
+        const char16_t first = line.at(column).unicode();
+        if (first == ' ' || (first >= '\t' && first <= '\r'))
         {
-            // Skip whitespaces
-            if (token.isWhitespace())
-                continue;
-            // Skip comments
-            if (token.isCommentStart())
+            column += 1;
+            continue;
+        }
+
+        // The tokens of a skipped statement do not matter up to its semicolon, only comments have to be noticed.
+        // They are not traced either.
+        if (state.top() == State::SkipToSemicolon)
+        {
+            qsizetype next = TokenScanner::findEither(line, column, ';', '-');
+            while (next < line.size() && line.at(next) == '-'
+                   && !(next + 1 < line.size() && line.at(next + 1) == '-' && (next == 0 || TokenScanner::isSeparator(line.at(next - 1).unicode()))))
+                next = TokenScanner::findEither(line, next + 1, ';', '-');
+            if (next == line.size())
                 break;
+            if (line.at(next) == '-')
+            {
+                inComment = true;
+                break;
+            }
+            column = next;
+        }
+
+        // Separators are tokens by themselves, the other tokens run up to the next separator
+        const qsizetype end = std::max(TokenScanner::findSeparator(line, column), column + 1);
+        const Token token(line.mid(column, end - column));
+        tokenLocation.offset = lineOffset + column;
+        column = end;
+
+        const TokenClass tokenClass = token.tokenClass();
+        // Skip whitespaces
+        if (tokenClass == TokenClass::Whitespace)
+            continue;
+        // Skip comments, up to the end of the line
+        if (tokenClass == TokenClass::Comment)
+        {
+            inComment = true;
+            break;
+        }
 
-            // Display all tokens and stack length, for debugging
+        // Display all tokens and stack length, for debugging
+        if (tracing)
             Logger::trace(tr("state = 0x%1 | %2; token = %3").arg(static_cast<unsigned int>(state.top()), 4, 16, QChar('0')).arg(state.length()).arg(token));
 
-            // Check token depending on the current state
-            switch (state.top()) {
-
-            case State::Base:
-                if (token.is("library"))
-                    state.push(State::Library);
-                else if (token.is("use"))
-                    state.push(State::Use);
-                else if (token.is("entity"))
-                    state.push(State::Entity);
-                else if (token.is("architecture"))
-                    state.push(State::Architecture);
-                else
-                    goto unexpected;
-                break;
+        // Look up the transition for the current state, then run its action
+        const auto &transition = transitions.at(state.top(), tokenClass);
+        switch (transition.action) {
 
-            case State::Library:
-                // We probably don't really need to track libraries
-                currentEntity = &dummyEntity;
-                if (!token.is(';'))
-                    state.top() = State::SkipToSemicolon;
-                else
-                    goto unexpected;
-                break;
+        case Action::None:
+            break;
+        case Action::Unexpected:
+            goto unexpected;
 
-            case State::Use:
-                // We accept pretty much anything for now
-                if (token.matches("\\w+\\..*"))
-                {
-                    currentEntity->addUse(token.section('.', 0, 0), token.section('.', 1));
-                    state.top() = State::ExpectSemicolon;
-                }
-                else
-                    goto unexpected;
-                break;
+        case Action::ResetContext:
+            currentEntity = &dummyEntity;
+            scopes.clear();
+            break;
+        case Action::SkipUnit:
+            // The context clause of a skipped unit does not apply to the next one
+            currentEntity = &dummyEntity;
+            dummyEntity.reset();
+            scopes.clear();
+            break;
+        case Action::AddUse:
+        {
+            currentEntity->addUse(token.section('.', 0, 0), token.section('.', 1));
+            // Packages of compiled libraries are declared from their summary, if any
+            if (token.section('.', 0, 0).compare(WORKSPACE_NAME, Qt::CaseInsensitive) != 0)
+            {
+                QMutexLocker locker(designLock);
+                LibrarySummary::importUnit(design, token.section('.', 0, 0), token.section('.', 1, 1));
+            }
+            break;
+        }
 
-            /******************************************************************************/
+        /******************************************************************************/
 
-            case State::Entity:
-                if (token.matches("\\w+"))
-                {
-                    // Create a copy of the current entity and add it to the list
-                    Entity *newEntity = new Entity;
-                    *newEntity = *currentEntity;
-                    currentEntity = newEntity;
-                    currentEntity->setName(QString("%1.%2").arg(WORKSPACE_NAME).arg(token));
-                    _design->addEntity(currentEntity);
-                    dummyEntity.reset();
-
-                    state.top() = State::EntityBody;
-                    state.push(State::ExpectIs);
-                }
-                else
-                    goto unexpected;
-                break;
-            case State::EntityBody:
-                if (token.is("generic"))
-                {
-                    state.push(State::EntityGeneric);
-                    state.push(State::ExpectOpeningParenthesis);
-                }
-                else if (token.is("port"))
-                {
-                    state.push(State::ExpectSemicolon);
-                    state.push(State::EntityPort);
-                    state.push(State::ExpectOpeningParenthesis);
-                }
-                else if (token.is("attribute"))
-                    state.push(State::SkipToSemicolon);
-                else if (token.is("end"))
-                    state.top() = State::SkipToSemicolon;
-                else
-                    goto unexpected;
-                break;
-            case State::EntityGeneric:
-                // Skip generic definitions for now
-                state.top() = State::ExpectSemicolon;
-                if (!token.is(')'))
-                    state.push(State::SkipToClosingParenthesis);
-                break;
-            case State::EntityPort:
-                if (token.isIdentifier())
-                {
-                    name = token;
-                    direction = "";
-                    type = "";
-                    state.push(State::EntityPortDirection);
-                    state.push(State::ExpectColon);
-                }
-                else
-                    goto unexpected;
-                break;
-            case State::EntityPortDirection:
-                if (token.isIdentifier())
-                {
-                    direction = token;
-                    parenCount = 0;
-                    state.top() = State::EntityPortType;
-                }
-                else
-                    goto unexpected;
-                break;
-            case State::EntityPortType:
-                if (token.is(':'))
-                {
-                    if (type.isEmpty())
-                        goto unexpected;
-                    currentEntity->addPort(name, direction, type);
-                    state.top() = State::EntityPortAssignment;
-                    state.push(State::ExpectEqual);
-                }
-                else if (token.is(';'))
-                {
-                    if (type.isEmpty())
-                        goto unexpected;
-                    currentEntity->addPort(name, direction, type);
-                    state.pop();
-                }
-                else if (token.is(')'))
-                {
-                    if (parenCount != 0)
-                    {
-                        parenCount -= 1;
-                        type += token;
-                    }
-                    else
-                    {
-                        currentEntity->addPort(name, direction, type);
-                        state.pop();
-                        state.pop();
-                    }
-                }
-                else if (token.is('('))
-                {
-                    parenCount += 1;
-                    type += token;
-                }
-                else
-                {
-                    if (!type.endsWith('('))
-                        type += ' ';
-                    type += token;
-                }
-                break;
-            case State::EntityPortAssignment:
-                // Default assignments are ignored
-                if (token.is(';'))
-                    state.pop();
-                else if (token.is(')'))
-                {
-                    if (parenCount != 0)
-                        parenCount -= 1;
-                    else
-                    {
-                        state.pop();
-                        state.pop();
-                    }
-                }
-                else if (token.is('('))
-                    parenCount += 1;
-                break;
+        case Action::AddEntity:
+        {
+            // Create a copy of the current entity and add it to the list
+            Entity *newEntity = new Entity;
+            *newEntity = *currentEntity;
+            currentEntity = newEntity;
+            currentEntity->setName(QString("%1.%2").arg(WORKSPACE_NAME).arg(token));
+            currentEntity->setLocation(tokenLocation);
+            QMutexLocker locker(designLock);
+            design->addEntity(currentEntity);
+            locker.unlock();
+            dummyEntity.reset();
+            scopes = QStringList { currentEntity->name() } + useScopes(currentEntity);
+            addDeclaration(token);
+            break;
+        }
+        case Action::AddGenericNames:
+        {
+            int offset = 0;
+            for (const QString &genericName : token.split(',', Qt::SkipEmptyParts))
+            {
+                offset = token.indexOf(genericName, offset);
+                genericNames.append(genericName);
+                genericLocations.append(Location { fileId, tokenLocation.offset + offset });
+                addDeclaration(genericName);
+            }
+            break;
+        }
+        case Action::BeginGenericType:
+            type = "";
+            value = "";
+            parenCount = 0;
+            break;
+        case Action::BeginGenericDefault:
+            if (type.isEmpty() || parenCount != 0)
+                goto unexpected;
+            value = "";
+            break;
+        case Action::CloseGenericType:
+        case Action::CloseGenericDefault:
+            // A closing parenthesis either belongs to the generic or ends the generic list
+            if (parenCount != 0)
+            {
+                parenCount -= 1;
+                (transition.action == Action::CloseGenericType ? type : value) += token;
+                continue;
+            }
+            [[fallthrough]];
+        case Action::AddGeneric:
+            if (type.isEmpty() || parenCount != 0 || genericNames.isEmpty())
+                goto unexpected;
+            for (int i = 0; i < genericNames.count(); ++i)
+                currentEntity->addGeneric(genericNames.at(i), type, resolveType(type), value, genericLocations.at(i));
+            genericNames.clear();
+            genericLocations.clear();
+            break;
+        case Action::BeginPort:
+            name = token;
+            nameLocation = tokenLocation;
+            direction = "";
+            type = "";
+            addDeclaration(token);
+            break;
+        case Action::SetPortDirection:
+            direction = token;
+            parenCount = 0;
+            break;
+        case Action::AddPort:
+            if (type.isEmpty())
+                goto unexpected;
+            currentEntity->addPort(name, direction, type, resolveType(type), nameLocation);
+            break;
+        case Action::ClosePortList:
+            // A closing parenthesis either belongs to the type or ends the port list
+            if (parenCount != 0)
+            {
+                parenCount -= 1;
+                type += token;
+                continue;
+            }
+            currentEntity->addPort(name, direction, type, resolveType(type), nameLocation);
+            break;
 
-            /******************************************************************************/
+        /******************************************************************************/
 
-            case State::Architecture:
-                if (token.isIdentifier())
-                {
-                    name = token;
-                    state.top() = State::ArchitectureOf;
-                    state.push(State::ExpectOf);
-                }
-                else
-                    goto unexpected;
+        case Action::AddPackage:
+        {
+            // The body is usually parsed after the declaration, but not necessarily
+            const QString packageName = QString("%1.%2").arg(WORKSPACE_NAME).arg(token);
+            QMutexLocker locker(designLock);
+            currentPackage = design->package(packageName);
+            if (currentPackage == nullptr)
+            {
+                currentPackage = new Package;
+                currentPackage->setName(packageName);
+                design->addPackage(currentPackage);
+            }
+            locker.unlock();
+            if (packageBody)
+            {
+                currentPackage->setBodyLocation(tokenLocation);
+                currentPackage->setBodyUses(currentEntity->getUses());
+            }
+            else
+            {
+                currentPackage->setLocation(tokenLocation);
+                currentPackage->setUses(currentEntity->getUses());
+            }
+            // The declarations of the body have their own scope, so that they cannot be resolved outside of it
+            scopes = QStringList { currentPackage->name() } + useScopes(currentEntity);
+            if (packageBody)
+                scopes.prepend(QString("%1.body").arg(currentPackage->name()));
+            addDeclaration(token);
+            currentEntity = &dummyEntity;
+            dummyEntity.reset();
+            break;
+        }
+        case Action::SelectPackageBody:
+            packageBody = true;
+            break;
+        case Action::EndPackage:
+            currentPackage = nullptr;
+            packageBody = false;
+            scopes.clear();
+            break;
+        case Action::BeginSubprogram:
+            value = token;
+            parenCount = 0;
+            break;
+        case Action::AddSubprogram:
+            // Parameters are separated by semicolons as well
+            if (parenCount != 0)
+            {
+                value += token;
+                continue;
+            }
+            // Subprograms of the body are either declared in the package already, or local to the body
+            if (!packageBody)
+                currentPackage->addSubprogram(subprogramName(value), value);
+            break;
+        case Action::AddComponent:
+            parentEntity = currentEntity;
+            currentEntity = new Entity;
+            currentEntity->setName(token);
+            currentEntity->setLocation(tokenLocation);
+            currentPackage->addComponent(currentEntity);
+            addDeclaration(token);
+            break;
+        case Action::EndComponent:
+            currentEntity = parentEntity;
+            break;
+
+        /******************************************************************************/
+
+        case Action::SetArchitectureName:
+            name = token;
+            nameLocation = tokenLocation;
+            break;
+        case Action::AddArchitecture:
+        {
+            QMutexLocker locker(designLock);
+            Entity *entity = design->entity(QString("%1.%2").arg(WORKSPACE_NAME).arg(token));
+            locker.unlock();
+            if (entity == nullptr)
+            {
+                errorString = QString("Unknown entity “%1”").arg(token);
+                goto error;
+            }
+            currentArchitecture = new Architecture;
+            currentArchitecture->setName(name);
+            currentArchitecture->setLocation(nameLocation);
+            currentArchitecture->setSummarized(netlist);
+            entity->addArchitecture(currentArchitecture);
+            generates.clear();
+            scopes = QStringList { QString("%1.%2").arg(entity->name()).arg(name), entity->name() } + useScopes(entity);
+            references.addReference(Reference { references.identifier(name), references.identifier(scopes.first()), nameLocation, Reference::Kind::Declaration });
+            break;
+        }
+        case Action::SelectSignal:
+            target = Target::Signal;
+            break;
+        case Action::SelectConstant:
+            target = Target::Constant;
+            break;
+        case Action::BeginObject:
+            name = token;
+            nameLocation = tokenLocation;
+            type = "";
+            value = "";
+            addDeclaration(token);
+            break;
+        case Action::BeginStatement:
+            beginStatement();
+            break;
+        case Action::EndBlock:
+            beginStatement();
+            if (processDepth == state.length())
+            {
+                process.targets.removeDuplicates();
+                processSources.removeDuplicates();
+                if (!process.targets.isEmpty())
+                    process.assignment = currentArchitecture->addAssignment(process.targets, processSources, process.location);
+                if (!netlist)
+                    currentArchitecture->addProcess(process);
+                processSources.clear();
+                processDepth = 0;
+            }
+            if (!generates.isEmpty() && generates.last().second == state.length())
+                generates.removeLast();
+            break;
+        case Action::BeginProcess:
+            process = Process { labelled ? label : QString(), { }, { }, { }, -1, labelled ? statementReferences.first().location : tokenLocation };
+            beginStatement();
+            // The body of the process is pushed by this transition
+            processDepth = state.length() + 1;
+            break;
+        case Action::AddSensitivity:
+            for (const auto &part : scanIdentifiers(token))
+            {
+                const Token name = token.mid(part.first, part.second);
+                if (part.second == 0)
+                    continue;
+                if (name.tokenClass() == TokenClass::Identifier)
+                    statementReferences.append(reference(name, Reference::Kind::Read));
+                process.sensitivity.append(name.toLower());
+            }
+            break;
+        case Action::BeginCondition:
+            assignmentAllowed = false;
+            break;
+        case Action::EndCondition:
+            if (processDepth != 0)
+                findClocks(value, process.clocks);
+            beginStatement();
+            break;
+        case Action::BeginScheme:
+            schemeKind = (tokenClass == TokenClass::For) ? Generate::Kind::For : Generate::Kind::If;
+            schemeLabel = labelled ? label : QString();
+            schemeLocation = labelled ? statementReferences.first().location : tokenLocation;
+            value = "";
+            assignmentAllowed = false;
+            break;
+        case Action::AddGenerate:
+        {
+            // Alternatives of a VHDL-2008 if-generate replace the previous one, under the same label
+            if (!generates.isEmpty() && generates.last().second == state.length())
+            {
+                if (schemeLabel.isEmpty())
+                    schemeLabel = currentArchitecture->generate(generates.last().first).label;
+                generates.removeLast();
+            }
+
+            // The scheme of a for-generate is “parameter in range”
+            Generate generate { schemeKind, schemeLabel, QString(), value, currentGenerate(), schemeLocation };
+            if (schemeKind == Generate::Kind::For)
+            {
+                generate.parameter = value.section(' ', 0, 0);
+                generate.scheme = value.section(' ', 2);
+            }
+            generates.append(qMakePair(currentArchitecture->addGenerate(generate), state.length()));
+            beginStatement();
+            break;
+        }
+        case Action::BeginInstance:
+            instancePending = labelled;
+            break;
+        case Action::MarkInstance:
+            mapClass = tokenClass;
+            // A component instantiation without the “component” reserved word
+            if (labelled && !instanceAdded && statementReferences.count() == 2 && statementReferences.last().kind == Reference::Kind::Read)
+            {
+                statementReferences.last().kind = Reference::Kind::Instantiation;
+                addInstance(QString("%1.%2").arg(WORKSPACE_NAME).arg(references.identifierName(statementReferences.last().identifier)), statementReferences.last().location);
+            }
+            break;
+        case Action::BeginAssociations:
+            value = "";
+            parenCount = 0;
+            break;
+        case Action::CloseAssociationList:
+        {
+            // A closing parenthesis either belongs to an actual or ends the list
+            if (parenCount != 0)
+            {
+                parenCount -= 1;
+                value += token;
+                continue;
+            }
+            if (netlist && instanceAdded)
+                spill.write(NetlistSpill::Record { mapClass == TokenClass::Generic ? NetlistSpill::Kind::GenericMap : NetlistSpill::Kind::PortMap, scopes.value(0), instancePath, value, tokenLocation });
+            if (currentInstance == nullptr)
                 break;
-            case State::ArchitectureOf:
-                if (token.isIdentifier())
+            QList<Association> associations = splitAssociations(value);
+            for (Association &association : associations)
+                for (const auto &part : scanIdentifiers(association.actual))
                 {
-                    currentArchitecture = new Architecture;
-                    currentArchitecture->setName(name);
-                    Entity *entity = _design->entity(QString("%1.%2").arg(WORKSPACE_NAME).arg(token));
-                    if (entity != nullptr)
-                    {
-                        entity->addArchitecture(currentArchitecture);
-                        state.top() = State::ArchitectureHeader;
-                        state.push(State::ExpectIs);
-                    }
-                    else
-                    {
-                        errorString = QString("Unknown entity “%1”").arg(token);
-                        goto error;
-                    }
+                    const Token identifier = association.actual.mid(part.first, part.second);
+                    if (part.second != 0 && identifier.tokenClass() == TokenClass::Identifier)
+                        association.names.append(identifier.toLower());
                 }
-                else
-                    goto unexpected;
+            (mapClass == TokenClass::Generic ? currentInstance->genericMap : currentInstance->portMap) = associations;
+            break;
+        }
+        case Action::AddLabel:
+            // The statement starts after the label
+            if (statementReferences.count() != 1)
                 break;
-            case State::ArchitectureHeader:
-                if (token.is("signal"))
-                {
-                    target = Target::Signal;
-                    state.push(State::ArchitectureSignal);
-                }
-                else if (token.is("constant"))
-                {
-                    target = Target::Constant;
-                    state.push(State::ArchitectureSignal);
-                }
-                else if (token.is("type"))
-                {
-                    // TODO: type parsing
-                    errorString = "type parsing is not implemented yet";
-                    goto error;
-                }
-                else if (token.is("function") || token.is("procedure"))
-                {
-                    // Ignore functions
-                    state.push(State::SkipToEnd);
-                    state.push(State::SkipToBegin);
-                }
-                else if (token.is("component"))
-                {
-                    // Ignore components
-                    state.push(State::SkipToEnd);
-                }
-                else if (token.is("begin"))
-                {
-                    // TODO: architecture body
-                    state.top() = State::SkipToEnd;
-                }
-                else
-                    goto unexpected;
+            label = references.identifierName(statementReferences.first().identifier);
+            statementReferences.first().kind = Reference::Kind::Declaration;
+            statementStart = 1;
+            assignmentAllowed = true;
+            labelled = true;
+            break;
+        case Action::AssignVariable:
+            // “:=” is split into two tokens, so what looked like a label is the target of an assignment
+            if (labelled && statementReferences.count() == 1)
+            {
+                statementReferences.first().kind = Reference::Kind::Write;
+                statementStart = 0;
+                assignmentAllowed = false;
+                labelled = false;
+            }
+            break;
+        case Action::DeclareReference:
+            if (!assignmentAllowed || statementReferences.count() != 1)
                 break;
-            case State::ArchitectureSignal:
-                if (token.isIdentifier())
-                {
-                    name = token;
-                    type = "";
-                    value = "";
-                    state.top() = State::ArchitectureSignalType;
-                    state.push(State::ExpectColon);
-                }
-                else
-                    goto unexpected;
+            statementReferences.first().kind = Reference::Kind::Declaration;
+            flushReferences();
+            assignmentAllowed = false;
+            break;
+        case Action::AppendExpression:
+        case Action::AppendExpressionReferences:
+            if (!value.isEmpty() && !value.endsWith('(') && token != ")")
+                value += ' ';
+            value += token;
+            if (transition.action == Action::AppendExpression)
                 break;
-            case State::ArchitectureSignalType:
-                if (token.is(':'))
-                {
-                    if (type.isEmpty() || parenCount != 0)
-                        goto unexpected;
-                    if (target == Target::Signal && currentArchitecture != nullptr)
-                        currentArchitecture->addSignal(name, type);
-                    state.top() = State::ArchitectureSignalAssignment;
-                    state.push(State::ExpectEqual);
-                }
-                else if (token.is(';'))
-                {
-                    if (type.isEmpty() || parenCount != 0 || target == Target::Constant)
-                        goto unexpected;
-                    if (currentArchitecture != nullptr)
-                        currentArchitecture->addSignal(name, type);
-                    state.pop();
-                }
-                else if (token.is(')'))
-                {
-                    if (parenCount != 0)
-                    {
-                        parenCount -= 1;
-                        type += token;
-                    }
-                    else
-                        goto unexpected;
-                }
-                else if (token.is('('))
-                {
-                    parenCount += 1;
-                    type += token;
-                }
-                else
-                {
-                    if (!type.endsWith('('))
-                        type += ' ';
-                    type += token;
-                }
+            [[fallthrough]];
+        case Action::AddReferences:
+            if (instancePending)
+            {
+                // Instantiated unit, either “entity library.name” or “component name”
+                const QString unit = (tokenClass == TokenClass::SelectedName) ? token : QString("%1.%2").arg(WORKSPACE_NAME).arg(token);
+                statementReferences.append(reference(unit.section('.', -1), Reference::Kind::Instantiation));
+                addInstance(unit, tokenLocation);
+                instancePending = false;
                 break;
-            case State::ArchitectureSignalAssignment:
-                // Default assignments are ignored
-                if (token.is(';'))
-                {
-                    if (parenCount != 0)
-                        goto unexpected;
-                    if (target == Target::Constant)
-                        currentArchitecture->addConstant(name, type, value);
-                    state.pop();
-                }
-                else if (token.is(')'))
+            }
+            for (const auto &part : scanIdentifiers(token))
+            {
+                if (part.second != 0)
                 {
-                    value += token;
-                    if (parenCount != 0)
-                        parenCount -= 1;
+                    const Token identifier = token.mid(part.first, part.second);
+                    if (identifier.tokenClass() == TokenClass::Identifier)
+                        statementReferences.append(reference(identifier, Reference::Kind::Read));
                 }
-                else if (token.is('('))
+                else if (token.at(part.first) == '=')
                 {
-                    parenCount += 1;
-                    value += token;
+                    // Associations and case alternatives
+                    flushReferences();
+                    assignmentAllowed = true;
                 }
-                else
+                else if (assignmentAllowed && statementReferences.count() > statementStart)
                 {
-                    if (!value.endsWith('('))
-                        value += ' ';
-                    value += token;
+                    // The target is the first name of the statement
+                    statementReferences[statementStart].kind = Reference::Kind::Write;
+                    assignmentAllowed = false;
                 }
+            }
+            break;
+        case Action::DeclareObject:
+            if (type.isEmpty() || parenCount != 0)
+                goto unexpected;
+            if (target == Target::Signal && currentArchitecture != nullptr)
+                addSignal();
+            break;
+        case Action::DeclareSignal:
+            if (type.isEmpty() || parenCount != 0)
+                goto unexpected;
+            // Only packages can declare deferred constants
+            if (target == Target::Constant)
+            {
+                if (currentPackage == nullptr)
+                    goto unexpected;
+                currentPackage->addConstant(name, type, resolveType(type), "", nameLocation, packageBody);
+            }
+            else if (currentArchitecture != nullptr)
+                addSignal();
+            break;
+        case Action::DeclareConstant:
+            if (parenCount != 0)
+                goto unexpected;
+            if (target != Target::Constant)
                 break;
+            if (currentPackage != nullptr)
+                currentPackage->addConstant(name, type, resolveType(type), value, nameLocation, packageBody);
+            else
+                currentArchitecture->addConstant(name, type, resolveType(type), value, nameLocation);
+            break;
 
-            /******************************************************************************/
+        /******************************************************************************/
 
-            case State::ExpectIs:
-                if (token.is("is"))
-                    state.pop();
-                else
-                    goto unexpected;
-                break;
-            case State::ExpectOf:
-                if (token.is("of"))
-                    state.pop();
-                else
-                    goto unexpected;
-                break;
-            case State::ExpectBegin:
-                if (token.is("begin"))
-                    state.pop();
-                else
-                    goto unexpected;
-                break;
-            case State::ExpectEnd:
-                if (token.is("end"))
-                    state.pop();
-                else
-                    goto unexpected;
-                break;
-            case State::ExpectOpeningParenthesis:
-                if (token.is('('))
-                    state.pop();
-                else
-                    goto unexpected;
-                break;
-            case State::ExpectClosingParenthesis:
-                if (token.is(')'))
-                    state.pop();
-                else
-                    goto unexpected;
-                break;
-            case State::ExpectSemicolon:
-                if (token.is(';'))
-                    state.pop();
-                else
+        case Action::BeginType:
+            addDeclaration(token);
+            name = token;
+            nameLocation = tokenLocation;
+            type = "";
+            constraint = "";
+            parenCount = 0;
+            fieldNames.clear();
+            break;
+        case Action::BeginSubtype:
+            addDeclaration(token);
+            name = token;
+            nameLocation = tokenLocation;
+            type = "";
+            constraint = "";
+            parenCount = 0;
+            currentType = declareType(Type::Kind::Subtype);
+            break;
+        case Action::BeginEnumerationType:
+            currentType = declareType(Type::Kind::Enumeration);
+            break;
+        case Action::BeginScalarType:
+            currentType = declareType(Type::Kind::Scalar);
+            break;
+        case Action::BeginPhysicalType:
+            currentType->setKind(Type::Kind::Physical);
+            break;
+        case Action::BeginArrayType:
+            currentType = declareType(Type::Kind::Array);
+            break;
+        case Action::BeginRecordType:
+            currentType = declareType(Type::Kind::Record);
+            break;
+        case Action::BeginAccessType:
+            currentType = declareType(Type::Kind::Access);
+            break;
+        case Action::BeginFileType:
+            currentType = declareType(Type::Kind::File);
+            break;
+        case Action::AddLiteral:
+            // Literals are separated by commas, which are not token separators
+            for (const QString &literal : token.split(',', Qt::SkipEmptyParts))
+                currentType->addLiteral(literal);
+            break;
+        case Action::AddFieldNames:
+            fieldNames.append(token.split(',', Qt::SkipEmptyParts));
+            break;
+        case Action::BeginFieldType:
+            type = "";
+            parenCount = 0;
+            break;
+        case Action::AddFields:
+        {
+            if (type.isEmpty() || parenCount != 0 || fieldNames.isEmpty())
+                goto unexpected;
+            const TypeId fieldType = resolveType(type);
+            for (const QString &fieldName : fieldNames)
+                currentType->addField(fieldName, fieldType);
+            fieldNames.clear();
+            break;
+        }
+        case Action::CloseArrayIndex:
+            // A closing parenthesis either belongs to the index constraint or ends it
+            if (parenCount != 0)
+            {
+                parenCount -= 1;
+                constraint += token;
+                continue;
+            }
+            break;
+        case Action::DeclareIncompleteType:
+            declareType(Type::Kind::Incomplete);
+            break;
+        case Action::DeclareType:
+            if (parenCount != 0)
+                goto unexpected;
+            switch (currentType->kind())
+            {
+            case Type::Kind::Subtype:
+            {
+                // Subtypes are compatible with their base type
+                if (type.isEmpty())
                     goto unexpected;
+                QMutexLocker locker(designLock);
+                const TypeId parentType = design->resolveType(scopes, typeMark(type, &constraint));
+                currentType->setBaseType(design->type(parentType)->baseType());
+                locker.unlock();
+                currentType->setConstraint(constraint);
                 break;
-            case State::ExpectColon:
-                if (token.is(':'))
-                    state.pop();
-                else
+            }
+            case Type::Kind::Array:
+            case Type::Kind::Access:
+            case Type::Kind::File:
+                if (type.isEmpty())
                     goto unexpected;
+                currentType->setElementType(resolveType(type));
+                currentType->setConstraint(constraint);
                 break;
-            case State::ExpectEqual:
-                if (token.is('='))
-                    state.pop();
-                else
-                    goto unexpected;
+            default:
+                currentType->setConstraint(constraint);
                 break;
+            }
+            currentType = nullptr;
+            break;
 
-            /******************************************************************************/
+        /******************************************************************************/
 
-            case State::SkipToBegin:
-                if (token.is("begin"))
-                    state.pop();
-                break;
-            case State::SkipToEnd:
-                if (token.is("end"))
-                    state.top() = State::SkipToSemicolon;
-                else if (token.is("elsif"))
-                    state.pop();
-                else if (token.is("begin") || token.is("then") || token.is("for") || token.is("case"))
-                    state.push(State::SkipToEnd);
-                else if ((token.count('"') & 1) != 0)
-                    state.push(State::SkipToStringEnd);
-                break;
-            case State::SkipToStringEnd:
-                if ((token.count('"') & 1) != 0)
-                    state.pop();
-                break;
-            case State::SkipToClosingParenthesis:
-                if (token.is(')'))
-                    state.pop();
-                else if (token.is('('))
-                    state.push(State::SkipToClosingParenthesis);
-                break;
-            case State::SkipToSemicolon:
-                if (token.is(';'))
-                    state.pop();
-                break;
-
-            /******************************************************************************/
+        case Action::AppendType:
+            if (!type.endsWith('('))
+                type += ' ';
+            type += token;
+            break;
+        case Action::OpenTypeParenthesis:
+            parenCount += 1;
+            type += token;
+            break;
+        case Action::CloseTypeParenthesis:
+            if (parenCount == 0)
+                goto unexpected;
+            parenCount -= 1;
+            type += token;
+            break;
+        case Action::AppendConstraint:
+            if (!constraint.endsWith('('))
+                constraint += ' ';
+            constraint += token;
+            break;
+        case Action::OpenConstraintParenthesis:
+            parenCount += 1;
+            constraint += token;
+            break;
+        case Action::CloseConstraintParenthesis:
+            if (parenCount == 0)
+                goto unexpected;
+            parenCount -= 1;
+            constraint += token;
+            break;
+        case Action::AppendValue:
+            if (!value.endsWith('('))
+                value += ' ';
+            value += token;
+            break;
+        case Action::OpenValueParenthesis:
+            parenCount += 1;
+            value += token;
+            break;
+        case Action::CloseValueParenthesis:
+            value += token;
+            if (parenCount != 0)
+                parenCount -= 1;
+            break;
+        case Action::OpenParenthesis:
+            parenCount += 1;
+            break;
+        case Action::CloseParenthesis:
+            // Only leave the list once the parentheses are balanced
+            if (parenCount != 0)
+            {
+                parenCount -= 1;
+                continue;
+            }
+            break;
+        }
 
-            default:
-                Logger::error(tr("%1:%2 Unexpected state (0x%3)").arg(filePath).arg(lineNumber).arg(static_cast<unsigned int>(state.top()), 4, 16, QChar('0')));
-                return false;
+        // Apply the stack operation
+        for (int i = 0; i < transition.popCount; ++i)
+            state.pop();
+        for (int i = 0; i < transition.pushCount; ++i)
+        {
+            if (!state.push(transition.pushed[i]))
+            {
+                errorString = QString("Maximum nesting depth (%1) exceeded").arg(MAX_NESTING_DEPTH);
+                goto error;
             }
-            continue;
+        }
+        continue;
 
 unexpected:
-            errorString = QString("“%1” unexpected (state = 0x%2)").arg(token).arg(static_cast<unsigned int>(state.top()), 4, 16, QChar('0'));
+        errorString = QString("“%1” unexpected (state = 0x%2)").arg(token).arg(static_cast<unsigned int>(state.top()), 4, 16, QChar('0'));
 error:
-            Logger::error(tr("%1:%2 %3").arg(filePath).arg(lineNumber).arg(errorString));
+        Logger::error(tr("%1:%2:%3 %4").arg(filePath).arg(lineNumber).arg(tokenLocation.offset - lineOffsets.last() + 1).arg(errorString));
+        return false;
+    }
+    lineOffset += line.length();
+    return true;
+}
+
+bool VhdlParser::Session::write(const QByteArray &chunk)
+{
+    // Lines are parsed once complete, the rest of the chunk waits for the next one
+    pendingLine.append(chunk);
+    qsizetype start = 0;
+    for (qsizetype end = pendingLine.indexOf('\n'); end >= 0; end = pendingLine.indexOf('\n', start))
+    {
+        // Line breaks are counted as a single character, as when reading a file in text mode
+        const qsizetype length = (end > start && pendingLine.at(end - 1) == '\r') ? end - start - 1 : end - start;
+        if (!parseLine(QString::fromUtf8(pendingLine.constData() + start, length) + '\n'))
             return false;
-        }
+        start = end + 1;
+    }
+
+    // A line too long to wait for its end is parsed up to its last separator, which does not change the tokens
+    if (pendingLine.size() - start > MAX_LINE_LENGTH)
+    {
+        static const QByteArray separators(" \t():;");
+        qsizetype end = pendingLine.size() - 1;
+        while (end >= start && !separators.contains(pendingLine.at(end)))
+            end -= 1;
+        if (end >= start && !parseLine(QString::fromUtf8(pendingLine.constData() + start, end + 1 - start)))
+            return false;
+        start = end + 1;
     }
+    pendingLine.remove(0, start);
+    return true;
+}
+
+// Continue parsing at the start of another line, for the units of a file parsed in parallel
+void VhdlParser::Session::seek(quint32 offset, unsigned int line)
+{
+    lineOffset = offset;
+    lineNumber = line - 1;
+    lineContinued = false;
+}
+
+bool VhdlParser::Session::finish()
+{
+    // The last line may not end with a line break
+    if (!pendingLine.isEmpty() && !parseLine(QString::fromUtf8(pendingLine)))
+        return false;
+    pendingLine.clear();
+    // The line offsets of a file parsed in parallel are merged once all its units are parsed
+    if (designLock == nullptr)
+        design->setLineOffsets(fileId, lineOffsets);
 
     if (state.top() != State::Base)
     {
         Logger::error(tr("%1 Unexpected end of file (state = 0x%2)").arg(filePath).arg(static_cast<unsigned int>(state.top()), 4, 16, QChar('0')));
         return false;
     }
+    return true;
+}
+
+/******************************************************************************/
+
+// Design unit found by the pre-scan of a file, from the start of its context clause to the start of the next unit
+struct VhdlParser::UnitRange {
+    qsizetype start;
+    // Character offset and line number of the start, as counted by the parser
+    quint32 offset;
+    unsigned int line;
+    // Units of the same entity or of the same package are parsed together, packages before the other units
+    QString group;
+    bool package;
+};
+
+static bool isWordCharacter(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '.' || static_cast<uchar>(c) >= 0x80;
+}
+
+// Find the design units of a source: “entity”, “architecture”, “package” and “configuration” starting a statement,
+// followed by the rest of their header. Comments, strings and character literals are skipped.
+// Each unit must start a line, otherwise the file is not split at all.
+QList<VhdlParser::UnitRange> VhdlParser::scanUnits(const QByteArray &source)
+{
+    struct Position {
+        qsizetype start;
+        quint32 offset;
+        unsigned int line;
+        bool lineStart;
+    };
+
+    const char *data = source.constData();
+    const qsizetype size = source.size();
+    qsizetype i = 0;
+    Position current { 0, 0, 1, true };
+    // Characters are counted as in a QString, with “\r\n” as a single character
+    const auto advance = [&]() {
+        const uchar c = data[i];
+        if (c == '\n')
+        {
+            current.offset += 1;
+            current.line += 1;
+            current.lineStart = true;
+        }
+        else if (c != '\r' || i + 1 >= size || data[i + 1] != '\n')
+            current.offset += ((c & 0xc0) == 0x80) ? 0 : (c >= 0xf0) ? 2 : 1;
+        i += 1;
+    };
+    const auto skipUntil = [&](char end) {
+        while (i < size && data[i] != end && data[i] != '\n')
+            advance();
+    };
+
+    // Next word in lower case or punctuation character, the position is the one of its first character
+    Position position;
+    const auto nextToken = [&]() -> QByteArray {
+        while (i < size)
+        {
+            const char c = data[i];
+            const char next = (i + 1 < size) ? data[i + 1] : '\0';
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v')
+            {
+                advance();
+                continue;
+            }
+            if (c == '-' && next == '-')
+            {
+                skipUntil('\n');
+                continue;
+            }
+            if (c == '/' && next == '*')
+            {
+                advance();
+                advance();
+                while (i < size && !(data[i] == '*' && i + 1 < size && data[i + 1] == '/'))
+                    advance();
+                if (i < size)
+                {
+                    advance();
+                    advance();
+                }
+                continue;
+            }
+
+            position = current;
+            position.start = i;
+            current.lineStart = false;
+            if (c == '"' || c == '\\')
+            {
+                // Strings and extended identifiers
+                advance();
+                skipUntil(c);
+                if (i < size && data[i] == c)
+                    advance();
+                return QByteArray(1, c);
+            }
+            if (c == '\'' && i + 2 < size && data[i + 2] == '\'' && (i == 0 || !isWordCharacter(data[i - 1])))
+            {
+                // Character literals, not attributes
+                advance();
+                advance();
+                advance();
+                return QByteArray(1, c);
+            }
+            if (isWordCharacter(c))
+            {
+                const qsizetype start = i;
+                while (i < size && isWordCharacter(data[i]))
+                    advance();
+                return QByteArray(data + start, i - start).toLower();
+            }
+            advance();
+            return QByteArray(1, c);
+        }
+        return QByteArray();
+    };
+
+    QList<UnitRange> units;
+    // Start of the context clause of the next unit
+    Position clause { -1, 0, 0, false };
+    bool statementStart = true;
+    for (QByteArray token = nextToken(); !token.isEmpty(); token = nextToken())
+    {
+        if (!statementStart || token == ";")
+        {
+            statementStart = (token == ";");
+            continue;
+        }
+        statementStart = false;
+        if (token == "library" || token == "use" || token == "context")
+        {
+            if (clause.start < 0)
+                clause = position;
+            continue;
+        }
+
+        const Position head = position;
+        QString group;
+        bool package = false;
+        if (token == "entity")
+        {
+            const QByteArray name = nextToken();
+            if (nextToken() == "is")
+                group = QString("entity:%1").arg(QString::fromUtf8(name));
+        }
+        else if (token == "architecture" || token == "configuration")
+        {
+            nextToken();
+            const QByteArray of = nextToken();
+            const QByteArray entity = nextToken();
+            if (of == "of" && nextToken() == "is")
+                group = QString("entity:%1").arg(QString::fromUtf8(entity));
+        }
+        else if (token == "package")
+        {
+            QByteArray name = nextToken();
+            if (name == "body")
+                name = nextToken();
+            package = true;
+            if (nextToken() == "is")
+                group = QString("package:%1").arg(QString::fromUtf8(name));
+        }
+        const Position start = (clause.start < 0) ? head : clause;
+        clause.start = -1;
+        if (group.isEmpty())
+            continue;
+        if (!start.lineStart)
+            return { };
+        units.append(UnitRange { start.start, start.offset, start.line, group, package });
+    }
+
+    // Whatever comes before the first unit is parsed with it
+    if (!units.isEmpty())
+    {
+        units.first().start = 0;
+        units.first().offset = 0;
+        units.first().line = 1;
+    }
+    return units;
+}
+
+// Units are parsed in batches by separate sessions: the packages first, in the order of the file, since the other units
+// may use them, then the entities with their architectures on all cores. Each session keeps its references, which
+// are merged into the design in the order of the file once all the units are parsed.
+bool VhdlParser::parseUnits(const QByteArray &source, const QList<UnitRange> &units)
+{
+    const QString filePath = _sourceFile.canonicalFilePath();
+    const FileId fileId = _design->addFile(filePath, _sourceFile.lastModified());
+
+    // Units of each group, in the order of their first unit
+    QHash<QString, int> groupIndexes;
+    QList<QList<int>> groups;
+    QList<QList<int>> packageGroups;
+    for (int i = 0; i < units.count(); ++i)
+    {
+        const UnitRange &unit = units.at(i);
+        QList<QList<int>> &list = unit.package ? packageGroups : groups;
+        const QString key = unit.group;
+        if (!groupIndexes.contains(key))
+        {
+            groupIndexes.insert(key, list.count());
+            list.append(QList<int>());
+        }
+        list[groupIndexes.value(key)].append(i);
+    }
+
+    // A few batches per core, so that the cores stay busy until the end
+    const int batchCount = std::min<int>(groups.count(), QThread::idealThreadCount() * 4);
+    Logger::info(tr("Parsing %1, %2 unit(s) in parallel").arg(filePath).arg(units.count()));
+    QMutex designLock;
+    QList<Session *> sessions;
+    const auto parseGroups = [&](Session *session, const QList<QList<int>> &list, int first, int last) {
+        for (int group = first; group < last; ++group)
+            for (int i : list.at(group))
+            {
+                const qsizetype end = (i + 1 < units.count()) ? units.at(i + 1).start : source.size();
+                session->seek(units.at(i).offset, units.at(i).line);
+                if (!session->write(QByteArray::fromRawData(source.constData() + units.at(i).start, end - units.at(i).start)) || !session->finish())
+                    return false;
+            }
+        return true;
+    };
+
+    sessions.append(new Session(_design, filePath, fileId, false, &designLock));
+    bool success = parseGroups(sessions.first(), packageGroups, 0, packageGroups.count());
+    if (success)
+    {
+        QList<bool> results(batchCount, true);
+        bool *data = results.data();
+        QThreadPool pool;
+        for (int batch = 0; batch < batchCount; ++batch)
+        {
+            Session *session = new Session(_design, filePath, fileId, false, &designLock);
+            sessions.append(session);
+            const int first = groups.count() * batch / batchCount;
+            const int last = groups.count() * (batch + 1) / batchCount;
+            pool.start([=, &groups] { data[batch] = parseGroups(session, groups, first, last); });
+        }
+        pool.waitForDone();
+        success = !results.contains(false);
+    }
+
+    // Merge the line offsets and the references of all the sessions
+    QList<quint32> lineOffsets;
+    QList<Reference> references;
+    CrossReferenceIndex &index = _design->references();
+    for (Session *session : sessions)
+    {
+        lineOffsets.append(session->lineOffsets);
+        for (Reference reference : session->localIndex.fileReferences(fileId))
+        {
+            reference.identifier = index.identifier(session->localIndex.identifierName(reference.identifier));
+            reference.scope = index.identifier(session->localIndex.identifierName(reference.scope));
+            references.append(reference);
+        }
+        delete session;
+    }
+    std::sort(lineOffsets.begin(), lineOffsets.end());
+    std::stable_sort(references.begin(), references.end(), [](const Reference &a, const Reference &b) { return a.location.offset < b.location.offset; });
+    for (const Reference &reference : references)
+        index.addReference(reference);
+    _design->setLineOffsets(fileId, lineOffsets);
+    return success;
+}
+
+/******************************************************************************/
+
+bool VhdlParser::begin()
+{
+    const QString filePath = _sourceFile.canonicalFilePath();
+    Logger::info(_netlist ? tr("Parsing %1 in netlist mode").arg(filePath) : tr("Parsing %1").arg(filePath));
+    delete _session;
+    _session = new Session(_design, filePath, _design->addFile(filePath, _sourceFile.lastModified()), _netlist);
+    if (_netlist && !_spillPath.isEmpty())
+        _session->spill.open(_spillPath);
+    return true;
+}
 
+bool VhdlParser::write(const QByteArray &chunk)
+{
+    if (_session == nullptr)
+        return false;
+    if (!_session->write(chunk))
+    {
+        delete _session;
+        _session = nullptr;
+        return false;
+    }
     return true;
 }
+
+bool VhdlParser::finish()
+{
+    if (_session == nullptr)
+        return false;
+
+    const bool success = _session->finish();
+    const bool spilled = _session->spill.isOpen() && _session->spill.close();
+    if (success && spilled)
+        _design->setSpillPath(_session->fileId, _spillPath);
+    delete _session;
+    _session = nullptr;
+    return success;
+}
+
+bool VhdlParser::parse()
+{
+    // Open the source file, or read the contents given instead
+    QFile sourceFile(_sourceFile.canonicalFilePath());
+    QBuffer buffer(&_contents);
+    QIODevice &file = _contents.isNull() ? static_cast<QIODevice &>(sourceFile) : buffer;
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        Logger::error(tr("Failed to open file: %1").arg(file.errorString()));
+        return false;
+    }
+
+    // Large files are split at their design units, unless they are netlists whose memory must stay bounded
+    if (!_netlist && file.size() >= PARALLEL_FILE_SIZE)
+    {
+        const QByteArray source = file.readAll();
+        const QList<UnitRange> units = scanUnits(source);
+        if (units.count() > 1)
+            return parseUnits(source, units);
+        begin();
+        return write(source) && finish();
+    }
+
+    begin();
+    while (!file.atEnd())
+        if (!write(file.read(CHUNK_SIZE)))
+            return false;
+    return finish();
+}
@@ -23,15 +23,43 @@ class VhdlParser : public QObject
 protected:
     enum class State;
     enum class Target;
+    enum class TokenClass;
+    enum class Action;
+    class TransitionTable;
     class Token;
+    class Session;
+    struct UnitRange;
 
     QFileInfo _sourceFile;
     Design *_design;
+    // Parsed instead of the file when it is not null
+    QByteArray _contents;
+    // Netlist mode, with the file receiving the detail of the netlist if any
+    bool _netlist;
+    QString _spillPath;
+    Session *_session;
+
+    static QList<UnitRange> scanUnits(const QByteArray &source);
+    bool parseUnits(const QByteArray &source, const QList<UnitRange> &units);
 
 public:
     VhdlParser(const QFileInfo &sourceFile, Design *design, QObject *parent = nullptr);
+    ~VhdlParser();
 
+    void setContents(const QByteArray &contents);
+    // Netlist mode keeps the memory bounded on multi-gigabyte netlists: signals and instances are only counted in the
+    // design, and their detail is written to the spill file instead when a path is given. The offsets of the lines
+    // are still kept, 4 bytes per line, so that locations resolve to lines and columns.
+    void setNetlistMode(bool enabled, const QString &spillPath = QString());
+    // Parse the file, or the contents given instead. Large files are split at their design units, which are parsed
+    // in parallel.
     bool parse();
+
+    // Push interface, for sources that are not files or that are not complete yet: the source is given in chunks
+    // of any size, the lines split between two chunks are parsed once complete. The file info only names the source.
+    bool begin();
+    bool write(const QByteArray &chunk);
+    bool finish();
 };
 
 /******************************************************************************/
@@ -5,9 +5,25 @@
 
 /******************************************************************************/
 
+#include "LanguageServer.h"
+#include "LibrarySummary.h"
 #include "MainWindow.h"
 
 #include <QApplication>
+#include <QDir>
+
+#include <iostream>
+
+/******************************************************************************/
+
+// Library summaries of LAMBILA_LIBRARY_PATH first, then the ones next to the executable, then the bundled ones
+static void loadLibraries()
+{
+    QStringList directories = qEnvironmentVariable("LAMBILA_LIBRARY_PATH").split(QDir::listSeparator(), Qt::SkipEmptyParts);
+    directories.append(QDir(QCoreApplication::applicationDirPath()).filePath("libraries"));
+    directories.append(":/libraries");
+    LibrarySummary::loadLibraries(directories);
+}
 
 /******************************************************************************/
 
@@ -15,8 +31,54 @@ int main(int argc, char *argv[])
 {
     QCoreApplication::setOrganizationName("lambila");
     QCoreApplication::setApplicationName("lambila");
+
+    // Language server without any UI: “lambila --lsp [project.lila] [--socket name]”
+    bool languageServer = false;
+    QString projectPath;
+    QString socketName;
+    QString exportPath;
+    for (int i = 1; i < argc; ++i)
+    {
+        const QString argument = QString::fromLocal8Bit(argv[i]);
+        if (argument == "--lsp")
+            languageServer = true;
+        else if (argument == "--socket" && i + 1 < argc)
+            socketName = QString::fromLocal8Bit(argv[++i]);
+        else if (argument == "--export" && i + 1 < argc)
+            exportPath = QString::fromLocal8Bit(argv[++i]);
+        else if (!argument.startsWith("--"))
+            projectPath = argument;
+    }
+    if (languageServer)
+    {
+        QCoreApplication a(argc, argv);
+        loadLibraries();
+        LanguageServer server(projectPath);
+        if (!(socketName.isEmpty() ? server.start() : server.listen(socketName)))
+            return 1;
+        return a.exec();
+    }
+
+    // Batch export without any UI: “lambila project.lila --export design.json|design.lbd|design.dot”
+    if (!exportPath.isEmpty())
+    {
+        QCoreApplication a(argc, argv);
+        loadLibraries();
+        QObject::connect(Logger::instance(), &Logger::logReceived, [](Logger::LogLevel logLevel, const QString &message) {
+            if (logLevel == Logger::LogLevel::Error)
+                std::cerr << qPrintable(message) << std::endl;
+        });
+        Project project;
+        if (!project.open(projectPath))
+            return 1;
+        QObject::connect(&project, &Project::refreshed, &a, [&] { a.exit(project.exportDesign(exportPath) ? 0 : 1); });
+        project.refresh();
+        return a.exec();
+    }
+
     QApplication::setStyle("Fusion");
     QApplication a(argc, argv);
+    loadLibraries();
     MainWindow w;
     w.show();
     return a.exec();
@@ -0,0 +1,47 @@
+/* Lambila | LibrarySummaryGenerator.cpp
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+// Build-time tool: parses the VHDL sources of a compiled library, such as the IEEE packages or the component
+// declarations of a vendor primitive library, and writes their summary.
+// Usage: librarysummary <library> <output.lib> <source.vhd>...
+// The summaries found in LAMBILA_LIBRARY_PATH are loaded first, so that a vendor library can use the IEEE types.
+
+#include "../src/LibrarySummary.h"
+#include "../src/VhdlParser.h"
+
+#include <QCoreApplication>
+#include <QDir>
+
+#include <iostream>
+
+/******************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    if (argc < 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " <library> <output.lib> <source.vhd>..." << std::endl;
+        return 1;
+    }
+    Logger::setVerbosity(Logger::LogLevel::Warning);
+    QObject::connect(Logger::instance(), &Logger::logReceived, [](Logger::LogLevel, const QString &message) { std::cerr << qPrintable(message) << std::endl; });
+    LibrarySummary::loadLibraries(qEnvironmentVariable("LAMBILA_LIBRARY_PATH").split(QDir::listSeparator(), Qt::SkipEmptyParts));
+
+    Design design;
+    for (int i = 3; i < argc; ++i)
+    {
+        const QFileInfo source(QString::fromLocal8Bit(argv[i]));
+        VhdlParser parser(source, &design);
+        if (!parser.parse())
+        {
+            std::cerr << "Failed to parse " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+    return LibrarySummary::write(&design, QString::fromLocal8Bit(argv[1]), QString::fromLocal8Bit(argv[2])) ? 0 : 1;
+}
@@ -0,0 +1,403 @@
+/* Lambila | VhdlGrammarGenerator.cpp
+ * Copyright (c) 2025 L. Sartory
+ * SPDX-License-Identifier: MIT
+ */
+
+/******************************************************************************/
+
+// Build-time tool: reads the VHDL EBNF grammar and generates a header with the
+// reserved words and the FIRST sets of the requested non-terminals.
+// Usage: VhdlGrammarGenerator <grammar.txt> <output.h> <non-terminal>...
+
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/******************************************************************************/
+
+typedef std::set<std::string> SymbolSet;
+
+// Lexical elements are handled by the tokenizer, so they are treated as terminals
+static const SymbolSet LEXICAL_ELEMENTS = {
+    "identifier",
+    "abstract_literal",
+    "character_literal",
+    "string_literal",
+    "bit_string_literal"
+};
+
+static const char KEYWORD_PREFIX[] = "kw:";
+
+/******************************************************************************/
+
+struct Node {
+    enum class Kind {
+        Terminal,
+        NonTerminal,
+        Sequence,
+        Alternative,
+        Optional,
+        Repetition
+    };
+
+    Kind kind;
+    std::string symbol;
+    std::vector<std::unique_ptr<Node>> children;
+
+    Node(Kind kind, const std::string &symbol = std::string()) : kind(kind), symbol(symbol) { }
+};
+
+/******************************************************************************/
+
+class Grammar {
+protected:
+    std::map<std::string, std::unique_ptr<Node>> _rules;
+    SymbolSet _keywords;
+
+    // Memoized results, computed once for all non-terminals
+    std::map<std::string, bool> _nullable;
+    std::map<std::string, SymbolSet> _first;
+
+public:
+    bool load(const std::string &filePath);
+
+    const SymbolSet &keywords() const
+    {
+        return _keywords;
+    }
+    bool hasRule(const std::string &name) const
+    {
+        return _rules.count(name) != 0;
+    }
+    const SymbolSet &first(const std::string &name) const
+    {
+        return _first.at(name);
+    }
+
+    void computeSets();
+
+protected:
+    static std::vector<std::string> tokenize(const std::string &text);
+    std::unique_ptr<Node> parseAlternative(const std::vector<std::string> &tokens, size_t &pos, const std::string &closing);
+    std::unique_ptr<Node> parseSequence(const std::vector<std::string> &tokens, size_t &pos, const std::string &closing);
+    void resolve(Node *node);
+
+    bool nullable(const Node *node) const;
+    SymbolSet first(const Node *node) const;
+};
+
+/******************************************************************************/
+
+std::vector<std::string> Grammar::tokenize(const std::string &text)
+{
+    // Words are runs of alphanumeric characters, everything else is grouped into symbols
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < text.size())
+    {
+        const unsigned char c = text[i];
+        if (std::isspace(c))
+        {
+            i += 1;
+            continue;
+        }
+        size_t j = i + 1;
+        if (std::isalnum(c) || c == '_')
+            while (j < text.size() && (std::isalnum(static_cast<unsigned char>(text[j])) || text[j] == '_'))
+                j += 1;
+        else if (c != '[' && c != ']' && c != '{' && c != '}' && c != '|' && c != '(' && c != ')')
+            while (j < text.size() && !std::isspace(static_cast<unsigned char>(text[j])) && !std::isalnum(static_cast<unsigned char>(text[j])) && std::string("[]{}|()_").find(text[j]) == std::string::npos)
+                j += 1;
+        tokens.push_back(text.substr(i, j - i));
+        i = j;
+    }
+    return tokens;
+}
+
+std::unique_ptr<Node> Grammar::parseAlternative(const std::vector<std::string> &tokens, size_t &pos, const std::string &closing)
+{
+    std::unique_ptr<Node> alternative(new Node(Node::Kind::Alternative));
+    alternative->children.push_back(parseSequence(tokens, pos, closing));
+    while (pos < tokens.size() && tokens[pos] == "|")
+    {
+        pos += 1;
+        alternative->children.push_back(parseSequence(tokens, pos, closing));
+    }
+    if (alternative->children.size() == 1)
+        return std::move(alternative->children.front());
+    return alternative;
+}
+
+std::unique_ptr<Node> Grammar::parseSequence(const std::vector<std::string> &tokens, size_t &pos, const std::string &closing)
+{
+    std::unique_ptr<Node> sequence(new Node(Node::Kind::Sequence));
+    while (pos < tokens.size() && tokens[pos] != closing)
+    {
+        const std::string &token = tokens[pos];
+
+        // A bar at the start of a sequence is a literal (as in “choices ::= choice { | choice }”)
+        if (token == "|" && !sequence->children.empty())
+            break;
+        pos += 1;
+
+        if (token == "[" || token == "{")
+        {
+            std::unique_ptr<Node> group(new Node(token == "[" ? Node::Kind::Optional : Node::Kind::Repetition));
+            group->children.push_back(parseAlternative(tokens, pos, token == "[" ? "]" : "}"));
+            pos += 1;
+            sequence->children.push_back(std::move(group));
+        }
+        else if (std::islower(static_cast<unsigned char>(token[0])))
+            sequence->children.emplace_back(new Node(Node::Kind::NonTerminal, token));
+        else if (token.size() > 1 && std::isupper(static_cast<unsigned char>(token[0])))
+        {
+            // Reserved words are written in upper case
+            std::string keyword;
+            for (const char c : token)
+                keyword += std::tolower(static_cast<unsigned char>(c));
+            _keywords.insert(keyword);
+            sequence->children.emplace_back(new Node(Node::Kind::Terminal, KEYWORD_PREFIX + keyword));
+        }
+        else
+            sequence->children.emplace_back(new Node(Node::Kind::Terminal, token));
+    }
+    return sequence;
+}
+
+bool Grammar::load(const std::string &filePath)
+{
+    std::ifstream file(filePath);
+    if (!file)
+        return false;
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        const size_t separator = line.find("::=");
+        if (separator == std::string::npos)
+            continue;
+        std::string name = line.substr(0, separator);
+        name.erase(name.find_last_not_of(" \t") + 1);
+        const std::vector<std::string> tokens = tokenize(line.substr(separator + 3));
+        size_t pos = 0;
+        _rules[name] = parseAlternative(tokens, pos, std::string());
+    }
+
+    for (auto &rule : _rules)
+        resolve(rule.second.get());
+    return !_rules.empty();
+}
+
+void Grammar::resolve(Node *node)
+{
+    for (auto &child : node->children)
+        resolve(child.get());
+    if (node->kind != Node::Kind::NonTerminal)
+        return;
+
+    // Lexical elements are terminals
+    if (LEXICAL_ELEMENTS.count(node->symbol) != 0)
+    {
+        node->kind = Node::Kind::Terminal;
+        return;
+    }
+
+    // Names such as “entity_name” or “boolean_expression” refer to the rule for their suffix
+    std::string name = node->symbol;
+    while (_rules.count(name) == 0)
+    {
+        const size_t underscore = name.find('_');
+        if (underscore == std::string::npos)
+        {
+            // Undefined character classes (letter, digit, …)
+            node->kind = Node::Kind::Terminal;
+            return;
+        }
+        name = name.substr(underscore + 1);
+        if (LEXICAL_ELEMENTS.count(name) != 0)
+        {
+            node->kind = Node::Kind::Terminal;
+            node->symbol = name;
+            return;
+        }
+    }
+    node->symbol = name;
+}
+
+/******************************************************************************/
+
+bool Grammar::nullable(const Node *node) const
+{
+    switch (node->kind)
+    {
+    case Node::Kind::Terminal:
+        return false;
+    case Node::Kind::NonTerminal:
+    {
+        const auto it = _nullable.find(node->symbol);
+        return it != _nullable.end() && it->second;
+    }
+    case Node::Kind::Sequence:
+        for (const auto &child : node->children)
+            if (!nullable(child.get()))
+                return false;
+        return true;
+    case Node::Kind::Alternative:
+        for (const auto &child : node->children)
+            if (nullable(child.get()))
+                return true;
+        return false;
+    case Node::Kind::Optional:
+    case Node::Kind::Repetition:
+        return true;
+    }
+    return false;
+}
+
+SymbolSet Grammar::first(const Node *node) const
+{
+    SymbolSet result;
+    switch (node->kind)
+    {
+    case Node::Kind::Terminal:
+        result.insert(node->symbol);
+        break;
+    case Node::Kind::NonTerminal:
+    {
+        const auto it = _first.find(node->symbol);
+        if (it != _first.end())
+            result = it->second;
+        break;
+    }
+    case Node::Kind::Sequence:
+        for (const auto &child : node->children)
+        {
+            const SymbolSet childFirst = first(child.get());
+            result.insert(childFirst.begin(), childFirst.end());
+            if (!nullable(child.get()))
+                break;
+        }
+        break;
+    case Node::Kind::Alternative:
+    case Node::Kind::Optional:
+    case Node::Kind::Repetition:
+        for (const auto &child : node->children)
+        {
+            const SymbolSet childFirst = first(child.get());
+            result.insert(childFirst.begin(), childFirst.end());
+        }
+        break;
+    }
+    return result;
+}
+
+void Grammar::computeSets()
+{
+    // Iterate until a fixed point is reached, which also handles left-recursive rules
+    for (bool changed = true; changed; )
+    {
+        changed = false;
+        for (const auto &rule : _rules)
+        {
+            const bool isNullable = nullable(rule.second.get());
+            if (isNullable != _nullable[rule.first])
+            {
+                _nullable[rule.first] = isNullable;
+                changed = true;
+            }
+            const SymbolSet ruleFirst = first(rule.second.get());
+            SymbolSet &target = _first[rule.first];
+            if (ruleFirst.size() != target.size())
+            {
+                target = ruleFirst;
+                changed = true;
+            }
+        }
+    }
+}
+
+/******************************************************************************/
+
+static std::string identifierFor(const std::string &keyword)
+{
+    std::string result = keyword;
+    result[0] = std::toupper(static_cast<unsigned char>(result[0]));
+    return result;
+}
+
+static std::string macroFor(const std::string &prefix, const std::string &name)
+{
+    std::string result = prefix;
+    for (const char c : name)
+        result += std::toupper(static_cast<unsigned char>(c));
+    return result;
+}
+
+static void writeSet(std::ostream &out, const std::string &macro, const SymbolSet &symbols)
+{
+    // Only reserved words are exported, other terminals are classified by the tokenizer
+    out << "#define " << macro << "(X)";
+    for (const std::string &symbol : symbols)
+        if (symbol.compare(0, sizeof(KEYWORD_PREFIX) - 1, KEYWORD_PREFIX) == 0)
+            out << " \\\n    X(" << identifierFor(symbol.substr(sizeof(KEYWORD_PREFIX) - 1)) << ")";
+    out << "\n\n";
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <grammar.txt> <output.h> <non-terminal>..." << std::endl;
+        return 1;
+    }
+
+    Grammar grammar;
+    if (!grammar.load(argv[1]))
+    {
+        std::cerr << "Failed to load grammar: " << argv[1] << std::endl;
+        return 1;
+    }
+    grammar.computeSets();
+
+    std::ostringstream out;
+    out << "/* Lambila | _VhdlGrammar.h\n"
+           " * Generated by VhdlGrammarGenerator from the VHDL-93 EBNF, do not edit\n"
+           " */\n\n"
+           "#ifndef _VHDLGRAMMAR_H\n"
+           "#define _VHDLGRAMMAR_H\n\n";
+
+    // Reserved words, sorted so that they can be looked up with a binary search
+    out << "#define VHDL_KEYWORDS(X)";
+    for (const std::string &keyword : grammar.keywords())
+        out << " \\\n    X(" << identifierFor(keyword) << ", \"" << keyword << "\")";
+    out << "\n\n";
+
+    for (int i = 3; i < argc; ++i)
+    {
+        if (!grammar.hasRule(argv[i]))
+        {
+            std::cerr << "Unknown non-terminal: " << argv[i] << std::endl;
+            return 1;
+        }
+        writeSet(out, macroFor("VHDL_FIRST_", argv[i]), grammar.first(argv[i]));
+    }
+    out << "#endif // _VHDLGRAMMAR_H\n";
+
+    // Only touch the output when it changed, to avoid needless rebuilds
+    {
+        std::ifstream previous(argv[2]);
+        std::stringstream content;
+        content << previous.rdbuf();
+        if (previous && content.str() == out.str())
+            return 0;
+    }
+    std::ofstream file(argv[2]);
+    file << out.str();
+    return file ? 0 : 1;
+}